@@ -9,6 +9,7 @@
 #include <cstring>
 
 #include "appfat.h"
+#include "codec.h"
 #include "sha.h"
 #include "utils/endian.hpp"
 #include "utils/stdcompat/cstddef.hpp"
@@ -23,6 +24,8 @@ struct CodecSignature {
 	uint16_t unused;
 };
 
+static_assert(sizeof(CodecSignature) == CodecSignatureSize, "CodecSignatureSize must match the signature layout");
+
 // https://stackoverflow.com/a/45172360 - helper to make up for not having an implicit initializer for std::byte
 template <typename... Ts>
 std::array<byte, sizeof...(Ts)> make_bytes(Ts &&...args) noexcept
@@ -30,7 +33,24 @@ std::array<byte, sizeof...(Ts)> make_bytes(Ts &&...args) noexcept
 	return { byte(std::forward<Ts>(args))... };
 }
 
-void CodecInitKey(const char *pszPassword)
+/**
+ * @brief XORs a block with the digest repeated over its length, one word at a time.
+ *
+ * SHA1HashSize is a multiple of the word size, so byte j of the block meets digest byte j % SHA1HashSize.
+ */
+void XorBlock(byte block[BlockSize], const byte digest[SHA1HashSize])
+{
+	uint32_t key[SHA1HashSize / sizeof(uint32_t)];
+	memcpy(key, digest, sizeof(key));
+	for (std::size_t i = 0; i < BlockSize / sizeof(uint32_t); i++) {
+		uint32_t word;
+		memcpy(&word, &block[i * sizeof(uint32_t)], sizeof(word));
+		word ^= key[i % (SHA1HashSize / sizeof(uint32_t))];
+		memcpy(&block[i * sizeof(uint32_t)], &word, sizeof(word));
+	}
+}
+
+SHA1Context CodecInitKey(const char *pszPassword)
 {
 	byte pw[BlockSize]; // Repeat password until 64 char long
 	std::size_t j = 0;
@@ -40,10 +60,11 @@ void CodecInitKey(const char *pszPassword)
 		pw[i] = static_cast<byte>(pszPassword[j]);
 	}
 
+	SHA1Context context;
+	SHA1Reset(context);
+	SHA1Calculate(context, pw);
 	byte digest[SHA1HashSize];
-	SHA1Reset(0);
-	SHA1Calculate(0, pw, digest);
-	SHA1Clear();
+	SHA1Result(context, digest);
 
 	// declaring key as a std::array to make the initialization easier, otherwise we would need to explicitly
 	// declare every value as a byte on platforms that use std::byte.
@@ -58,54 +79,69 @@ void CodecInitKey(const char *pszPassword)
 		key[i] ^= digest[(i + 12) % SHA1HashSize];
 	memset(pw, 0, sizeof(pw));
 	memset(digest, 0, sizeof(digest));
-	for (int n = 0; n < 3; ++n) {
-		SHA1Reset(n);
-		SHA1Calculate(n, key.data(), nullptr);
-	}
+	SHA1Reset(context);
+	SHA1Calculate(context, key.data());
 	memset(key.data(), 0, sizeof(key));
+	return context;
 }
 } // namespace
 
-std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPassword)
+CodecDecoder::CodecDecoder(const char *pszPassword)
+    : context_(CodecInitKey(pszPassword))
+{
+}
+
+CodecDecoder::~CodecDecoder()
+{
+	memset(&context_, 0, sizeof(context_));
+}
+
+void CodecDecoder::Decode(byte *pbSrcDst, std::size_t size)
 {
 	byte buf[BlockSize];
 	byte dst[SHA1HashSize];
 
-	CodecInitKey(pszPassword);
-	if (size <= sizeof(CodecSignature))
-		return 0;
-	size -= sizeof(CodecSignature);
-	if (size % BlockSize != 0)
-		return 0;
 	for (auto i = size; i != 0; pbSrcDst += BlockSize, i -= BlockSize) {
 		memcpy(buf, pbSrcDst, BlockSize);
-		SHA1Result(0, dst);
-		for (unsigned j = 0; j < BlockSize; j++) {
-			buf[j] ^= dst[j % SHA1HashSize];
-		}
-		SHA1Calculate(0, buf, nullptr);
-		memset(dst, 0, sizeof(dst));
+		SHA1Result(context_, dst);
+		XorBlock(buf, dst);
+		SHA1Calculate(context_, buf);
 		memcpy(pbSrcDst, buf, BlockSize);
 	}
 
 	memset(buf, 0, sizeof(buf));
-	auto *sig = reinterpret_cast<CodecSignature *>(pbSrcDst);
-	if (sig->error > 0) {
-		goto error;
-	}
+	memset(dst, 0, sizeof(dst));
+}
 
-	SHA1Result(0, dst);
-	if (sig->checksum != *reinterpret_cast<uint32_t *>(dst)) {
-		memset(dst, 0, sizeof(dst));
-		goto error;
-	}
+std::size_t CodecDecoder::Finish(const byte *signature, std::size_t decodedSize)
+{
+	CodecSignature sig;
+	memcpy(&sig, signature, sizeof(sig));
+	if (sig.error > 0 || decodedSize == 0)
+		return 0;
+
+	byte dst[SHA1HashSize];
+	SHA1Result(context_, dst);
+	uint32_t checksum;
+	memcpy(&checksum, dst, sizeof(checksum));
+	memset(dst, 0, sizeof(dst));
+	if (sig.checksum != checksum)
+		return 0;
+
+	return decodedSize + sig.lastChunkSize - BlockSize;
+}
+
+std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPassword)
+{
+	CodecDecoder decoder(pszPassword);
+	if (size <= sizeof(CodecSignature))
+		return 0;
+	size -= sizeof(CodecSignature);
+	if (size % BlockSize != 0)
+		return 0;
 
-	size += sig->lastChunkSize - BlockSize;
-	SHA1Clear();
-	return size;
-error:
-	SHA1Clear();
-	return 0;
+	decoder.Decode(pbSrcDst, size);
+	return decoder.Finish(pbSrcDst + size, size);
 }
 
 std::size_t codec_get_encoded_len(std::size_t dwSrcBytes)
@@ -123,7 +159,7 @@ void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size64, const ch
 
 	if (size64 != codec_get_encoded_len(size))
 		app_fatal("Invalid encode parameters");
-	CodecInitKey(pszPassword);
+	SHA1Context context = CodecInitKey(pszPassword);
 
 	size_t lastChunk = 0;
 	while (size != 0) {
@@ -131,25 +167,23 @@ void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size64, const ch
 		memcpy(buf, pbSrcDst, chunk);
 		if (chunk < BlockSize)
 			memset(buf + chunk, 0, BlockSize - chunk);
-		SHA1Result(0, dst);
-		SHA1Calculate(0, buf, nullptr);
-		for (unsigned j = 0; j < BlockSize; j++) {
-			buf[j] ^= dst[j % SHA1HashSize];
-		}
-		memset(dst, 0, sizeof(dst));
+		SHA1Result(context, dst);
+		SHA1Calculate(context, buf);
+		XorBlock(buf, dst);
 		memcpy(pbSrcDst, buf, BlockSize);
 		lastChunk = chunk;
 		pbSrcDst += BlockSize;
 		size -= chunk;
 	}
 	memset(buf, 0, sizeof(buf));
-	SHA1Result(0, tmp);
+	memset(dst, 0, sizeof(dst));
+	SHA1Result(context, tmp);
 	auto *sig = reinterpret_cast<CodecSignature *>(pbSrcDst);
 	sig->error = 0;
 	sig->unused = 0;
 	sig->checksum = *reinterpret_cast<uint32_t *>(tmp);
 	sig->lastChunkSize = static_cast<uint8_t>(lastChunk); // lastChunk is at most 64 so will always fit in an 8 bit var
-	SHA1Clear();
+	memset(tmp, 0, sizeof(tmp));
 }
 
 } // namespace devilution
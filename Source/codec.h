@@ -5,10 +5,39 @@
  */
 #pragma once
 
+#include "sha.h"
 #include "utils/stdcompat/cstddef.hpp"
 
 namespace devilution {
 
+/** Size of the signature codec_encode appends after the encoded blocks */
+constexpr std::size_t CodecSignatureSize = 8;
+
+/**
+ * @brief Decodes the output of codec_encode in pieces, so the start of a file can be used while the rest is still being read.
+ */
+class CodecDecoder {
+public:
+	explicit CodecDecoder(const char *pszPassword);
+	~CodecDecoder();
+
+	/**
+	 * @brief Decodes the next size bytes in place.
+	 * @param size A multiple of BlockSize, not counting the signature
+	 */
+	void Decode(byte *pbSrcDst, std::size_t size);
+
+	/**
+	 * @brief Checks the signature that follows the decoded blocks.
+	 * @param decodedSize Total number of bytes passed to Decode
+	 * @return Length of the plain data, or 0 if the signature does not match
+	 */
+	std::size_t Finish(const byte *signature, std::size_t decodedSize);
+
+private:
+	SHA1Context context_;
+};
+
 std::size_t codec_decode(byte *pbSrcDst, std::size_t size, const char *pszPassword);
 std::size_t codec_get_encoded_len(std::size_t dwSrcBytes);
 void codec_encode(byte *pbSrcDst, std::size_t size, std::size_t size_64, const char *pszPassword);
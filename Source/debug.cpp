@@ -22,6 +22,7 @@
 #include "lighting.h"
 #include "monstdat.h"
 #include "monster.h"
+#include "netstats.h"
 #include "quests.h"
 #include "setmaps.h"
 #include "spells.h"
@@ -734,6 +735,26 @@ std::string DebugCmdToggleFPS(const string_view parameter)
 	return "";
 }
 
+std::string DebugCmdNetStats(const string_view parameter)
+{
+	return netstats::Report();
+}
+
+std::string DebugCmdNetCapture(const string_view parameter)
+{
+	if (parameter.empty()) {
+		if (!netstats::IsCapturing())
+			return "No network capture in progress.";
+		netstats::StopCapture();
+		return "Network capture stopped.";
+	}
+
+	std::string path(parameter.data(), parameter.size());
+	if (!netstats::StartCapture(path))
+		return fmt::format("Failed to create {}.", path);
+	return fmt::format("Capturing network traffic to {}.", path);
+}
+
 std::vector<DebugCmdItem> DebugCmdList = {
 	{ "help", "Prints help overview or help for a specific command.", "({command})", &DebugCmdHelp },
 	{ "give gold", "Fills the inventory with gold.", "", &DebugCmdGiveGoldCheat },
@@ -765,6 +786,8 @@ std::vector<DebugCmdItem> DebugCmdList = {
 	{ "questinfo", "Shows info of quests.", "{id}", &DebugCmdQuestInfo },
 	{ "playerinfo", "Shows info of player.", "{playerid}", &DebugCmdPlayerInfo },
 	{ "fps", "Toggles displaying FPS", "", &DebugCmdToggleFPS },
+	{ "netstats", "Shows network traffic since the last time it was shown.", "", &DebugCmdNetStats },
+	{ "netcapture", "Records network traffic to {file} (leave file empty to stop).", "({file})", &DebugCmdNetCapture },
 };
 
 } // namespace
@@ -47,6 +47,7 @@
 #include "missiles.h"
 #include "movie.h"
 #include "multi.h"
+#include "netstats.h"
 #include "nthread.h"
 #include "objects.h"
 #include "options.h"
@@ -794,6 +795,8 @@ void RunGameLoop(interface_mode uMsg)
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--record <#>", _("Record a demo file"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--demo <#>", _("Play a demo file"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--timedemo", _("Disable all frame limiting during demo playback"));
+	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--net-capture <file>", _("Record network traffic to a file"));
+	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--net-replay <file>", _("Replay recorded network traffic in a single player game"));
 	printInConsole("%s", _(/* TRANSLATORS: Commandline Option */ "\nGame selection:\n"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--spawn", _("Force Shareware mode"));
 	printInConsole("    %-20s %-30s\n", /* TRANSLATORS: Commandline Option */ "--diablo", _("Force Diablo mode"));
@@ -835,6 +838,10 @@ void DiabloParseFlags(int argc, char **argv)
 			timedemo = true;
 		} else if (strcasecmp("--record", argv[i]) == 0) {
 			recordNumber = SDL_atoi(argv[++i]);
+		} else if (strcasecmp("--net-capture", argv[i]) == 0) {
+			netstats::StartCapture(argv[++i]);
+		} else if (strcasecmp("--net-replay", argv[i]) == 0) {
+			netstats::SetReplayPath(argv[++i]);
 		} else if (strcasecmp("--config-dir", argv[i]) == 0) {
 			paths::SetConfigPath(argv[++i]);
 		} else if (strcasecmp("-n", argv[i]) == 0) {
@@ -2087,6 +2094,7 @@ void game_loop(bool bStartup)
 		}
 		TimeoutCursor(false);
 		GameLogic();
+		DvlNet_Flush();
 
 		if (!gbRunGame || !gbIsMultiplayer || demo::IsRunning() || demo::IsRecording() || !nthread_has_500ms_passed())
 			break;
@@ -4,55 +4,107 @@
  * Implementation of functions for updating game state from network commands.
  */
 
-#include <list>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
 #include <mutex>
+#include <vector>
 
 #include "nthread.h"
-#include "utils/sdl_cond.h"
+#include "utils/mpsc_queue.hpp"
+#include "utils/sdl_mutex.h"
+#include "utils/sdl_sem.h"
 #include "utils/sdl_thread.h"
+#include "utils/stdcompat/optional.hpp"
 
 namespace devilution {
 
 struct DThreadPkt {
 	int pnum;
 	_cmd_id cmd;
-	std::unique_ptr<byte[]> data;
-	uint32_t len;
-
-	DThreadPkt(int pnum, _cmd_id(cmd), std::unique_ptr<byte[]> data, uint32_t len)
-	    : pnum(pnum)
-	    , cmd(cmd)
-	    , data(std::move(data))
-	    , len(len)
-	{
-	}
+	/** Value of PlayerGeneration[pnum] when queued, the packet is dropped if the player has left since */
+	uint32_t generation;
+	std::vector<byte> data;
 };
 
 namespace {
 
-std::optional<SdlMutex> DthreadMutex;
-std::list<DThreadPkt> InfoList;
-bool DthreadRunning;
-std::optional<SdlCond> WorkToDo;
+/** Enough for the deltas of several players joining at once */
+constexpr size_t MaxQueuedPackets = 128;
+/** Deltas are paced to about 500 KiB/s so a join does not crowd out the game's own traffic */
+constexpr uint32_t DeltaBytesPerMs = 512;
+constexpr uint32_t MaxDeltaBurst = 64 * 1024;
+
+std::optional<MpscQueue<DThreadPkt, MaxQueuedPackets>> InfoQueue;
+std::array<std::atomic<uint32_t>, MAX_PLRS> PlayerGeneration;
+std::atomic<bool> DthreadRunning;
+std::optional<SdlSem> WorkToDo;
+/**
+ * Packets that did not fit in InfoQueue, they are newer than all packets in it. While there are any,
+ * new packets are added here too, and the handler moves them to InfoQueue as slots free up.
+ */
+std::deque<DThreadPkt> Overflow;
+std::optional<SdlMutex> OverflowMutex;
+/** Set by the main thread when it adds to Overflow, cleared by the handler once Overflow is empty */
+std::atomic<bool> Overflowing;
 
 /* rdata */
 SdlThread Thread;
 
+/** Bytes that can be sent right away, refilled at DeltaBytesPerMs up to MaxDeltaBurst */
+uint32_t SendBudget;
+uint32_t LastRefill;
+
+void RefillSendBudget()
+{
+	uint32_t now = SDL_GetTicks();
+	SendBudget = std::min<uint64_t>(SendBudget + static_cast<uint64_t>(now - LastRefill) * DeltaBytesPerMs, MaxDeltaBurst);
+	LastRefill = now;
+}
+
+/** @brief Waits until len bytes may be sent, packets larger than a burst wait for a full budget. */
+void PaceSend(uint32_t len)
+{
+	uint32_t needed = std::min(len, MaxDeltaBurst);
+	RefillSendBudget();
+	while (SendBudget < needed && DthreadRunning) {
+		SDL_Delay((needed - SendBudget) / DeltaBytesPerMs + 1);
+		RefillSendBudget();
+	}
+	SendBudget -= std::min(needed, SendBudget);
+}
+
+void SendQueuedPacket(DThreadPkt &pkt)
+{
+	if (!DthreadRunning || pkt.generation != PlayerGeneration[pkt.pnum])
+		return;
+	PaceSend(pkt.data.size());
+	multi_send_zero_packet(pkt.pnum, pkt.cmd, pkt.data.data(), pkt.data.size());
+}
+
+void MoveOverflowToQueue()
+{
+	if (!Overflowing)
+		return;
+	std::lock_guard<SdlMutex> lock(*OverflowMutex);
+	while (!Overflow.empty() && InfoQueue->TryPush([](DThreadPkt &pkt) { pkt = std::move(Overflow.front()); }))
+		Overflow.pop_front();
+	if (Overflow.empty())
+		Overflowing = false;
+}
+
 void DthreadHandler()
 {
-	std::lock_guard<SdlMutex> lock(*DthreadMutex);
+	SendBudget = MaxDeltaBurst;
+	LastRefill = SDL_GetTicks();
 	while (true) {
-		while (!InfoList.empty()) {
-			DThreadPkt pkt = std::move(InfoList.front());
-			InfoList.pop_front();
-
-			DthreadMutex->unlock();
-			multi_send_zero_packet(pkt.pnum, pkt.cmd, pkt.data.get(), pkt.len);
-			DthreadMutex->lock();
-		}
+		do {
+			MoveOverflowToQueue();
+		} while (InfoQueue->TryPop(SendQueuedPacket));
 		if (!DthreadRunning)
 			return;
-		WorkToDo->wait(*DthreadMutex);
+		WorkToDo->wait();
 	}
 }
 
@@ -60,22 +112,28 @@ void DthreadHandler()
 
 void dthread_remove_player(uint8_t pnum)
 {
-	std::lock_guard<SdlMutex> lock(*DthreadMutex);
-	InfoList.remove_if([&](auto &pkt) {
-		return pkt.pnum == pnum;
-	});
+	PlayerGeneration[pnum]++;
 }
 
-void dthread_send_delta(int pnum, _cmd_id cmd, std::unique_ptr<byte[]> data, uint32_t len)
+void dthread_send_delta(int pnum, _cmd_id cmd, const byte *data, uint32_t len)
 {
 	if (!gbIsMultiplayer)
 		return;
 
-	DThreadPkt pkt { pnum, cmd, std::move(data), len };
-
-	std::lock_guard<SdlMutex> lock(*DthreadMutex);
-	InfoList.push_back(std::move(pkt));
-	WorkToDo->signal();
+	auto fill = [&](DThreadPkt &pkt) {
+		pkt.pnum = pnum;
+		pkt.cmd = cmd;
+		pkt.generation = PlayerGeneration[pnum];
+		pkt.data.assign(data, data + len);
+	};
+	// Only full while several players join at once, the main thread must not wait for the handler then
+	if (Overflowing || !InfoQueue->TryPush(fill)) {
+		std::lock_guard<SdlMutex> lock(*OverflowMutex);
+		Overflow.emplace_back();
+		fill(Overflow.back());
+		Overflowing = true;
+	}
+	WorkToDo->post();
 }
 
 void dthread_start()
@@ -84,8 +142,9 @@ void dthread_start()
 		return;
 
 	DthreadRunning = true;
-	DthreadMutex.emplace();
+	InfoQueue.emplace();
 	WorkToDo.emplace();
+	OverflowMutex.emplace();
 	Thread = SdlThread { DthreadHandler };
 }
 
@@ -94,16 +153,16 @@ void DThreadCleanup()
 	if (!DthreadRunning)
 		return;
 
-	{
-		std::lock_guard<SdlMutex> lock(*DthreadMutex);
-		DthreadRunning = false;
-		InfoList.clear();
-		WorkToDo->signal();
-	}
+	// Whatever is still queued is dropped by the handler on its way out
+	DthreadRunning = false;
+	WorkToDo->post();
 
 	Thread.join();
-	DthreadMutex = std::nullopt;
+	InfoQueue = std::nullopt;
 	WorkToDo = std::nullopt;
+	Overflow.clear();
+	Overflowing = false;
+	OverflowMutex = std::nullopt;
 }
 
 } // namespace devilution
@@ -12,7 +12,12 @@
 namespace devilution {
 
 void dthread_remove_player(uint8_t pnum);
-void dthread_send_delta(int pnum, _cmd_id cmd, std::unique_ptr<byte[]> data, uint32_t len);
+/**
+ * @brief Queues data to be sent to a player by the delta thread, which paces what it sends.
+ *
+ * The data is copied, so the caller keeps ownership.
+ */
+void dthread_send_delta(int pnum, _cmd_id cmd, const byte *data, uint32_t len);
 void dthread_start();
 void DThreadCleanup();
 
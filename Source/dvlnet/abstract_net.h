@@ -56,6 +56,15 @@ public:
 	{
 	}
 
+	/**
+	 * @brief Sends everything queued since the last flush.
+	 *
+	 * Backends that coalesce outgoing packets hold them until this is called.
+	 */
+	virtual void flush()
+	{
+	}
+
 	virtual std::vector<std::string> get_gamelist()
 	{
 		return std::vector<std::string>();
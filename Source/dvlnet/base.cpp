@@ -4,6 +4,8 @@
 #include <cstring>
 #include <memory>
 
+#include "netstats.h"
+
 namespace devilution {
 namespace net {
 
@@ -73,6 +75,7 @@ void base::RecvLocal(packet &pkt)
 	if (pkt.Source() < MAX_PLRS) {
 		connected_table[pkt.Source()] = true;
 	}
+	netstats::CountPacket(netstats::Direction::Received, pkt.Type(), pkt.Data().size());
 	switch (pkt.Type()) {
 	case PT_MESSAGE:
 		message_queue.emplace_back(pkt.Source(), pkt.Message());
@@ -7,6 +7,7 @@
 
 #include "dvlnet/base.h"
 #include "dvlnet/packet.h"
+#include "netstats.h"
 #include "player.h"
 #include "utils/log.hpp"
 
@@ -152,6 +153,7 @@ void base_protocol<P>::poll()
 template <class P>
 void base_protocol<P>::send(packet &pkt)
 {
+	netstats::CountPacket(netstats::Direction::Sent, pkt.Type(), pkt.Data().size());
 	if (pkt.Destination() < MAX_PLRS) {
 		if (pkt.Destination() == MyPlayerId)
 			return;
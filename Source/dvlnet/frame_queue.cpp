@@ -7,39 +7,36 @@
 namespace devilution {
 namespace net {
 
-framesize_t frame_queue::Size() const
+size_t frame_queue::Size() const
 {
-	return current_size;
+	return write_pos - read_pos;
 }
 
-buffer_t frame_queue::Read(framesize_t s)
+unsigned char *frame_queue::Reserve(size_t size)
 {
-	if (current_size < s)
-		throw frame_queue_exception();
-	buffer_t ret;
-	while (s > 0 && s >= buffer_deque.front().size()) {
-		s -= buffer_deque.front().size();
-		current_size -= buffer_deque.front().size();
-		ret.insert(ret.end(),
-		    buffer_deque.front().begin(),
-		    buffer_deque.front().end());
-		buffer_deque.pop_front();
+	if (buffer.size() - write_pos < size) {
+		if (read_pos != 0) {
+			std::memmove(buffer.data(), buffer.data() + read_pos, Size());
+			write_pos -= read_pos;
+			read_pos = 0;
+		}
+		if (buffer.size() - write_pos < size)
+			buffer.resize(write_pos + size);
 	}
-	if (s > 0) {
-		ret.insert(ret.end(),
-		    buffer_deque.front().begin(),
-		    buffer_deque.front().begin() + s);
-		buffer_deque.front().erase(buffer_deque.front().begin(),
-		    buffer_deque.front().begin() + s);
-		current_size -= s;
-	}
-	return ret;
+	return &buffer[write_pos];
 }
 
-void frame_queue::Write(buffer_t buf)
+void frame_queue::Commit(size_t size)
 {
-	current_size += buf.size();
-	buffer_deque.push_back(std::move(buf));
+	if (buffer.size() - write_pos < size)
+		throw frame_queue_exception();
+	write_pos += size;
+}
+
+void frame_queue::Write(const unsigned char *data, size_t size)
+{
+	std::memcpy(Reserve(size), data, size);
+	Commit(size);
 }
 
 bool frame_queue::PacketReady()
@@ -47,19 +44,20 @@ bool frame_queue::PacketReady()
 	if (nextsize == 0) {
 		if (Size() < sizeof(framesize_t))
 			return false;
-		auto szbuf = Read(sizeof(framesize_t));
-		std::memcpy(&nextsize, &szbuf[0], sizeof(framesize_t));
-		if (nextsize == 0)
+		std::memcpy(&nextsize, &buffer[read_pos], sizeof(framesize_t));
+		read_pos += sizeof(framesize_t);
+		if (nextsize == 0 || nextsize > max_frame_size)
 			throw frame_queue_exception();
 	}
 	return Size() >= nextsize;
 }
 
-buffer_t frame_queue::ReadPacket()
+frame_view frame_queue::ReadPacket()
 {
 	if (nextsize == 0 || Size() < nextsize)
 		throw frame_queue_exception();
-	auto ret = Read(nextsize);
+	frame_view ret { &buffer[read_pos], nextsize };
+	read_pos += nextsize;
 	nextsize = 0;
 	return ret;
 }
@@ -67,12 +65,18 @@ buffer_t frame_queue::ReadPacket()
 buffer_t frame_queue::MakeFrame(buffer_t packetbuf)
 {
 	buffer_t ret;
+	ret.reserve(sizeof(framesize_t) + packetbuf.size());
+	AppendFrame(ret, packetbuf);
+	return ret;
+}
+
+void frame_queue::AppendFrame(buffer_t &out, const buffer_t &packetbuf)
+{
 	if (packetbuf.size() > max_frame_size)
 		ABORT();
 	framesize_t size = packetbuf.size();
-	ret.insert(ret.end(), packet_out::begin(size), packet_out::end(size));
-	ret.insert(ret.end(), packetbuf.begin(), packetbuf.end());
-	return ret;
+	out.insert(out.end(), packet_out::begin(size), packet_out::end(size));
+	out.insert(out.end(), packetbuf.begin(), packetbuf.end());
 }
 
 } // namespace net
@@ -1,7 +1,7 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <deque>
 #include <exception>
 #include <vector>
 
@@ -20,24 +20,60 @@ public:
 
 typedef uint32_t framesize_t;
 
+/**
+ * @brief A complete frame inside a frame_queue.
+ *
+ * Only valid until the queue is next written to.
+ */
+struct frame_view {
+	const unsigned char *data;
+	framesize_t size;
+
+	const unsigned char *begin() const
+	{
+		return data;
+	}
+
+	const unsigned char *end() const
+	{
+		return data + size;
+	}
+};
+
+/**
+ * @brief Splits a stream of length-prefixed frames.
+ *
+ * Data is received straight into one contiguous buffer, and frames are read in place.
+ * Consumed bytes are only moved when there is no room left at the end of the buffer.
+ */
 class frame_queue {
 public:
 	constexpr static framesize_t max_frame_size = 0xFFFF;
 
 private:
-	framesize_t current_size = 0;
-	std::deque<buffer_t> buffer_deque;
+	buffer_t buffer;
+	size_t read_pos = 0;
+	size_t write_pos = 0;
 	framesize_t nextsize = 0;
 
-	framesize_t Size() const;
-	buffer_t Read(framesize_t s);
+	size_t Size() const;
 
 public:
+	/**
+	 * @brief Returns room for at least size bytes at the end of the queue.
+	 *
+	 * Invalidates frames previously returned by ReadPacket. Call Commit with the number of bytes actually written.
+	 */
+	unsigned char *Reserve(size_t size);
+	void Commit(size_t size);
+	void Write(const unsigned char *data, size_t size);
+
 	bool PacketReady();
-	buffer_t ReadPacket();
-	void Write(buffer_t buf);
+	frame_view ReadPacket();
 
 	static buffer_t MakeFrame(buffer_t packetbuf);
+	/** @brief Appends packetbuf to out as a length-prefixed frame. */
+	static void AppendFrame(buffer_t &out, const buffer_t &packetbuf);
 };
 
 } // namespace net
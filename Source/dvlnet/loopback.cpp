@@ -1,5 +1,9 @@
 #include "dvlnet/loopback.h"
 
+#include <algorithm>
+
+#include <SDL.h>
+
 #include "multi.h"
 #include "utils/language.h"
 #include "utils/stubs.h"
@@ -9,6 +13,14 @@ namespace net {
 
 int loopback::create(std::string /*addrstr*/)
 {
+	replay_queue.clear();
+	if (!netstats::ReplayPath().empty() && netstats::LoadCapture(netstats::ReplayPath(), replay_queue)) {
+		replay_queue.erase(std::remove_if(replay_queue.begin(), replay_queue.end(), [](const netstats::CaptureRecord &record) {
+			return record.type != netstats::CaptureRecordType::MessageReceived;
+		}),
+		    replay_queue.end());
+		replay_start = SDL_GetTicks();
+	}
 	return plr_single;
 }
 
@@ -17,10 +29,24 @@ int loopback::join(std::string /*addrstr*/)
 	ABORT();
 }
 
+bool loopback::ReceiveReplayMessage(int *sender, void **data, uint32_t *size)
+{
+	if (replay_queue.empty() || SDL_GetTicks() - replay_start < replay_queue.front().time)
+		return false;
+	const netstats::CaptureRecord &record = replay_queue.front();
+	const auto *rawMessage = reinterpret_cast<const unsigned char *>(record.data.data());
+	message_last.assign(rawMessage, rawMessage + record.data.size());
+	*sender = record.player;
+	replay_queue.pop_front();
+	*size = message_last.size();
+	*data = message_last.data();
+	return true;
+}
+
 bool loopback::SNetReceiveMessage(int *sender, void **data, uint32_t *size)
 {
 	if (message_queue.empty())
-		return false;
+		return ReceiveReplayMessage(sender, data, size);
 	message_last = message_queue.front();
 	message_queue.pop();
 	*sender = plr_single;
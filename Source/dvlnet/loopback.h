@@ -1,9 +1,11 @@
 #pragma once
 
+#include <deque>
 #include <queue>
 #include <string>
 
 #include "dvlnet/abstract_net.h"
+#include "netstats.h"
 
 namespace devilution {
 namespace net {
@@ -13,6 +15,11 @@ private:
 	std::queue<buffer_t> message_queue;
 	buffer_t message_last;
 	int plr_single;
+	/** Messages from a network capture, delivered as if their senders were still in the game */
+	std::deque<netstats::CaptureRecord> replay_queue;
+	uint32_t replay_start = 0;
+
+	bool ReceiveReplayMessage(int *sender, void **data, uint32_t *size);
 
 public:
 	loopback()
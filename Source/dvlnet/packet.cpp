@@ -176,27 +176,40 @@ leaveinfo_t packet::LeaveInfo()
 	return m_leaveinfo;
 }
 
-void packet_in::Create(buffer_t buf)
+void packet::Reset()
+{
+	have_encrypted = false;
+	have_decrypted = false;
+	m_message.clear();
+	m_info.clear();
+	encrypted_buffer.clear();
+	decrypted_buffer.clear();
+}
+
+void packet_in::Reset()
+{
+	packet::Reset();
+	m_read_pos = 0;
+}
+
+void packet_in::Create(const unsigned char *data, size_t size)
 {
 	assert(!have_encrypted && !have_decrypted);
-	if (buf.size() < sizeof(packet_type) + 2 * sizeof(plr_t))
+	if (size < sizeof(packet_type) + 2 * sizeof(plr_t))
 		throw packet_exception();
 
-	decrypted_buffer = std::move(buf);
+	// Parsing leaves decrypted_buffer intact, so the TCP server
+	// can forward the original data to clients through Data()
+	decrypted_buffer.assign(data, data + size);
 	have_decrypted = true;
-
-	// TCP server implementation forwards the original data to clients
-	// so although we are not decrypting anything,
-	// we save a copy in encrypted_buffer anyway
-	encrypted_buffer = decrypted_buffer;
-	have_encrypted = true;
 }
 
 #ifdef PACKET_ENCRYPTION
-void packet_in::Decrypt(buffer_t buf)
+void packet_in::Decrypt(const unsigned char *data, size_t size)
 {
 	assert(!have_encrypted && !have_decrypted);
-	encrypted_buffer = std::move(buf);
+	// The ciphertext is kept for the TCP server to forward, so this cannot decrypt in place
+	encrypted_buffer.assign(data, data + size);
 	have_encrypted = true;
 
 	if (encrypted_buffer.size() < crypto_secretbox_NONCEBYTES
@@ -228,15 +241,16 @@ void packet_out::Encrypt()
 	if (have_encrypted)
 		return;
 
+	// Encrypt in place: the cleartext is moved behind room for the nonce and MAC,
+	// and crypto_secretbox_easy supports overlapping buffers.
 	auto lenCleartext = decrypted_buffer.size();
+	encrypted_buffer.swap(decrypted_buffer);
 	encrypted_buffer.insert(encrypted_buffer.begin(),
-	    crypto_secretbox_NONCEBYTES, 0);
-	encrypted_buffer.insert(encrypted_buffer.end(),
-	    crypto_secretbox_MACBYTES + lenCleartext, 0);
+	    crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES, 0);
 	randombytes_buf(encrypted_buffer.data(), crypto_secretbox_NONCEBYTES);
 	int status = crypto_secretbox_easy(
 	    encrypted_buffer.data() + crypto_secretbox_NONCEBYTES,
-	    decrypted_buffer.data(),
+	    encrypted_buffer.data() + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES,
 	    lenCleartext,
 	    encrypted_buffer.data(),
 	    key.data());
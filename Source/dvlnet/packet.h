@@ -4,13 +4,16 @@
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #ifdef PACKET_ENCRYPTION
 #include <sodium.h>
 #endif
 
 #include "dvlnet/abstract_net.h"
+#include "utils/sdl_mutex.h"
 #include "utils/stubs.h"
 
 namespace devilution {
@@ -100,6 +103,9 @@ public:
 	plr_t NewPlayer();
 	const buffer_t &Info();
 	leaveinfo_t LeaveInfo();
+
+	/** @brief Clears the packet for reuse, keeping the capacity of its buffers. */
+	void Reset();
 };
 
 template <class P>
@@ -110,13 +116,17 @@ public:
 };
 
 class packet_in : public packet_proc<packet_in> {
+	/** Position of the next element in decrypted_buffer, which is left intact while parsing. */
+	size_t m_read_pos = 0;
+
 public:
 	using packet_proc<packet_in>::packet_proc;
-	void Create(buffer_t buf);
+	void Create(const unsigned char *data, size_t size);
 	void process_element(buffer_t &x);
 	template <class T>
 	void process_element(T &x);
-	void Decrypt(buffer_t buf);
+	void Decrypt(const unsigned char *data, size_t size);
+	void Reset();
 };
 
 class packet_out : public packet_proc<packet_out> {
@@ -178,18 +188,17 @@ void packet_proc<P>::process_data()
 
 inline void packet_in::process_element(buffer_t &x)
 {
-	x.insert(x.begin(), decrypted_buffer.begin(), decrypted_buffer.end());
-	decrypted_buffer.resize(0);
+	x.assign(decrypted_buffer.begin() + m_read_pos, decrypted_buffer.end());
+	m_read_pos = decrypted_buffer.size();
 }
 
 template <class T>
 void packet_in::process_element(T &x)
 {
-	if (decrypted_buffer.size() < sizeof(T))
+	if (decrypted_buffer.size() - m_read_pos < sizeof(T))
 		throw packet_exception();
-	std::memcpy(&x, decrypted_buffer.data(), sizeof(T));
-	decrypted_buffer.erase(decrypted_buffer.begin(),
-	    decrypted_buffer.begin() + sizeof(T));
+	std::memcpy(&x, decrypted_buffer.data() + m_read_pos, sizeof(T));
+	m_read_pos += sizeof(T);
 }
 
 template <>
@@ -330,44 +339,107 @@ const unsigned char *packet_out::end(const T &x)
 	return reinterpret_cast<const unsigned char *>(&x) + sizeof(T);
 }
 
+class packet_factory;
+
+/** @brief Returns a packet to the pool of the factory that made it. */
+struct packet_deleter {
+	packet_factory *factory;
+	bool inbound;
+
+	void operator()(packet *pkt) const;
+};
+
+using packet_ptr = std::unique_ptr<packet, packet_deleter>;
+
 class packet_factory {
 	key_t key = {};
 	bool secure;
 
+	/** Spare packets kept per direction, so that their buffers are reused by later packets. */
+	static constexpr size_t max_pooled_packets = 16;
+	SdlMutex pool_mutex;
+	std::vector<std::unique_ptr<packet_in>> free_in;
+	std::vector<std::unique_ptr<packet_out>> free_out;
+
+	template <class P>
+	std::unique_ptr<P> Acquire(std::vector<std::unique_ptr<P>> &pool);
+	template <class P>
+	void Release(std::vector<std::unique_ptr<P>> &pool, P *pkt);
+
+	friend struct packet_deleter;
+
 public:
 	static constexpr unsigned short max_packet_size = 0xFFFF;
 
 	packet_factory();
 	packet_factory(std::string pw);
-	std::unique_ptr<packet> make_packet(buffer_t buf);
+	packet_ptr make_packet(const unsigned char *data, size_t size);
+	packet_ptr make_packet(const buffer_t &buf)
+	{
+		return make_packet(buf.data(), buf.size());
+	}
 	template <packet_type t, typename... Args>
-	std::unique_ptr<packet> make_packet(Args... args);
+	packet_ptr make_packet(Args... args);
 };
 
-inline std::unique_ptr<packet> packet_factory::make_packet(buffer_t buf)
+template <class P>
+std::unique_ptr<P> packet_factory::Acquire(std::vector<std::unique_ptr<P>> &pool)
+{
+	{
+		std::lock_guard<SdlMutex> lock(pool_mutex);
+		if (!pool.empty()) {
+			std::unique_ptr<P> pkt = std::move(pool.back());
+			pool.pop_back();
+			return pkt;
+		}
+	}
+	return std::make_unique<P>(key);
+}
+
+template <class P>
+void packet_factory::Release(std::vector<std::unique_ptr<P>> &pool, P *pkt)
+{
+	std::unique_ptr<P> owned { pkt };
+	owned->Reset();
+	std::lock_guard<SdlMutex> lock(pool_mutex);
+	if (pool.size() < max_pooled_packets)
+		pool.push_back(std::move(owned));
+}
+
+inline void packet_deleter::operator()(packet *pkt) const
+{
+	if (inbound)
+		factory->Release(factory->free_in, static_cast<packet_in *>(pkt));
+	else
+		factory->Release(factory->free_out, static_cast<packet_out *>(pkt));
+}
+
+inline packet_ptr packet_factory::make_packet(const unsigned char *data, size_t size)
 {
-	auto ret = std::make_unique<packet_in>(key);
+	packet_ptr ret { Acquire(free_in).release(), packet_deleter { this, true } };
+	auto &pkt = static_cast<packet_in &>(*ret);
 #ifndef PACKET_ENCRYPTION
-	ret->Create(std::move(buf));
+	pkt.Create(data, size);
 #else
 	if (!secure)
-		ret->Create(std::move(buf));
+		pkt.Create(data, size);
 	else
-		ret->Decrypt(std::move(buf));
+		pkt.Decrypt(data, size);
 #endif
-	ret->process_data();
+	pkt.process_data();
 	return ret;
 }
 
 template <packet_type t, typename... Args>
-std::unique_ptr<packet> packet_factory::make_packet(Args... args)
+packet_ptr packet_factory::make_packet(Args... args)
 {
-	auto ret = std::make_unique<packet_out>(key);
-	ret->create<t>(args...);
-	ret->process_data();
+	packet_ptr ret { Acquire(free_out).release(), packet_deleter { this, false } };
+	auto &pkt = static_cast<packet_out &>(*ret);
+	pkt.create<t>(args...);
+	pkt.process_data();
 #ifdef PACKET_ENCRYPTION
 	if (secure)
-		ret->Encrypt();
+		pkt.Encrypt();
 #endif
 	return ret;
 }
@@ -154,7 +154,7 @@ bool protocol_zt::recv_peer(const endpoint &peer)
 	while (true) {
 		auto len = lwip_recv(peer_list[peer].fd, buf, sizeof(buf), 0);
 		if (len >= 0) {
-			peer_list[peer].recv_queue.Write(buffer_t(buf, buf + len));
+			peer_list[peer].recv_queue.Write(buf, len);
 		} else {
 			return errno == EAGAIN || errno == EWOULDBLOCK;
 		}
@@ -239,7 +239,8 @@ bool protocol_zt::recv(endpoint &peer, buffer_t &data)
 	for (auto &p : peer_list) {
 		if (p.second.recv_queue.PacketReady()) {
 			peer = p.first;
-			data = p.second.recv_queue.ReadPacket();
+			frame_view frame = p.second.recv_queue.ReadPacket();
+			data = buffer_t(frame.begin(), frame.end());
 			return true;
 		}
 	}
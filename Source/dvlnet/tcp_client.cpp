@@ -1,4 +1,5 @@
 #include "dvlnet/tcp_client.h"
+#include "netstats.h"
 #include "options.h"
 #include "utils/language.h"
 
@@ -49,6 +50,7 @@ int tcp_client::join(std::string addrstr)
 		    PLR_MASTER, cookie_self,
 		    game_init_info);
 		send(*pkt);
+		flush();
 		for (auto i = 0; i < NoSleep; ++i) {
 			try {
 				poll();
@@ -72,6 +74,8 @@ int tcp_client::join(std::string addrstr)
 void tcp_client::poll()
 {
 	ioc.poll();
+	// Also sends whatever the local server queued while forwarding
+	flush();
 }
 
 void tcp_client::HandleReceive(const asio::error_code &error, size_t bytesRead)
@@ -85,11 +89,10 @@ void tcp_client::HandleReceive(const asio::error_code &error, size_t bytesRead)
 	if (bytesRead == 0) {
 		throw std::runtime_error(_("error: read 0 bytes from server"));
 	}
-	recv_buffer.resize(bytesRead);
-	recv_queue.Write(std::move(recv_buffer));
-	recv_buffer.resize(frame_queue::max_frame_size);
+	recv_queue.Commit(bytesRead);
 	while (recv_queue.PacketReady()) {
-		auto pkt = pktfty->make_packet(recv_queue.ReadPacket());
+		frame_view frame = recv_queue.ReadPacket();
+		auto pkt = pktfty->make_packet(frame.data, frame.size);
 		RecvLocal(*pkt);
 	}
 	StartReceive();
@@ -98,7 +101,7 @@ void tcp_client::HandleReceive(const asio::error_code &error, size_t bytesRead)
 void tcp_client::StartReceive()
 {
 	sock.async_receive(
-	    asio::buffer(recv_buffer),
+	    asio::buffer(recv_queue.Reserve(frame_queue::max_frame_size), frame_queue::max_frame_size),
 	    std::bind(&tcp_client::HandleReceive, this, std::placeholders::_1, std::placeholders::_2));
 }
 
@@ -109,10 +112,24 @@ void tcp_client::HandleSend(const asio::error_code &error, size_t bytesSent)
 
 void tcp_client::send(packet &pkt)
 {
-	auto frame = std::make_unique<buffer_t>(frame_queue::MakeFrame(pkt.Data()));
-	auto buf = asio::buffer(*frame);
-	asio::async_write(sock, buf, [this, frame = std::move(frame)](const asio::error_code &error, size_t bytesSent) {
+	netstats::CountPacket(netstats::Direction::Sent, pkt.Type(), pkt.Data().size());
+	frame_queue::AppendFrame(send_queue, pkt.Data());
+}
+
+void tcp_client::flush()
+{
+	if (local_server != nullptr)
+		local_server->Flush();
+	if (sending || send_queue.empty())
+		return;
+	std::swap(send_buffer, send_queue);
+	send_queue.clear();
+	sending = true;
+	asio::async_write(sock, asio::buffer(send_buffer), [this](const asio::error_code &error, size_t bytesSent) {
+		sending = false;
 		HandleSend(error, bytesSent);
+		if (!error)
+			flush();
 	});
 }
 
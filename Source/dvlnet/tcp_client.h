@@ -23,6 +23,7 @@ public:
 
 	virtual void poll();
 	virtual void send(packet &pkt);
+	virtual void flush();
 
 	virtual bool SNetLeaveGame(int type);
 
@@ -32,7 +33,11 @@ public:
 
 private:
 	frame_queue recv_queue;
-	buffer_t recv_buffer = buffer_t(frame_queue::max_frame_size);
+	/** Frames queued since the last flush */
+	buffer_t send_queue;
+	/** Frames being written, kept alive until the write completes */
+	buffer_t send_buffer;
+	bool sending = false;
 
 	asio::io_context ioc;
 	asio::ip::tcp::resolver resolver = asio::ip::tcp::resolver(ioc);
@@ -13,12 +13,12 @@ namespace net {
 
 tcp_server::tcp_server(asio::io_context &ioc, const std::string &bindaddr,
     unsigned short port, packet_factory &pktfty)
-    : ioc(ioc)
+    : strand(asio::make_strand(ioc))
     , pktfty(pktfty)
 {
 	auto addr = asio::ip::address::from_string(bindaddr);
 	auto ep = asio::ip::tcp::endpoint(addr, port);
-	acceptor = std::make_unique<asio::ip::tcp::acceptor>(ioc, ep, true);
+	acceptor = std::make_unique<asio::ip::tcp::acceptor>(strand, ep, true);
 	StartAccept();
 }
 
@@ -39,7 +39,7 @@ std::string tcp_server::LocalhostSelf()
 
 tcp_server::scc tcp_server::MakeConnection()
 {
-	return std::make_shared<client_connection>(ioc);
+	return std::make_shared<client_connection>(strand);
 }
 
 plr_t tcp_server::NextFree()
@@ -58,10 +58,30 @@ bool tcp_server::Empty()
 	return true;
 }
 
+void tcp_server::CountPlayers()
+{
+	int count = 0;
+	for (plr_t i = 0; i < MAX_PLRS; ++i)
+		if (connections[i])
+			count++;
+	players = count;
+}
+
+tcp_server_stats tcp_server::Stats() const
+{
+	return {
+		players,
+		packets_received,
+		bytes_received,
+		packets_sent,
+		bytes_sent,
+	};
+}
+
 void tcp_server::StartReceive(const scc &con)
 {
 	con->socket.async_receive(
-	    asio::buffer(con->recv_buffer),
+	    asio::buffer(con->recv_queue.Reserve(frame_queue::max_frame_size), frame_queue::max_frame_size),
 	    std::bind(&tcp_server::HandleReceive, this, con, std::placeholders::_1, std::placeholders::_2));
 }
 
@@ -72,12 +92,13 @@ void tcp_server::HandleReceive(const scc &con, const asio::error_code &ec,
 		DropConnection(con);
 		return;
 	}
-	con->recv_buffer.resize(bytesRead);
-	con->recv_queue.Write(std::move(con->recv_buffer));
-	con->recv_buffer.resize(frame_queue::max_frame_size);
+	con->recv_queue.Commit(bytesRead);
+	bytes_received += bytesRead;
 	while (con->recv_queue.PacketReady()) {
 		try {
-			auto pkt = pktfty.make_packet(con->recv_queue.ReadPacket());
+			frame_view frame = con->recv_queue.ReadPacket();
+			packets_received++;
+			auto pkt = pktfty.make_packet(frame.data, frame.size);
 			if (con->plr == PLR_BROADCAST) {
 				HandleReceiveNewPlayer(con, *pkt);
 			} else {
@@ -113,6 +134,7 @@ void tcp_server::HandleReceiveNewPlayer(const scc &con, packet &pkt)
 	StartSend(con, *reply);
 	con->plr = newplr;
 	connections[newplr] = con;
+	CountPlayers();
 	con->timeout = timeout_active;
 	SendConnect(con);
 }
@@ -138,14 +160,42 @@ void tcp_server::SendPacket(packet &pkt)
 
 void tcp_server::StartSend(const scc &con, packet &pkt)
 {
-	auto frame = std::make_unique<buffer_t>(frame_queue::MakeFrame(pkt.Data()));
-	auto buf = asio::buffer(*frame);
-	asio::async_write(con->socket, buf,
-	    [this, con, frame = std::move(frame)](const asio::error_code &ec, size_t bytesSent) {
+	frame_queue::AppendFrame(con->send_queue, pkt.Data());
+	packets_sent++;
+	// Everything sent by the handlers that are ready now goes out in one write per connection
+	if (flush_pending)
+		return;
+	flush_pending = true;
+	asio::post(strand, [this]() {
+		flush_pending = false;
+		Flush();
+	});
+}
+
+void tcp_server::Flush(const scc &con)
+{
+	if (con->sending || con->send_queue.empty())
+		return;
+	std::swap(con->send_buffer, con->send_queue);
+	con->send_queue.clear();
+	con->sending = true;
+	asio::async_write(con->socket, asio::buffer(con->send_buffer),
+	    [this, con](const asio::error_code &ec, size_t bytesSent) {
+		    con->sending = false;
+		    bytes_sent += bytesSent;
 		    HandleSend(con, ec, bytesSent);
+		    if (!ec)
+			    Flush(con);
 	    });
 }
 
+void tcp_server::Flush()
+{
+	for (auto &con : connections)
+		if (con)
+			Flush(con);
+}
+
 void tcp_server::HandleSend(const scc &con, const asio::error_code &ec,
     size_t bytesSent)
 {
@@ -205,10 +255,12 @@ void tcp_server::DropConnection(const scc &con)
 		auto pkt = pktfty.make_packet<PT_DISCONNECT>(PLR_MASTER, PLR_BROADCAST,
 		    con->plr, LEAVE_DROP);
 		connections[con->plr] = nullptr;
+		CountPlayers();
 		SendPacket(*pkt);
 		// TODO: investigate if it is really ok for the server to
 		//       drop a client directly.
 	}
+	con->send_queue.clear();
 	con->timer.cancel();
 	con->socket.close();
 }
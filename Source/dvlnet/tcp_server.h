@@ -1,10 +1,13 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <string>
 
 #include <asio/ts/buffer.hpp>
+#include <asio/ts/executor.hpp>
 #include <asio/ts/internet.hpp>
 #include <asio/ts/io_context.hpp>
 #include <asio/ts/net.hpp>
@@ -25,12 +28,29 @@ public:
 	}
 };
 
+/** @brief Traffic counters of a tcp_server. */
+struct tcp_server_stats {
+	int players;
+	uint64_t packets_received;
+	uint64_t bytes_received;
+	uint64_t packets_sent;
+	uint64_t bytes_sent;
+};
+
+/**
+ * @brief Hosts one game, relaying packets between the connected players.
+ *
+ * All handlers run on a strand, so several servers can share an io_context that is run by a thread pool.
+ */
 class tcp_server {
 public:
 	tcp_server(asio::io_context &ioc, const std::string &bindaddr,
 	    unsigned short port, packet_factory &pktfty);
 	std::string LocalhostSelf();
 	void Close();
+	void Flush();
+	/** @brief Can be called from any thread. */
+	tcp_server_stats Stats() const;
 	virtual ~tcp_server();
 
 private:
@@ -39,29 +59,42 @@ private:
 
 	struct client_connection {
 		frame_queue recv_queue;
-		buffer_t recv_buffer = buffer_t(frame_queue::max_frame_size);
+		/** Frames queued since the last flush */
+		buffer_t send_queue;
+		/** Frames being written, kept alive until the write completes */
+		buffer_t send_buffer;
+		bool sending = false;
 		plr_t plr = PLR_BROADCAST;
 		asio::ip::tcp::socket socket;
 		asio::steady_timer timer;
 		int timeout;
-		client_connection(asio::io_context &ioc)
-		    : socket(ioc)
-		    , timer(ioc)
+		client_connection(const asio::strand<asio::io_context::executor_type> &strand)
+		    : socket(strand)
+		    , timer(strand)
 		{
 		}
 	};
 
 	typedef std::shared_ptr<client_connection> scc;
 
-	asio::io_context &ioc;
+	asio::strand<asio::io_context::executor_type> strand;
 	packet_factory &pktfty;
 	std::unique_ptr<asio::ip::tcp::acceptor> acceptor;
 	std::array<scc, MAX_PLRS> connections;
 	buffer_t game_init_info;
+	/** A flush of all connections has been posted to the strand */
+	bool flush_pending = false;
+
+	std::atomic<int> players { 0 };
+	std::atomic<uint64_t> packets_received { 0 };
+	std::atomic<uint64_t> bytes_received { 0 };
+	std::atomic<uint64_t> packets_sent { 0 };
+	std::atomic<uint64_t> bytes_sent { 0 };
 
 	scc MakeConnection();
 	plr_t NextFree();
 	bool Empty();
+	void CountPlayers();
 	void StartAccept();
 	void HandleAccept(const scc &con, const asio::error_code &ec);
 	void StartReceive(const scc &con);
@@ -71,6 +104,7 @@ private:
 	void SendConnect(const scc &con);
 	void SendPacket(packet &pkt);
 	void StartSend(const scc &con, packet &pkt);
+	void Flush(const scc &con);
 	void HandleSend(const scc &con, const asio::error_code &ec, size_t bytesSent);
 	void StartTimeout(const scc &con);
 	void HandleTimeout(const scc &con, const asio::error_code &ec);
@@ -5,6 +5,8 @@
  */
 #include "effects.h"
 
+#include <vector>
+
 #include "engine/random.hpp"
 #include "init.h"
 #include "player.h"
@@ -27,6 +29,39 @@ constexpr bool AllowStreaming = false;
 /** Specifies the sound file and the playback state of the current sound effect. */
 TSFX *sgpStreamSFX = nullptr;
 
+/** A sound effect that was triggered while it was still being loaded. */
+struct PendingSfx {
+	TSFX *sfx;
+	bool loc;
+	Point position;
+	uint32_t requestTc;
+};
+
+/** Sound effects waiting for their file to be loaded in the background. */
+std::vector<PendingSfx> pendingSfx;
+
+/** Pending sound effects that take longer than this to load (in ms) are dropped. */
+constexpr uint32_t MaxPendingSfxDelay = 200;
+
+/** A positional sound effect triggered while processing the game logic. */
+struct SfxRequest {
+	/** Effect before RndSFX, so that variants of the same sound are merged. */
+	_sfx_id requested;
+	_sfx_id psfx;
+	Point position;
+	int volume;
+	int pan;
+};
+
+/** Positional sound effects of the current game tick, played together by sound_update. */
+std::vector<SfxRequest> sfxRequests;
+
+/** Maximum number of positional sound effects started per game tick. */
+constexpr size_t MaxSfxPerTick = 8;
+
+/** The same effect triggered this close (in tiles) to a louder one in the same tick is only played once. */
+constexpr int SfxMergeDistance = 2;
+
 /**
  * Monster sound type prefix
  * a: Attack
@@ -1095,7 +1130,10 @@ void StreamUpdate()
 	}
 }
 
-void PlaySfxPriv(TSFX *pSFX, bool loc, Point position)
+/**
+ * @brief Plays a sound effect whose volume and pan have already been calculated.
+ */
+void PlaySfxPriv(TSFX *pSFX, bool loc, Point position, int lVolume, int lPan)
 {
 	if (Players[MyPlayerId].pLvlLoad != 0 && gbIsMultiplayer) {
 		return;
@@ -1108,22 +1146,90 @@ void PlaySfxPriv(TSFX *pSFX, bool loc, Point position)
 		return;
 	}
 
+	if ((pSFX->bFlags & sfx_STREAM) != 0) {
+		StreamPlay(pSFX, lVolume, lPan);
+		return;
+	}
+
+	if (pSFX->pSnd == nullptr) {
+		LoadSoundAsync(pSFX->pSnd, pSFX->pszName, SoundLoadGroup::Effects);
+		const auto it = std::find_if(pendingSfx.begin(), pendingSfx.end(), [&](const PendingSfx &pending) { return pending.sfx == pSFX; });
+		if (it == pendingSfx.end())
+			pendingSfx.push_back(PendingSfx { pSFX, loc, position, SDL_GetTicks() });
+		else
+			*it = PendingSfx { pSFX, loc, position, SDL_GetTicks() };
+		return;
+	}
+
+	snd_play_snd(pSFX->pSnd.get(), lVolume, lPan);
+}
+
+void PlaySfxPriv(TSFX *pSFX, bool loc, Point position)
+{
 	int lVolume = 0;
 	int lPan = 0;
 	if (loc && !CalculateSoundPosition(position, &lVolume, &lPan)) {
 		return;
 	}
 
-	if ((pSFX->bFlags & sfx_STREAM) != 0) {
-		StreamPlay(pSFX, lVolume, lPan);
-		return;
+	PlaySfxPriv(pSFX, loc, position, lVolume, lPan);
+}
+
+/**
+ * @brief Plays the positional sound effects of this game tick.
+ *
+ * Inaudible effects are dropped, the same effect triggered next to a louder one is merged into it,
+ * and only the MaxSfxPerTick loudest effects are started.
+ */
+void PlayQueuedSfx()
+{
+	const auto inaudible = std::remove_if(sfxRequests.begin(), sfxRequests.end(), [](SfxRequest &request) {
+		return !CalculateSoundPosition(request.position, &request.volume, &request.pan);
+	});
+	sfxRequests.erase(inaudible, sfxRequests.end());
+	std::stable_sort(sfxRequests.begin(), sfxRequests.end(), [](const SfxRequest &a, const SfxRequest &b) {
+		return a.volume > b.volume;
+	});
+
+	size_t played = 0;
+	for (auto it = sfxRequests.begin(); it != sfxRequests.end() && played < MaxSfxPerTick; ++it) {
+		const SfxRequest &request = *it;
+		const bool merged = std::any_of(sfxRequests.begin(), it, [&](const SfxRequest &louder) {
+			return louder.requested == request.requested && louder.position.ApproxDistance(request.position) <= SfxMergeDistance;
+		});
+		if (merged)
+			continue;
+
+		if (request.psfx >= 0 && request.psfx <= 3) {
+			TSnd *pSnd = sgSFX[request.psfx].pSnd.get();
+			if (pSnd != nullptr)
+				pSnd->start_tc = 0;
+		}
+		PlaySfxPriv(&sgSFX[request.psfx], true, request.position, request.volume, request.pan);
+		played++;
 	}
+	sfxRequests.clear();
+}
 
-	if (pSFX->pSnd == nullptr)
-		pSFX->pSnd = sound_file_load(pSFX->pszName);
+/**
+ * @brief Plays the pending sound effects whose files have finished loading, unless they waited too long.
+ */
+void PlayPendingSfx()
+{
+	const uint32_t tc = SDL_GetTicks();
+	std::vector<PendingSfx> ready;
+	const auto end = std::remove_if(pendingSfx.begin(), pendingSfx.end(), [&](const PendingSfx &pending) {
+		if (tc - pending.requestTc > MaxPendingSfxDelay)
+			return true;
+		if (pending.sfx->pSnd == nullptr)
+			return false;
+		ready.push_back(pending);
+		return true;
+	});
+	pendingSfx.erase(end, pendingSfx.end());
 
-	if (pSFX->pSnd != nullptr)
-		snd_play_snd(pSFX->pSnd.get(), lVolume, lPan);
+	for (const PendingSfx &pending : ready)
+		PlaySfxPriv(pending.sfx, pending.loc, pending.position);
 }
 
 _sfx_id RndSFX(_sfx_id psfx)
@@ -1158,7 +1264,12 @@ _sfx_id RndSFX(_sfx_id psfx)
 	return static_cast<_sfx_id>(psfx + GenerateRnd(nRand));
 }
 
-void PrivSoundInit(BYTE bLoadMask)
+/**
+ * @brief Loads the sound effects matching the mask.
+ * @param bLoadMask sfx_flag values to load
+ * @param inBackground Warm up the sounds on the sound loading thread instead of waiting for them
+ */
+void PrivSoundInit(BYTE bLoadMask, bool inBackground)
 {
 	if (!gbSndInited) {
 		return;
@@ -1181,7 +1292,10 @@ void PrivSoundInit(BYTE bLoadMask)
 			continue;
 		}
 
-		sfx.pSnd = sound_file_load(sfx.pszName);
+		if (inBackground)
+			LoadSoundAsync(sfx.pSnd, sfx.pszName, SoundLoadGroup::Effects);
+		else
+			sfx.pSnd = sound_file_load(sfx.pszName);
 	}
 }
 
@@ -1219,7 +1333,7 @@ void InitMonsterSND(int monst)
 			for (int j = 0; j < 2; j++) {
 				char path[MAX_PATH];
 				sprintf(path, MonstersData[mtype].sndfile, MonstSndChar[i], j + 1);
-				LevelMonsterTypes[monst].Snds[i][j] = sound_file_load(path);
+				LoadSoundAsync(LevelMonsterTypes[monst].Snds[i][j], path, SoundLoadGroup::Monsters);
 			}
 		}
 	}
@@ -1227,6 +1341,7 @@ void InitMonsterSND(int monst)
 
 void FreeMonsterSnd()
 {
+	CancelSoundLoads(SoundLoadGroup::Monsters);
 	for (int i = 0; i < LevelMonsterTypeCount; i++) {
 		for (auto &variants : LevelMonsterTypes[i].Snds) {
 			for (auto &snd : variants) {
@@ -1264,10 +1379,16 @@ void PlaySFX(_sfx_id psfx)
 
 void PlaySfxLoc(_sfx_id psfx, Point position, bool randomizeByCategory)
 {
+	const _sfx_id requested = psfx;
 	if (randomizeByCategory) {
 		psfx = RndSFX(psfx);
 	}
 
+	if (gbSndInited && gGameLogicStep != GameLogicStep::None) {
+		sfxRequests.push_back(SfxRequest { requested, psfx, position, 0, 0 });
+		return;
+	}
+
 	if (psfx >= 0 && psfx <= 3) {
 		TSnd *pSnd = sgSFX[psfx].pSnd.get();
 		if (pSnd != nullptr)
@@ -1279,10 +1400,17 @@ void PlaySfxLoc(_sfx_id psfx, Point position, bool randomizeByCategory)
 
 void sound_stop()
 {
-	ClearDuplicateSounds();
 	for (auto &sfx : sgSFX) {
 		if (sfx.pSnd != nullptr) {
-			sfx.pSnd->DSB.Stop();
+			sfx.pSnd->Stop();
+		}
+	}
+	for (int i = 0; i < LevelMonsterTypeCount; i++) {
+		for (auto &variants : LevelMonsterTypes[i].Snds) {
+			for (auto &snd : variants) {
+				if (snd != nullptr)
+					snd->Stop();
+			}
 		}
 	}
 }
@@ -1294,11 +1422,18 @@ void sound_update()
 	}
 
 	StreamUpdate();
+	PlayQueuedSfx();
+	ProcessLoadedSounds();
+	if (!pendingSfx.empty())
+		PlayPendingSfx();
 }
 
 void effects_cleanup_sfx()
 {
 	sound_stop();
+	CancelSoundLoads(SoundLoadGroup::Effects);
+	pendingSfx.clear();
+	sfxRequests.clear();
 
 	for (auto &sfx : sgSFX)
 		sfx.pSnd = nullptr;
@@ -1334,12 +1469,18 @@ void sound_init()
 		}
 	}
 
-	PrivSoundInit(mask);
+#ifdef STREAM_ALL_AUDIO
+	// Memory is at a premium, only load the effects when they are first played.
+	static_cast<void>(mask);
+#else
+	PrivSoundInit(mask, /*inBackground=*/true);
+#endif
 }
 
 void ui_sound_init()
 {
-	PrivSoundInit(sfx_UI);
+	// Menus play their sounds right away and do not process background loads.
+	PrivSoundInit(sfx_UI, /*inBackground=*/false);
 }
 
 void effects_play_sound(const char *sndFile)
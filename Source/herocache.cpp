@@ -0,0 +1,141 @@
+/**
+ * @file herocache.cpp
+ *
+ * Implementation of the cache of what the character selection screen shows for each save.
+ */
+#include "herocache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "pfile.h"
+#include "utils/endian.hpp"
+#include "utils/file_util.h"
+#include "utils/log.hpp"
+
+namespace devilution {
+
+namespace {
+
+const uint32_t HeroCacheMagic = LoadLE32("DHRC");
+constexpr uint32_t HeroCacheVersion = 1;
+constexpr size_t HeroCacheHeaderSize = 12;
+constexpr size_t HeroCacheEntrySize = 4 + 8 + 8 + PLR_NAME_LEN + 1 + sizeof(_uiheroinfo::name) + 3 + 4 * 2 + 2;
+
+template <typename T>
+void AppendLE(std::vector<byte> &out, T value)
+{
+	for (size_t i = 0; i < sizeof(T); i++)
+		out.push_back(static_cast<byte>(static_cast<uint64_t>(value) >> (8 * i)));
+}
+
+template <typename T>
+T TakeLE(const byte *&data)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < sizeof(T); i++)
+		value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+	data += sizeof(T);
+	return static_cast<T>(value);
+}
+
+} // namespace
+
+std::vector<HeroCacheEntry> ReadHeroCache(const char *path)
+{
+	std::vector<HeroCacheEntry> entries;
+
+	FILE *file = FOpen(path, "rb");
+	if (file == nullptr)
+		return entries;
+	std::vector<byte> data(HeroCacheHeaderSize + MAX_CHARACTERS * HeroCacheEntrySize);
+	const size_t size = std::fread(data.data(), 1, data.size(), file);
+	std::fclose(file);
+
+	const byte *cur = data.data();
+	if (size < HeroCacheHeaderSize || TakeLE<uint32_t>(cur) != HeroCacheMagic || TakeLE<uint32_t>(cur) != HeroCacheVersion)
+		return entries;
+	const uint32_t count = TakeLE<uint32_t>(cur);
+	if (count > MAX_CHARACTERS || size != HeroCacheHeaderSize + count * HeroCacheEntrySize) {
+		LogError("Ignoring the damaged hero cache");
+		return entries;
+	}
+
+	entries.resize(count);
+	for (HeroCacheEntry &entry : entries) {
+		entry.saveNumber = TakeLE<uint32_t>(cur);
+		entry.archiveSize = TakeLE<uint64_t>(cur);
+		entry.archiveModified = TakeLE<int64_t>(cur);
+		memcpy(entry.heroName, cur, sizeof(entry.heroName));
+		cur += sizeof(entry.heroName);
+		entry.heroName[sizeof(entry.heroName) - 1] = '\0';
+		entry.listed = TakeLE<uint8_t>(cur) != 0;
+
+		_uiheroinfo &heroInfo = entry.heroInfo;
+		heroInfo.saveNumber = entry.saveNumber;
+		memcpy(heroInfo.name, cur, sizeof(heroInfo.name));
+		cur += sizeof(heroInfo.name);
+		heroInfo.name[sizeof(heroInfo.name) - 1] = '\0';
+		heroInfo.level = TakeLE<uint8_t>(cur);
+		heroInfo.heroclass = static_cast<HeroClass>(TakeLE<uint8_t>(cur));
+		heroInfo.herorank = TakeLE<uint8_t>(cur);
+		heroInfo.strength = TakeLE<uint16_t>(cur);
+		heroInfo.magic = TakeLE<uint16_t>(cur);
+		heroInfo.dexterity = TakeLE<uint16_t>(cur);
+		heroInfo.vitality = TakeLE<uint16_t>(cur);
+		heroInfo.hassaved = TakeLE<uint8_t>(cur) != 0;
+		heroInfo.spawned = TakeLE<uint8_t>(cur) != 0;
+	}
+
+	return entries;
+}
+
+void WriteHeroCache(const char *path, const std::vector<HeroCacheEntry> &entries)
+{
+	std::vector<byte> data;
+	data.reserve(HeroCacheHeaderSize + entries.size() * HeroCacheEntrySize);
+	AppendLE<uint32_t>(data, HeroCacheMagic);
+	AppendLE<uint32_t>(data, HeroCacheVersion);
+	AppendLE<uint32_t>(data, static_cast<uint32_t>(entries.size()));
+	for (const HeroCacheEntry &entry : entries) {
+		AppendLE<uint32_t>(data, entry.saveNumber);
+		AppendLE<uint64_t>(data, entry.archiveSize);
+		AppendLE<int64_t>(data, entry.archiveModified);
+		data.insert(data.end(), reinterpret_cast<const byte *>(entry.heroName), reinterpret_cast<const byte *>(entry.heroName) + sizeof(entry.heroName));
+		AppendLE<uint8_t>(data, entry.listed ? 1 : 0);
+
+		const _uiheroinfo &heroInfo = entry.heroInfo;
+		data.insert(data.end(), reinterpret_cast<const byte *>(heroInfo.name), reinterpret_cast<const byte *>(heroInfo.name) + sizeof(heroInfo.name));
+		AppendLE<uint8_t>(data, heroInfo.level);
+		AppendLE<uint8_t>(data, static_cast<uint8_t>(heroInfo.heroclass));
+		AppendLE<uint8_t>(data, heroInfo.herorank);
+		AppendLE<uint16_t>(data, heroInfo.strength);
+		AppendLE<uint16_t>(data, heroInfo.magic);
+		AppendLE<uint16_t>(data, heroInfo.dexterity);
+		AppendLE<uint16_t>(data, heroInfo.vitality);
+		AppendLE<uint8_t>(data, heroInfo.hassaved ? 1 : 0);
+		AppendLE<uint8_t>(data, heroInfo.spawned ? 1 : 0);
+	}
+
+	FILE *file = FOpen(path, "wb");
+	if (file == nullptr) {
+		LogError("Failed to write the hero cache {}", path);
+		return;
+	}
+	// A short write is caught by the size check when the cache is read
+	std::fwrite(data.data(), 1, data.size(), file);
+	std::fclose(file);
+}
+
+const HeroCacheEntry *FindHeroCacheEntry(const std::vector<HeroCacheEntry> &entries, uint32_t saveNumber, std::uintmax_t archiveSize, std::int64_t archiveModified)
+{
+	auto cached = std::find_if(entries.begin(), entries.end(), [&](const HeroCacheEntry &entry) {
+		return entry.saveNumber == saveNumber && entry.archiveSize == archiveSize && entry.archiveModified == archiveModified;
+	});
+	if (cached == entries.end())
+		return nullptr;
+	return &*cached;
+}
+
+} // namespace devilution
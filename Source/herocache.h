@@ -0,0 +1,42 @@
+/**
+ * @file herocache.h
+ *
+ * Interface of the cache of what the character selection screen shows for each save.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DiabloUI/diabloui.h"
+#include "player.h"
+
+namespace devilution {
+
+/**
+ * @brief What the character selection screen shows for one save archive.
+ *
+ * It stays valid for as long as the size and modification time of the archive match.
+ */
+struct HeroCacheEntry {
+	uint32_t saveNumber;
+	std::uintmax_t archiveSize;
+	std::int64_t archiveModified;
+	/** Name from the hero pack, empty when the archive holds no readable hero */
+	char heroName[PLR_NAME_LEN];
+	/** Whether the hero unpacked and is listed */
+	bool listed;
+	_uiheroinfo heroInfo;
+};
+
+/** @brief Loads the entries cached at path, none if the file is missing, damaged or from another version. */
+std::vector<HeroCacheEntry> ReadHeroCache(const char *path);
+void WriteHeroCache(const char *path, const std::vector<HeroCacheEntry> &entries);
+
+/**
+ * @brief Looks up the cached entry of a save archive.
+ * @return nullptr if there is none, or if the archive has changed since it was cached
+ */
+const HeroCacheEntry *FindHeroCacheEntry(const std::vector<HeroCacheEntry> &entries, uint32_t saveNumber, std::uintmax_t archiveSize, std::int64_t archiveModified);
+
+} // namespace devilution
@@ -16,6 +16,7 @@
 #include "dx.h"
 #include "engine/assets.hpp"
 #include "mpq/mpq_reader.hpp"
+#include "mpq/mpq_sdl_rwops.hpp"
 #include "options.h"
 #include "pfile.h"
 #include "utils/language.h"
@@ -65,7 +66,23 @@ std::optional<MpqArchive> LoadMPQ(const std::vector<std::string> &paths, const c
 	std::optional<MpqArchive> archive;
 	std::string mpqAbsPath;
 	std::int32_t error = 0;
+	// Asset packs made from the MPQ by devilutionx-pack take precedence while the MPQ is unchanged, they load much faster.
+	std::string packName = mpqName;
+	const std::string::size_type extension = packName.rfind('.');
+	if (extension != std::string::npos)
+		packName.erase(extension);
+	packName += AssetPackExtension;
 	for (const auto &path : paths) {
+		mpqAbsPath = path + packName;
+		if ((archive = MpqArchive::OpenAssetPack(mpqAbsPath.c_str(), (path + mpqName).c_str(), error))) {
+			LogVerbose("  Found: {} in {}", packName, path);
+			paths::SetMpqDir(path);
+			return archive;
+		}
+		if (error != 0) {
+			LogError("Error {}: {}", MpqArchive::ErrorMessage(error), mpqAbsPath);
+		}
+
 		mpqAbsPath = path + mpqName;
 		if ((archive = MpqArchive::Open(mpqAbsPath.c_str(), error))) {
 			LogVerbose("  Found: {} in {}", mpqName, path);
@@ -144,6 +161,9 @@ void init_cleanup()
 	if (gbIsMultiplayer && gbRunGame) {
 		pfile_write_hero(/*writeGameData=*/false, /*clearTables=*/true);
 	}
+	pfile_cleanup();
+
+	MpqReadaheadCleanup();
 
 	spawn_mpq = std::nullopt;
 	diabdat_mpq = std::nullopt;
@@ -210,6 +230,8 @@ void init_archives()
 		UiErrorOkDialog(_("Some Hellfire MPQs are missing"), _("Not all Hellfire MPQs were found.\nPlease copy all the hf*.mpq files."));
 		app_fatal(nullptr);
 	}
+
+	MpqReadaheadStart();
 }
 
 void init_language_archives()
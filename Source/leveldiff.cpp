@@ -0,0 +1,85 @@
+/**
+ * @file leveldiff.cpp
+ *
+ * Implementation of the byte diff used to save levels incrementally.
+ */
+#include "leveldiff.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace devilution {
+
+namespace {
+
+/** Equal runs shorter than this are cheaper to store than to split a patch over. */
+constexpr size_t MergeGap = 2 * sizeof(uint32_t);
+
+/** @brief Returns the first index from start on where the buffers differ, or size if there is none. */
+size_t FindMismatch(const byte *a, const byte *b, size_t start, size_t size)
+{
+	size_t i = start;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t wordA;
+		uint64_t wordB;
+		memcpy(&wordA, a + i, sizeof(wordA));
+		memcpy(&wordB, b + i, sizeof(wordB));
+		if (wordA != wordB)
+			break;
+	}
+	while (i < size && a[i] == b[i])
+		i++;
+	return i;
+}
+
+/** @brief Returns the first index from start on where the buffers are equal, or size if there is none. */
+size_t FindMatch(const byte *a, const byte *b, size_t start, size_t size)
+{
+	size_t i = start;
+	while (i < size && a[i] != b[i])
+		i++;
+	return i;
+}
+
+} // namespace
+
+std::vector<LevelPatch> DiffLevelImage(const byte *keyframe, size_t keyframeSize, const byte *image, size_t imageSize)
+{
+	std::vector<LevelPatch> patches;
+	const size_t common = std::min(keyframeSize, imageSize);
+
+	auto addRange = [&patches](size_t begin, size_t end) {
+		if (!patches.empty()) {
+			LevelPatch &last = patches.back();
+			if (begin - (last.offset + last.length) < MergeGap) {
+				last.length = static_cast<uint32_t>(end - last.offset);
+				return;
+			}
+		}
+		patches.push_back({ static_cast<uint32_t>(begin), static_cast<uint32_t>(end - begin) });
+	};
+
+	size_t i = FindMismatch(keyframe, image, 0, common);
+	while (i < common) {
+		const size_t end = FindMatch(keyframe, image, i, common);
+		addRange(i, end);
+		i = FindMismatch(keyframe, image, end, common);
+	}
+	if (imageSize > common)
+		addRange(common, imageSize);
+
+	return patches;
+}
+
+uint32_t HashLevelImage(const byte *data, size_t size)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261U;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= static_cast<uint8_t>(data[i]);
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+} // namespace devilution
@@ -0,0 +1,33 @@
+/**
+ * @file leveldiff.h
+ *
+ * Interface of the byte diff used to save levels incrementally.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+/** @brief A byte range of a level image that differs from its keyframe. */
+struct LevelPatch {
+	uint32_t offset;
+	uint32_t length;
+};
+
+/**
+ * @brief Finds the byte ranges where image differs from keyframe.
+ *
+ * Ranges that are only a few bytes apart are merged, as every patch costs a header in the delta.
+ * When image is the longer of the two, its tail is reported as changed.
+ */
+std::vector<LevelPatch> DiffLevelImage(const byte *keyframe, size_t keyframeSize, const byte *image, size_t imageSize);
+
+/** @brief Identifies the keyframe a delta was made against. */
+uint32_t HashLevelImage(const byte *data, size_t size);
+
+} // namespace devilution
@@ -5,8 +5,14 @@
  */
 #include "loadsave.h"
 
+#include <algorithm>
 #include <climits>
+#include <cstdint>
 #include <cstring>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
 
 #include <SDL.h>
 
@@ -21,13 +27,17 @@
 #include "engine/random.hpp"
 #include "init.h"
 #include "inv.h"
+#include "leveldiff.h"
 #include "lighting.h"
 #include "missiles.h"
 #include "mpq/mpq_writer.hpp"
 #include "pfile.h"
 #include "stores.h"
+#include "utils/compression.hpp"
 #include "utils/endian.hpp"
 #include "utils/language.h"
+#include "utils/log.hpp"
+#include "utils/stdcompat/optional.hpp"
 
 namespace devilution {
 
@@ -71,8 +81,12 @@ T SwapBE(T in)
 
 class LoadHelper {
 	std::unique_ptr<byte[]> m_buffer_;
+	/** Set when the file is still being decoded, m_size_ then only covers the part that is done */
+	std::unique_ptr<PFileStream> m_stream_;
+	const byte *m_data_ = nullptr;
 	size_t m_cur_ = 0;
-	size_t m_size_;
+	size_t m_size_ = 0;
+	std::vector<byte> m_scratch_;
 
 	template <class T>
 	T Next()
@@ -82,7 +96,7 @@ class LoadHelper {
 			return 0;
 
 		T value;
-		memcpy(&value, &m_buffer_[m_cur_], size);
+		memcpy(&value, &m_data_[m_cur_], size);
 		m_cur_ += size;
 
 		return value;
@@ -92,12 +106,31 @@ public:
 	LoadHelper(const char *szFileName)
 	{
 		m_buffer_ = pfile_read(szFileName, &m_size_);
+		m_data_ = m_buffer_.get();
+	}
+
+	LoadHelper(std::unique_ptr<byte[]> buffer, size_t size)
+	    : m_buffer_(std::move(buffer))
+	    , m_data_(m_buffer_.get())
+	    , m_size_(size)
+	{
+	}
+
+	/** @brief Parses the file while it is decoded, reads past the decoded part wait for it. */
+	LoadHelper(std::unique_ptr<PFileStream> stream)
+	    : m_stream_(std::move(stream))
+	{
 	}
 
 	bool IsValid(size_t size = 1)
 	{
-		return m_buffer_ != nullptr
-		    && m_size_ >= (m_cur_ + size);
+		if (m_size_ >= (m_cur_ + size))
+			return m_data_ != nullptr;
+		if (m_stream_ == nullptr)
+			return false;
+		m_size_ = m_stream_->WaitFor(m_cur_ + size);
+		m_data_ = m_stream_->Data();
+		return m_size_ >= (m_cur_ + size);
 	}
 
 	template <typename T>
@@ -116,7 +149,7 @@ public:
 		if (!IsValid(size))
 			return;
 
-		memcpy(bytes, &m_buffer_[m_cur_], size);
+		memcpy(bytes, &m_data_[m_cur_], size);
 		m_cur_ += size;
 	}
 
@@ -132,6 +165,15 @@ public:
 		return SwapBE(Next<T>());
 	}
 
+	template <class T>
+	T PeekLE()
+	{
+		const size_t cur = m_cur_;
+		const T value = NextLE<T>();
+		m_cur_ = cur;
+		return value;
+	}
+
 	bool NextBool8()
 	{
 		return Next<uint8_t>() != 0;
@@ -141,6 +183,22 @@ public:
 	{
 		return Next<uint32_t>() != 0;
 	}
+
+	/**
+	 * @brief Takes the next size bytes as one record, so its fields can be decoded without checking each of them.
+	 * @return The record, or zeros when the file ends before it, just like a single read past the end
+	 */
+	const byte *NextRecord(size_t size)
+	{
+		if (!IsValid(size)) {
+			m_scratch_.assign(size, byte { 0 });
+			return m_scratch_.data();
+		}
+
+		const byte *record = &m_data_[m_cur_];
+		m_cur_ += size;
+		return record;
+	}
 };
 
 class SaveHelper {
@@ -148,6 +206,7 @@ class SaveHelper {
 	std::unique_ptr<byte[]> m_buffer_;
 	size_t m_cur_ = 0;
 	size_t m_capacity_;
+	std::vector<byte> m_scratch_;
 
 public:
 	SaveHelper(const char *szFileName, size_t bufferLen)
@@ -198,97 +257,817 @@ public:
 		WriteBytes(&value, sizeof(value));
 	}
 
+	/**
+	 * @brief Reserves the next len bytes for one record, so its fields can be encoded without checking each of them.
+	 * @return Where to write the record, a record that does not fit is dropped like any other write
+	 */
+	byte *NextRecord(size_t len)
+	{
+		if (!IsValid(len)) {
+			m_scratch_.resize(len);
+			return m_scratch_.data();
+		}
+
+		byte *record = &m_buffer_[m_cur_];
+		m_cur_ += len;
+		return record;
+	}
+
+	size_t Position() const
+	{
+		return m_cur_;
+	}
+
+	const byte *Data() const
+	{
+		return m_buffer_.get();
+	}
+
+	/** @brief Drops what was written instead of storing it in the save file. */
+	void Discard()
+	{
+		m_buffer_ = nullptr;
+	}
+
 	~SaveHelper()
 	{
-		const auto encodedLen = codec_get_encoded_len(m_cur_);
-		const char *const password = pfile_get_password();
-		codec_encode(m_buffer_.get(), m_cur_, encodedLen, password);
-		CurrentSaveArchive().WriteFile(m_szFileName_, m_buffer_.get(), encodedLen);
+		if (m_buffer_ == nullptr)
+			return;
+		// Encrypted data does not compress, so it is stored as is
+		pfile_write_file(m_szFileName_, std::move(m_buffer_), m_cur_, CompressionCodec::None);
+	}
+};
+
+/**
+ * @brief Decodes the fields of one record, the buffer was checked to hold the whole record up front.
+ */
+class RecordReader {
+	const byte *m_cur_;
+
+	template <class Disk>
+	Disk Next()
+	{
+		Disk value;
+		memcpy(&value, m_cur_, sizeof(value));
+		m_cur_ += sizeof(value);
+		return SwapLE(value);
+	}
+
+public:
+	static constexpr bool IsSaving = false;
+
+	explicit RecordReader(const byte *record)
+	    : m_cur_(record)
+	{
+	}
+
+	template <class Disk, class T>
+	void Field(T &value)
+	{
+		value = static_cast<T>(Next<Disk>());
+	}
+
+	template <class Disk, class T, class Encode>
+	void Field(T &value, Encode /*encode*/)
+	{
+		Field<Disk>(value);
+	}
+
+	template <class Disk, class T, class Encode, class Decode>
+	void Field(T &value, Encode /*encode*/, Decode decode)
+	{
+		value = decode(Next<Disk>());
+	}
+
+	template <class Disk, class T>
+	void Written(const T & /*value*/)
+	{
+		m_cur_ += sizeof(Disk);
+	}
+
+	void Skip(size_t size)
+	{
+		m_cur_ += size;
+	}
+
+	void Bytes(void *bytes, size_t size)
+	{
+		memcpy(bytes, m_cur_, size);
+		m_cur_ += size;
+	}
+};
+
+/**
+ * @brief Encodes the fields of one record into a buffer that was reserved for the whole record up front.
+ */
+class RecordWriter {
+	byte *m_cur_;
+
+	template <class Disk>
+	void Write(Disk value)
+	{
+		value = SwapLE(value);
+		memcpy(m_cur_, &value, sizeof(value));
+		m_cur_ += sizeof(value);
+	}
+
+public:
+	static constexpr bool IsSaving = true;
+
+	explicit RecordWriter(byte *record)
+	    : m_cur_(record)
+	{
+	}
+
+	template <class Disk, class T>
+	void Field(const T &value)
+	{
+		Write(static_cast<Disk>(value));
+	}
+
+	template <class Disk, class T, class Encode, class... Decode>
+	void Field(const T &value, Encode encode, Decode... /*decode*/)
+	{
+		Write(static_cast<Disk>(encode(value)));
+	}
+
+	template <class Disk, class T>
+	void Written(const T &value)
+	{
+		Write(static_cast<Disk>(value));
+	}
+
+	void Skip(size_t len)
+	{
+		std::memset(m_cur_, 0, len);
+		m_cur_ += len;
+	}
+
+	void Bytes(const void *bytes, size_t len)
+	{
+		memcpy(m_cur_, bytes, len);
+		m_cur_ += len;
+	}
+};
+
+/**
+ * @brief Adds up how many bytes a record layout takes on disk.
+ */
+class RecordSizer {
+	size_t m_size_ = 0;
+
+public:
+	static constexpr bool IsSaving = false;
+
+	template <class Disk, class T, class... Codec>
+	void Field(const T & /*value*/, Codec... /*codec*/)
+	{
+		m_size_ += sizeof(Disk);
+	}
+
+	template <class Disk, class T>
+	void Written(const T & /*value*/)
+	{
+		m_size_ += sizeof(Disk);
+	}
+
+	void Skip(size_t size)
+	{
+		m_size_ += size;
+	}
+
+	void Bytes(const void * /*bytes*/, size_t size)
+	{
+		m_size_ += size;
+	}
+
+	size_t Size() const
+	{
+		return m_size_;
+	}
+};
+
+/**
+ * @brief A member stored as Disk, optionally passed through encode when saving and decode when loading.
+ */
+template <class Disk, class Record, class T, class... Codec>
+void Field(Record &record, T &value, Codec... codec)
+{
+	record.template Field<Disk>(value, codec...);
+}
+
+/** @brief A value that is stored for compatibility and ignored when loading. */
+template <class Disk, class Record, class T>
+void Written(Record &record, const T &value)
+{
+	record.template Written<Disk>(value);
+}
+
+/** @brief Bytes that are zero on disk and ignored when loading (alignment, pointers, unused members). */
+template <class Record>
+void Skip(Record &record, size_t size)
+{
+	record.Skip(size);
+}
+
+template <class Record, class T, size_t N>
+void Bytes(Record &record, T (&bytes)[N])
+{
+	record.Bytes(bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Size of the layout on disk.
+ *
+ * Counted for every record, as a layout may depend on the game or the save version. The sizer only adds up
+ * constants, so this folds to a constant wherever the layout is fixed.
+ */
+template <class Layout, class T>
+size_t RecordSize(const Layout &layout, T &value)
+{
+	RecordSizer sizer;
+	layout(sizer, value);
+	return sizer.Size();
+}
+
+template <class Layout, class T>
+void ReadRecord(LoadHelper &file, T &value, const Layout &layout = {})
+{
+	RecordReader reader(file.NextRecord(RecordSize(layout, value)));
+	layout(reader, value);
+}
+
+template <class Layout, class T>
+void WriteRecord(SaveHelper &file, const T &value, const Layout &layout = {})
+{
+	RecordWriter writer(file.NextRecord(RecordSize(layout, value)));
+	layout(writer, value);
+}
+
+_item_indexes ItemIndexFromSave(int32_t idx)
+{
+	auto itemIndex = static_cast<_item_indexes>(idx);
+	if (gbIsSpawn)
+		itemIndex = RemapItemIdxFromSpawn(itemIndex);
+	if (!gbIsHellfireSaveGame)
+		itemIndex = RemapItemIdxFromDiablo(itemIndex);
+	return itemIndex;
+}
+
+/**
+ * @return The index in the game the save is for, IDI_NONE when that game does not have the item
+ */
+_item_indexes RemapItemIdxForSave(_item_indexes itemIndex)
+{
+	if (!gbIsHellfire)
+		itemIndex = RemapItemIdxToDiablo(itemIndex);
+	if (gbIsSpawn)
+		itemIndex = RemapItemIdxToSpawn(itemIndex);
+	return itemIndex;
+}
+
+_item_indexes ItemIndexToSave(_item_indexes itemIndex)
+{
+	itemIndex = RemapItemIdxForSave(itemIndex);
+	// Items the game does not have are stored as empty gold
+	return itemIndex == IDI_NONE ? IDI_GOLD : itemIndex;
+}
+
+uint8_t ClampToUint8(uint16_t value)
+{
+	return static_cast<uint8_t>(std::min<uint16_t>(value, std::numeric_limits<uint8_t>::max()));
+}
+
+/**
+ * @brief The layout of Item, without the Hellfire-only _iDamAcFlags that follows it.
+ */
+struct ItemLayout {
+	template <class Record, class TItem>
+	void operator()(Record &r, TItem &item) const
+	{
+		Field<int32_t>(r, item._iSeed);
+		Field<uint16_t>(r, item._iCreateInfo);
+		Skip(r, 2); // Alignment
+		Field<uint32_t>(r, item._itype, [&item](ItemType itemType) {
+			return RemapItemIdxForSave(item.IDidx) == IDI_NONE ? ItemType::None : itemType;
+		});
+		Field<int32_t>(r, item.position.x);
+		Field<int32_t>(r, item.position.y);
+		Field<uint32_t>(r, item._iAnimFlag);
+		Skip(r, 4); // Skip pointer _iAnimData
+		Field<int32_t>(r, item.AnimInfo.NumberOfFrames);
+		Field<int32_t>(r, item.AnimInfo.CurrentFrame);
+		Written<int32_t>(r, ItemAnimWidth);                  // _iAnimWidth for vanilla compatibility
+		Written<int32_t>(r, CalculateWidth2(ItemAnimWidth)); // _iAnimWidth2 for vanilla compatibility
+		Skip(r, 4);                                          // _delFlag, unused since 1.02
+		Field<uint8_t>(r, item._iSelFlag);
+		Skip(r, 3); // Alignment
+		Field<uint32_t>(r, item._iPostDraw);
+		Field<uint32_t>(r, item._iIdentified);
+		Field<int8_t>(r, item._iMagical);
+		Bytes(r, item._iName);
+		Bytes(r, item._iIName);
+		Field<int8_t>(r, item._iLoc);
+		Field<uint8_t>(r, item._iClass);
+		Skip(r, 1); // Alignment
+		Field<int32_t>(r, item._iCurs);
+		Field<int32_t>(r, item._ivalue);
+		Field<int32_t>(r, item._iIvalue);
+		Field<int32_t>(r, item._iMinDam);
+		Field<int32_t>(r, item._iMaxDam);
+		Field<int32_t>(r, item._iAC);
+		Field<uint32_t>(r, item._iFlags);
+		Field<int32_t>(r, item._iMiscId);
+		Field<int32_t>(r, item._iSpell);
+		Field<int32_t>(r, item._iCharges);
+		Field<int32_t>(r, item._iMaxCharges);
+		Field<int32_t>(r, item._iDurability);
+		Field<int32_t>(r, item._iMaxDur);
+		Field<int32_t>(r, item._iPLDam);
+		Field<int32_t>(r, item._iPLToHit);
+		Field<int32_t>(r, item._iPLAC);
+		Field<int32_t>(r, item._iPLStr);
+		Field<int32_t>(r, item._iPLMag);
+		Field<int32_t>(r, item._iPLDex);
+		Field<int32_t>(r, item._iPLVit);
+		Field<int32_t>(r, item._iPLFR);
+		Field<int32_t>(r, item._iPLLR);
+		Field<int32_t>(r, item._iPLMR);
+		Field<int32_t>(r, item._iPLMana);
+		Field<int32_t>(r, item._iPLHP);
+		Field<int32_t>(r, item._iPLDamMod);
+		Field<int32_t>(r, item._iPLGetHit);
+		Field<int32_t>(r, item._iPLLight);
+		Field<int8_t>(r, item._iSplLvlAdd);
+		Field<int8_t>(r, item._iRequest);
+		Skip(r, 2); // Alignment
+		Field<int32_t>(r, item._iUid);
+		Field<int32_t>(r, item._iFMinDam);
+		Field<int32_t>(r, item._iFMaxDam);
+		Field<int32_t>(r, item._iLMinDam);
+		Field<int32_t>(r, item._iLMaxDam);
+		Field<int32_t>(r, item._iPLEnAc);
+		Field<int8_t>(r, item._iPrePower);
+		Field<int8_t>(r, item._iSufPower);
+		Skip(r, 2); // Alignment
+		Field<int32_t>(r, item._iVAdd1);
+		Field<int32_t>(r, item._iVMult1);
+		Field<int32_t>(r, item._iVAdd2);
+		Field<int32_t>(r, item._iVMult2);
+		Field<int8_t>(r, item._iMinStr);
+		Field<uint8_t>(r, item._iMinMag);
+		Field<int8_t>(r, item._iMinDex);
+		Skip(r, 1); // Alignment
+		Field<uint32_t>(r, item._iStatFlag);
+		Field<int32_t>(r, item.IDidx, ItemIndexToSave, ItemIndexFromSave);
+		Field<uint32_t>(r, item.dwBuff);
+	}
+};
+
+/**
+ * @brief The layout of Player up to the visited levels, whose count depends on the game.
+ */
+struct PlayerLayout {
+	template <class Record, class TPlayer>
+	void operator()(Record &r, TPlayer &player) const
+	{
+		Field<int32_t>(r, player._pmode);
+		for (auto &step : player.walkpath)
+			Field<int8_t>(r, step);
+		Field<uint8_t>(r, player.plractive);
+		Skip(r, 2); // Alignment
+		Field<int32_t>(r, player.destAction);
+		Field<int32_t>(r, player.destParam1);
+		Field<int32_t>(r, player.destParam2);
+		Field<int32_t>(r, player.destParam3);
+		Field<int32_t>(r, player.destParam4);
+		Field<uint32_t>(r, player.plrlevel);
+		Field<int32_t>(r, player.position.tile.x);
+		Field<int32_t>(r, player.position.tile.y);
+		Field<int32_t>(r, player.position.future.x);
+		Field<int32_t>(r, player.position.future.y);
+
+		// _ptargx and _ptargy, for backwards compatibility
+		const Point target = Record::IsSaving ? player.GetTargetPosition() : Point { 0, 0 };
+		Written<int32_t>(r, target.x);
+		Written<int32_t>(r, target.y);
+
+		Field<int32_t>(r, player.position.last.x);
+		Field<int32_t>(r, player.position.last.y);
+		Field<int32_t>(r, player.position.old.x);
+		Field<int32_t>(r, player.position.old.y);
+		Field<int32_t>(r, player.position.offset.deltaX);
+		Field<int32_t>(r, player.position.offset.deltaY);
+		Field<int32_t>(r, player.position.velocity.deltaX);
+		Field<int32_t>(r, player.position.velocity.deltaY);
+		Field<int32_t>(r, player._pdir);
+		Skip(r, 4); // Unused
+		Field<int32_t>(r, player._pgfxnum);
+		Skip(r, 4); // Skip pointer _pAnimData
+		Field<int32_t>(
+		    r, player.AnimInfo.TicksPerFrame,
+		    [](int ticksPerFrame) { return std::max(0, ticksPerFrame - 1); },
+		    [](int32_t ticksPerFrame) { return ticksPerFrame + 1; });
+		Field<int32_t>(r, player.AnimInfo.TickCounterOfCurrentFrame);
+		Field<int32_t>(r, player.AnimInfo.NumberOfFrames);
+		Field<int32_t>(r, player.AnimInfo.CurrentFrame);
+		// _pAnimWidth and _pAnimWidth2 for vanilla compatibility
+		const int animWidth = player.AnimInfo.pCelSprite == nullptr ? 96 : player.AnimInfo.pCelSprite->Width();
+		Written<int32_t>(r, animWidth);
+		Written<int32_t>(r, CalculateWidth2(animWidth));
+		Skip(r, 4); // Skip _peflag
+		Field<int32_t>(r, player._plid);
+		Field<int32_t>(r, player._pvid);
+
+		Field<int32_t>(r, player._pSpell);
+		Field<int8_t>(r, player._pSplType);
+		Field<int8_t>(r, player._pSplFrom);
+		Skip(r, 2); // Alignment
+		Field<int32_t>(r, player._pTSpell);
+		Skip(r, 1); // Skip _pTSplType
+		Skip(r, 3); // Alignment
+		Field<int32_t>(r, player._pRSpell);
+		Field<int8_t>(r, player._pRSplType);
+		Skip(r, 3); // Alignment
+		Field<int32_t>(r, player._pSBkSpell);
+		Skip(r, 1); // Skip _pSBkSplType
+		for (auto &spellLevel : player._pSplLvl)
+			Field<int8_t>(r, spellLevel);
+		Skip(r, 7); // Alignment
+		Field<uint64_t>(r, player._pMemSpells);
+		Field<uint64_t>(r, player._pAblSpells);
+		Field<uint64_t>(r, player._pScrlSpells);
+		Field<uint8_t>(r, player._pSpellFlags);
+		Skip(r, 3); // Alignment
+
+		for (auto &spellId : player._pSplHotKey)
+			Field<int32_t>(r, spellId);
+		for (auto &spellType : player._pSplTHotKey)
+			Field<int8_t>(r, spellType);
+
+		Written<int32_t>(r, player.UsesRangedWeapon() ? 1 : 0); // _pwtype
+		Field<uint8_t>(r, player._pBlockFlag);
+		Field<uint8_t>(r, player._pInvincible);
+		Field<int8_t>(r, player._pLightRad);
+		Field<uint8_t>(r, player._pLvlChanging);
+
+		Bytes(r, player._pName);
+		Field<int8_t>(r, player._pClass);
+		Skip(r, 3); // Alignment
+		Field<int32_t>(r, player._pStrength);
+		Field<int32_t>(r, player._pBaseStr);
+		Field<int32_t>(r, player._pMagic);
+		Field<int32_t>(r, player._pBaseMag);
+		Field<int32_t>(r, player._pDexterity);
+		Field<int32_t>(r, player._pBaseDex);
+		Field<int32_t>(r, player._pVitality);
+		Field<int32_t>(r, player._pBaseVit);
+		Field<int32_t>(r, player._pStatPts);
+		Field<int32_t>(r, player._pDamageMod);
+		Field<int32_t>(r, player._pBaseToBlk);
+		Field<int32_t>(r, player._pHPBase);
+		Field<int32_t>(r, player._pMaxHPBase);
+		Field<int32_t>(r, player._pHitPoints);
+		Field<int32_t>(r, player._pMaxHP);
+		Skip(r, 4); // Skip _pHPPer - always derived from hp and maxHP.
+		Field<int32_t>(r, player._pManaBase);
+		Field<int32_t>(r, player._pMaxManaBase);
+		Field<int32_t>(r, player._pMana);
+		Field<int32_t>(r, player._pMaxMana);
+		Skip(r, 4); // Skip _pManaPer - always derived from mana and maxMana
+		Field<int8_t>(r, player._pLevel);
+		Field<int8_t>(r, player._pMaxLvl);
+		Skip(r, 2); // Alignment
+		Field<uint32_t>(r, player._pExperience);
+		Skip(r, 4);                               // Skip _pMaxExp - unused
+		Field<uint32_t>(r, player._pNextExper); // This can be calculated based on pLevel (which in turn could be calculated based on pExperience)
+		Field<int8_t>(r, player._pArmorClass);
+		Field<int8_t>(r, player._pMagResist);
+		Field<int8_t>(r, player._pFireResist);
+		Field<int8_t>(r, player._pLghtResist);
+		Field<int32_t>(r, player._pGold);
+
+		Field<uint32_t>(r, player._pInfraFlag);
+		Field<int32_t>(r, player.position.temp.x);
+		Field<int32_t>(r, player.position.temp.y);
+		Field<int32_t>(r, player.tempDirection);
+		Field<int32_t>(r, player.spellLevel);
+		Skip(r, 4); // skip _pVar5, was used for storing position of a tile which should have its HorizontalMovingPlayer flag removed after walking
+		Field<int32_t>(r, player.position.offset2.deltaX);
+		Field<int32_t>(r, player.position.offset2.deltaY);
+		Skip(r, 4); // Skip actionFrame
+	}
+};
+
+/**
+ * @brief The animation frame counts of Player, between the visited levels and the inventory.
+ */
+struct PlayerFramesLayout {
+	template <class Record, class TPlayer>
+	void operator()(Record &r, TPlayer &player) const
+	{
+		Skip(r, 2);     // Alignment
+		Skip(r, 4);     // Skip _pGFXLoad
+		Skip(r, 4 * 8); // Skip pointers _pNAnim
+		Field<int32_t>(r, player._pNFrames);
+		Skip(r, 4);     // Skip _pNWidth
+		Skip(r, 4 * 8); // Skip pointers _pWAnim
+		Field<int32_t>(r, player._pWFrames);
+		Skip(r, 4);     // Skip _pWWidth
+		Skip(r, 4 * 8); // Skip pointers _pAAnim
+		Field<int32_t>(r, player._pAFrames);
+		Skip(r, 4); // Skip _pAWidth
+		Field<int32_t>(r, player._pAFNum);
+		Skip(r, 4 * 8); // Skip pointers _pLAnim
+		Skip(r, 4 * 8); // Skip pointers _pFAnim
+		Skip(r, 4 * 8); // Skip pointers _pTAnim
+		Field<int32_t>(r, player._pSFrames);
+		Skip(r, 4); // Skip _pSWidth
+		Field<int32_t>(r, player._pSFNum);
+		Skip(r, 4 * 8); // Skip pointers _pHAnim
+		Field<int32_t>(r, player._pHFrames);
+		Skip(r, 4);     // Skip _pHWidth
+		Skip(r, 4 * 8); // Skip pointers _pDAnim
+		Field<int32_t>(r, player._pDFrames);
+		Skip(r, 4);     // Skip _pDWidth
+		Skip(r, 4 * 8); // Skip pointers _pBAnim
+		Field<int32_t>(r, player._pBFrames);
+		Skip(r, 4); // Skip _pBWidth
+	}
+};
+
+struct PlayerInvGridLayout {
+	template <class Record, class TPlayer>
+	void operator()(Record &r, TPlayer &player) const
+	{
+		Field<int32_t>(r, player._pNumInv);
+		for (auto &cell : player.InvGrid)
+			Field<int8_t>(r, cell);
+	}
+};
+
+/**
+ * @brief The layout of Player after its items, one byte holds pDungMsgs2 in Hellfire saves and pBattleNet otherwise.
+ */
+struct PlayerItemStatsLayout {
+	bool hellfire;
+
+	template <class Record, class TPlayer>
+	void operator()(Record &r, TPlayer &player) const
+	{
+		Field<int32_t>(r, player._pIMinDam);
+		Field<int32_t>(r, player._pIMaxDam);
+		Field<int32_t>(r, player._pIAC);
+		Field<int32_t>(r, player._pIBonusDam);
+		Field<int32_t>(r, player._pIBonusToHit);
+		Field<int32_t>(r, player._pIBonusAC);
+		Field<int32_t>(r, player._pIBonusDamMod);
+		Skip(r, 4); // Alignment
+
+		Field<uint64_t>(r, player._pISpells);
+		Field<int32_t>(r, player._pIFlags);
+		Field<int32_t>(r, player._pIGetHit);
+		Field<int8_t>(r, player._pISplLvlAdd);
+		Skip(r, 1); // Skip _pISplCost
+		Skip(r, 2); // Alignment
+		Field<int32_t>(r, player._pISplDur);
+		Field<int32_t>(r, player._pIEnAc);
+		Field<int32_t>(r, player._pIFMinDam);
+		Field<int32_t>(r, player._pIFMaxDam);
+		Field<int32_t>(r, player._pILMinDam);
+		Field<int32_t>(r, player._pILMaxDam);
+		Field<int32_t>(r, player._pOilType);
+		Field<uint8_t>(r, player.pTownWarps);
+		Field<uint8_t>(r, player.pDungMsgs);
+		Field<uint8_t>(r, player.pLvlLoad);
+		if (hellfire)
+			Field<uint8_t>(r, player.pDungMsgs2);
+		else
+			Field<uint8_t>(r, player.pBattleNet);
+		Field<uint8_t>(r, player.pManaShield);
+		Field<uint8_t>(r, player.pOriginalCathedral);
+		Skip(r, 2); // Available bytes
+		Field<uint16_t>(r, player.wReflections);
+		Skip(r, 14); // Available bytes
+
+		Field<uint32_t>(r, player.pDiabloKillLevel);
+		Field<uint32_t>(r, player.pDifficulty);
+		Field<uint32_t>(r, player.pDamAcFlags);
+		Skip(r, 20); // Available bytes
+
+		// Omit pointer _pNData
+		// Omit pointer _pWData
+		// Omit pointer _pAData
+		// Omit pointer _pLData
+		// Omit pointer _pFData
+		// Omit pointer  _pTData
+		// Omit pointer _pHData
+		// Omit pointer _pDData
+		// Omit pointer _pBData
+		// Omit pointer pReserved
+	}
+};
+
+struct MonsterLayout {
+	template <class Record, class TMonster>
+	void operator()(Record &r, TMonster &monster) const
+	{
+		Field<int32_t>(r, monster._mMTidx);
+		Field<int32_t>(r, monster._mmode);
+		Field<uint8_t>(r, monster._mgoal);
+		Skip(r, 3); // Alignment
+		Field<int32_t>(r, monster._mgoalvar1);
+		Field<int32_t>(r, monster._mgoalvar2);
+		Field<int32_t>(r, monster._mgoalvar3);
+		Skip(r, 4); // Unused
+		Field<uint8_t>(r, monster._pathcount);
+		Skip(r, 3); // Alignment
+		Field<int32_t>(r, monster.position.tile.x);
+		Field<int32_t>(r, monster.position.tile.y);
+		Field<int32_t>(r, monster.position.future.x);
+		Field<int32_t>(r, monster.position.future.y);
+		Field<int32_t>(r, monster.position.old.x);
+		Field<int32_t>(r, monster.position.old.y);
+		Field<int32_t>(r, monster.position.offset.deltaX);
+		Field<int32_t>(r, monster.position.offset.deltaY);
+		Field<int32_t>(r, monster.position.velocity.deltaX);
+		Field<int32_t>(r, monster.position.velocity.deltaY);
+		Field<int32_t>(r, monster._mdir);
+		Field<int32_t>(r, monster._menemy);
+		Field<uint8_t>(r, monster.enemyPosition.x);
+		Field<uint8_t>(r, monster.enemyPosition.y);
+		Skip(r, 2); // Unused
+
+		Skip(r, 4); // Skip pointer _mAnimData
+		Field<int32_t>(r, monster.AnimInfo.TicksPerFrame);
+		Field<int32_t>(r, monster.AnimInfo.TickCounterOfCurrentFrame);
+		Field<int32_t>(r, monster.AnimInfo.NumberOfFrames);
+		Field<int32_t>(r, monster.AnimInfo.CurrentFrame);
+		Skip(r, 4); // Skip _meflag
+		Field<uint32_t>(r, monster._mDelFlag);
+		Field<int32_t>(r, monster._mVar1);
+		Field<int32_t>(r, monster._mVar2);
+		Field<int32_t>(r, monster._mVar3);
+		Field<int32_t>(r, monster.position.temp.x);
+		Field<int32_t>(r, monster.position.temp.y);
+		Field<int32_t>(r, monster.position.offset2.deltaX);
+		Field<int32_t>(r, monster.position.offset2.deltaY);
+		Skip(r, 4); // Skip actionFrame
+		Field<int32_t>(r, monster._mmaxhp);
+		Field<int32_t>(r, monster._mhitpoints);
+
+		Field<uint8_t>(r, monster._mAi);
+		Field<uint8_t>(r, monster._mint);
+		Skip(r, 2); // Alignment
+		Field<uint32_t>(r, monster._mFlags);
+		Field<uint8_t>(r, monster._msquelch);
+		Skip(r, 3); // Alignment
+		Skip(r, 4); // Unused
+		Field<int32_t>(r, monster.position.last.x);
+		Field<int32_t>(r, monster.position.last.y);
+		Field<uint32_t>(r, monster._mRndSeed);
+		Field<uint32_t>(r, monster._mAISeed);
+		Skip(r, 4); // Unused
+
+		Field<uint8_t>(r, monster._uniqtype);
+		Field<uint8_t>(r, monster._uniqtrans);
+		Field<int8_t>(r, monster._udeadval);
+
+		Field<int8_t>(r, monster.mWhoHit);
+		Field<int8_t>(r, monster.mLevel);
+		Skip(r, 1); // Alignment
+		Field<uint16_t>(r, monster.mExp);
+
+		// mHit and mHit2 are clamped for backwards compatibility, they are already initialized except for golems
+		Field<uint8_t>(r, monster.mHit, ClampToUint8, [&monster](uint8_t hit) -> uint16_t {
+			return (monster._mFlags & MFLAG_GOLEM) != 0 ? hit : monster.mHit;
+		});
+		Field<uint8_t>(r, monster.mMinDamage);
+		Field<uint8_t>(r, monster.mMaxDamage);
+		Written<uint8_t>(r, ClampToUint8(monster.mHit2));
+		Field<uint8_t>(r, monster.mMinDamage2);
+		Field<uint8_t>(r, monster.mMaxDamage2);
+		Field<uint8_t>(r, monster.mArmorClass);
+		Skip(r, 1); // Alignment
+		Field<uint16_t>(r, monster.mMagicRes);
+		Skip(r, 2); // Alignment
+
+		// Replicate original bad mapping of none for monsters
+		Field<int32_t>(
+		    r, monster.mtalkmsg,
+		    [](_speech_id talkMessage) { return talkMessage == TEXT_NONE ? TEXT_KING1 : talkMessage; },
+		    [](int32_t talkMessage) { return talkMessage == TEXT_KING1 ? TEXT_NONE : static_cast<_speech_id>(talkMessage); });
+		Field<uint8_t>(r, monster.leader);
+		Field<uint8_t>(r, monster.leaderRelation);
+		Field<uint8_t>(r, monster.packsize);
+		// vanilla compatibility, older saves also stored 0 for no light
+		Field<int8_t>(
+		    r, monster.mlid,
+		    [](int8_t lightId) -> int8_t { return lightId == NO_LIGHT ? 0 : lightId; },
+		    [](int8_t lightId) -> int8_t { return lightId == 0 ? NO_LIGHT : lightId; });
+
+		// Omit pointer mName;
+		// Omit pointer MType;
+		// Omit pointer MData;
+	}
+};
+
+struct MissileLayout {
+	template <class Record, class TMissile>
+	void operator()(Record &r, TMissile &missile) const
+	{
+		Field<int32_t>(r, missile._mitype);
+		Field<int32_t>(r, missile.position.tile.x);
+		Field<int32_t>(r, missile.position.tile.y);
+		Field<int32_t>(r, missile.position.offset.deltaX);
+		Field<int32_t>(r, missile.position.offset.deltaY);
+		Field<int32_t>(r, missile.position.velocity.deltaX);
+		Field<int32_t>(r, missile.position.velocity.deltaY);
+		Field<int32_t>(r, missile.position.start.x);
+		Field<int32_t>(r, missile.position.start.y);
+		Field<int32_t>(r, missile.position.traveled.deltaX);
+		Field<int32_t>(r, missile.position.traveled.deltaY);
+		Field<int32_t>(r, missile._mimfnum);
+		Field<int32_t>(r, missile._mispllvl);
+		Field<uint32_t>(r, missile._miDelFlag);
+		Field<uint8_t>(r, missile._miAnimType);
+		Skip(r, 3); // Alignment
+		Field<int32_t>(r, missile._miAnimFlags);
+		Skip(r, 4); // Skip pointer _miAnimData
+		Field<int32_t>(r, missile._miAnimDelay);
+		Field<int32_t>(r, missile._miAnimLen);
+		Field<int32_t>(r, missile._miAnimWidth);
+		Field<int32_t>(r, missile._miAnimWidth2);
+		Field<int32_t>(r, missile._miAnimCnt);
+		Field<int32_t>(r, missile._miAnimAdd);
+		Field<int32_t>(r, missile._miAnimFrame);
+		Field<uint32_t>(r, missile._miDrawFlag);
+		Field<uint32_t>(r, missile._miLightFlag);
+		Field<uint32_t>(r, missile._miPreFlag);
+		Field<uint32_t>(r, missile._miUniqTrans);
+		Field<int32_t>(r, missile._mirange);
+		Field<int32_t>(r, missile._misource);
+		Field<int32_t>(r, missile._micaster);
+		Field<int32_t>(r, missile._midam);
+		Field<uint32_t>(r, missile._miHitFlag);
+		Field<int32_t>(r, missile._midist);
+		Field<int32_t>(r, missile._mlid);
+		Field<int32_t>(r, missile._mirnd);
+		Field<int32_t>(r, missile.var1);
+		Field<int32_t>(r, missile.var2);
+		Field<int32_t>(r, missile.var3);
+		Field<int32_t>(r, missile.var4);
+		Field<int32_t>(r, missile.var5);
+		Field<int32_t>(r, missile.var6);
+		Field<int32_t>(r, missile.var7);
+		Field<uint32_t>(r, missile.limitReached);
+	}
+};
+
+struct ObjectLayout {
+	template <class Record, class TObject>
+	void operator()(Record &r, TObject &object) const
+	{
+		Field<int32_t>(r, object._otype);
+		Field<int32_t>(r, object.position.x);
+		Field<int32_t>(r, object.position.y);
+		Field<uint32_t>(r, object._oLight);
+		Field<uint32_t>(r, object._oAnimFlag);
+		Skip(r, 4); // Skip pointer _oAnimData
+		Field<int32_t>(r, object._oAnimDelay);
+		Field<int32_t>(r, object._oAnimCnt);
+		Field<uint32_t>(r, object._oAnimLen);
+		Field<uint32_t>(r, object._oAnimFrame);
+		Field<int32_t>(r, object._oAnimWidth);
+		Written<int32_t>(r, CalculateWidth2(object._oAnimWidth)); // _oAnimWidth2 for vanilla compatibility
+		Field<uint32_t>(r, object._oDelFlag);
+		Field<int8_t>(r, object._oBreak);
+		Skip(r, 3); // Alignment
+		Field<uint32_t>(r, object._oSolidFlag);
+		Field<uint32_t>(r, object._oMissFlag);
+
+		Field<int8_t>(r, object._oSelFlag);
+		Skip(r, 3); // Alignment
+		Field<uint32_t>(r, object._oPreFlag);
+		Field<uint32_t>(r, object._oTrapFlag);
+		Field<uint32_t>(r, object._oDoorFlag);
+		Field<int32_t>(r, object._olid);
+		Field<uint32_t>(r, object._oRndSeed);
+		Field<int32_t>(r, object._oVar1);
+		Field<int32_t>(r, object._oVar2);
+		Field<int32_t>(r, object._oVar3);
+		Field<int32_t>(r, object._oVar4);
+		Field<int32_t>(r, object._oVar5);
+		Field<uint32_t>(r, object._oVar6);
+		Field<int32_t>(r, object.bookMessage);
+		Field<int32_t>(r, object._oVar8);
 	}
 };
 
 void LoadItemData(LoadHelper &file, Item &item)
 {
-	item._iSeed = file.NextLE<int32_t>();
-	item._iCreateInfo = file.NextLE<uint16_t>();
-	file.Skip(2); // Alignment
-	item._itype = static_cast<ItemType>(file.NextLE<uint32_t>());
-	item.position.x = file.NextLE<int32_t>();
-	item.position.y = file.NextLE<int32_t>();
-	item._iAnimFlag = file.NextBool32();
-	file.Skip(4); // Skip pointer _iAnimData
 	item.AnimInfo = {};
-	item.AnimInfo.NumberOfFrames = file.NextLE<int32_t>();
-	item.AnimInfo.CurrentFrame = file.NextLE<int32_t>();
-	file.Skip(8); // Skip _iAnimWidth and _iAnimWidth2
-	file.Skip(4); // Unused since 1.02
-	item._iSelFlag = file.NextLE<uint8_t>();
-	file.Skip(3); // Alignment
-	item._iPostDraw = file.NextBool32();
-	item._iIdentified = file.NextBool32();
-	item._iMagical = static_cast<item_quality>(file.NextLE<int8_t>());
-	file.NextBytes(item._iName, 64);
-	file.NextBytes(item._iIName, 64);
-	item._iLoc = static_cast<item_equip_type>(file.NextLE<int8_t>());
-	item._iClass = static_cast<item_class>(file.NextLE<uint8_t>());
-	file.Skip(1); // Alignment
-	item._iCurs = file.NextLE<int32_t>();
-	item._ivalue = file.NextLE<int32_t>();
-	item._iIvalue = file.NextLE<int32_t>();
-	item._iMinDam = file.NextLE<int32_t>();
-	item._iMaxDam = file.NextLE<int32_t>();
-	item._iAC = file.NextLE<int32_t>();
-	item._iFlags = file.NextLE<uint32_t>();
-	item._iMiscId = static_cast<item_misc_id>(file.NextLE<int32_t>());
-	item._iSpell = static_cast<spell_id>(file.NextLE<int32_t>());
-	item._iCharges = file.NextLE<int32_t>();
-	item._iMaxCharges = file.NextLE<int32_t>();
-	item._iDurability = file.NextLE<int32_t>();
-	item._iMaxDur = file.NextLE<int32_t>();
-	item._iPLDam = file.NextLE<int32_t>();
-	item._iPLToHit = file.NextLE<int32_t>();
-	item._iPLAC = file.NextLE<int32_t>();
-	item._iPLStr = file.NextLE<int32_t>();
-	item._iPLMag = file.NextLE<int32_t>();
-	item._iPLDex = file.NextLE<int32_t>();
-	item._iPLVit = file.NextLE<int32_t>();
-	item._iPLFR = file.NextLE<int32_t>();
-	item._iPLLR = file.NextLE<int32_t>();
-	item._iPLMR = file.NextLE<int32_t>();
-	item._iPLMana = file.NextLE<int32_t>();
-	item._iPLHP = file.NextLE<int32_t>();
-	item._iPLDamMod = file.NextLE<int32_t>();
-	item._iPLGetHit = file.NextLE<int32_t>();
-	item._iPLLight = file.NextLE<int32_t>();
-	item._iSplLvlAdd = file.NextLE<int8_t>();
-	item._iRequest = file.NextBool8();
-	file.Skip(2); // Alignment
-	item._iUid = file.NextLE<int32_t>();
-	item._iFMinDam = file.NextLE<int32_t>();
-	item._iFMaxDam = file.NextLE<int32_t>();
-	item._iLMinDam = file.NextLE<int32_t>();
-	item._iLMaxDam = file.NextLE<int32_t>();
-	item._iPLEnAc = file.NextLE<int32_t>();
-	item._iPrePower = static_cast<item_effect_type>(file.NextLE<int8_t>());
-	item._iSufPower = static_cast<item_effect_type>(file.NextLE<int8_t>());
-	file.Skip(2); // Alignment
-	item._iVAdd1 = file.NextLE<int32_t>();
-	item._iVMult1 = file.NextLE<int32_t>();
-	item._iVAdd2 = file.NextLE<int32_t>();
-	item._iVMult2 = file.NextLE<int32_t>();
-	item._iMinStr = file.NextLE<int8_t>();
-	item._iMinMag = file.NextLE<uint8_t>();
-	item._iMinDex = file.NextLE<int8_t>();
-	file.Skip(1); // Alignment
-	item._iStatFlag = file.NextBool32();
-	item.IDidx = static_cast<_item_indexes>(file.NextLE<int32_t>());
-	if (gbIsSpawn) {
-		item.IDidx = RemapItemIdxFromSpawn(item.IDidx);
-	}
-	if (!gbIsHellfireSaveGame) {
-		item.IDidx = RemapItemIdxFromDiablo(item.IDidx);
-	}
-	item.dwBuff = file.NextLE<uint32_t>();
+	ReadRecord<ItemLayout>(file, item);
 	if (gbIsHellfireSaveGame)
 		item._iDamAcFlags = file.NextLE<uint32_t>();
 	else
@@ -299,127 +1078,10 @@ void LoadItemData(LoadHelper &file, Item &item)
 
 void LoadPlayer(LoadHelper &file, Player &player)
 {
-	player._pmode = static_cast<PLR_MODE>(file.NextLE<int32_t>());
-
-	for (int8_t &step : player.walkpath) {
-		step = file.NextLE<int8_t>();
-	}
-	player.plractive = file.NextBool8();
-	file.Skip(2); // Alignment
-	player.destAction = static_cast<action_id>(file.NextLE<int32_t>());
-	player.destParam1 = file.NextLE<int32_t>();
-	player.destParam2 = file.NextLE<int32_t>();
-	player.destParam3 = file.NextLE<int32_t>();
-	player.destParam4 = file.NextLE<int32_t>();
-	player.plrlevel = file.NextLE<uint32_t>();
-	player.position.tile.x = file.NextLE<int32_t>();
-	player.position.tile.y = file.NextLE<int32_t>();
-	player.position.future.x = file.NextLE<int32_t>();
-	player.position.future.y = file.NextLE<int32_t>();
-	file.Skip(8); // Skip _ptargx and _ptargy
-	player.position.last.x = file.NextLE<int32_t>();
-	player.position.last.y = file.NextLE<int32_t>();
-	player.position.old.x = file.NextLE<int32_t>();
-	player.position.old.y = file.NextLE<int32_t>();
-	player.position.offset.deltaX = file.NextLE<int32_t>();
-	player.position.offset.deltaY = file.NextLE<int32_t>();
-	player.position.velocity.deltaX = file.NextLE<int32_t>();
-	player.position.velocity.deltaY = file.NextLE<int32_t>();
-	player._pdir = static_cast<Direction>(file.NextLE<int32_t>());
-	file.Skip(4); // Unused
-	player._pgfxnum = file.NextLE<int32_t>();
-	file.Skip(4); // Skip pointer pData
 	player.AnimInfo = {};
-	player.AnimInfo.TicksPerFrame = file.NextLE<int32_t>() + 1;
-	player.AnimInfo.TickCounterOfCurrentFrame = file.NextLE<int32_t>();
-	player.AnimInfo.NumberOfFrames = file.NextLE<int32_t>();
-	player.AnimInfo.CurrentFrame = file.NextLE<int32_t>();
-	file.Skip(4); // Skip _pAnimWidth
-	file.Skip(4); // Skip _pAnimWidth2
-	file.Skip(4); // Skip _peflag
-	player._plid = file.NextLE<int32_t>();
-	player._pvid = file.NextLE<int32_t>();
-
-	player._pSpell = static_cast<spell_id>(file.NextLE<int32_t>());
-	player._pSplType = static_cast<spell_type>(file.NextLE<int8_t>());
-	player._pSplFrom = file.NextLE<int8_t>();
-	file.Skip(2); // Alignment
-	player._pTSpell = static_cast<spell_id>(file.NextLE<int32_t>());
-	file.Skip<int8_t>(); // Skip _pTSplType
-	file.Skip(3);        // Alignment
-	player._pRSpell = static_cast<spell_id>(file.NextLE<int32_t>());
-	player._pRSplType = static_cast<spell_type>(file.NextLE<int8_t>());
-	file.Skip(3); // Alignment
-	player._pSBkSpell = static_cast<spell_id>(file.NextLE<int32_t>());
-	file.Skip<int8_t>(); // Skip _pSBkSplType
-	for (int8_t &spellLevel : player._pSplLvl)
-		spellLevel = file.NextLE<int8_t>();
-	file.Skip(7); // Alignment
-	player._pMemSpells = file.NextLE<uint64_t>();
-	player._pAblSpells = file.NextLE<uint64_t>();
-	player._pScrlSpells = file.NextLE<uint64_t>();
-	player._pSpellFlags = file.NextLE<uint8_t>();
-	file.Skip(3); // Alignment
-
-	for (auto &spell : player._pSplHotKey)
-		spell = static_cast<spell_id>(file.NextLE<int32_t>());
-
-	for (auto &spellType : player._pSplTHotKey)
-		spellType = static_cast<spell_type>(file.NextLE<int8_t>());
-
-	file.Skip<int32_t>(); // Skip _pwtype
-	player._pBlockFlag = file.NextBool8();
-	player._pInvincible = file.NextBool8();
-	player._pLightRad = file.NextLE<int8_t>();
-	player._pLvlChanging = file.NextBool8();
-
-	file.NextBytes(player._pName, PLR_NAME_LEN);
-	player._pClass = static_cast<HeroClass>(file.NextLE<int8_t>());
-	file.Skip(3); // Alignment
-	player._pStrength = file.NextLE<int32_t>();
-	player._pBaseStr = file.NextLE<int32_t>();
-	player._pMagic = file.NextLE<int32_t>();
-	player._pBaseMag = file.NextLE<int32_t>();
-	player._pDexterity = file.NextLE<int32_t>();
-	player._pBaseDex = file.NextLE<int32_t>();
-	player._pVitality = file.NextLE<int32_t>();
-	player._pBaseVit = file.NextLE<int32_t>();
-	player._pStatPts = file.NextLE<int32_t>();
-	player._pDamageMod = file.NextLE<int32_t>();
-	player._pBaseToBlk = file.NextLE<int32_t>();
+	ReadRecord<PlayerLayout>(file, player);
 	if (player._pBaseToBlk == 0)
 		player._pBaseToBlk = BlockBonuses[static_cast<std::size_t>(player._pClass)];
-	player._pHPBase = file.NextLE<int32_t>();
-	player._pMaxHPBase = file.NextLE<int32_t>();
-	player._pHitPoints = file.NextLE<int32_t>();
-	player._pMaxHP = file.NextLE<int32_t>();
-	file.Skip(sizeof(int32_t)); // Skip _pHPPer - always derived from hp and maxHP.
-	player._pManaBase = file.NextLE<int32_t>();
-	player._pMaxManaBase = file.NextLE<int32_t>();
-	player._pMana = file.NextLE<int32_t>();
-	player._pMaxMana = file.NextLE<int32_t>();
-	file.Skip(sizeof(int32_t)); // Skip _pManaPer - always derived from mana and maxMana
-	player._pLevel = file.NextLE<int8_t>();
-	player._pMaxLvl = file.NextLE<int8_t>();
-	file.Skip(2); // Alignment
-	player._pExperience = file.NextLE<uint32_t>();
-	file.Skip<uint32_t>();                        // Skip _pMaxExp - unused
-	player._pNextExper = file.NextLE<uint32_t>(); // This can be calculated based on pLevel (which in turn could be calculated based on pExperience)
-	player._pArmorClass = file.NextLE<int8_t>();
-	player._pMagResist = file.NextLE<int8_t>();
-	player._pFireResist = file.NextLE<int8_t>();
-	player._pLghtResist = file.NextLE<int8_t>();
-	player._pGold = file.NextLE<int32_t>();
-
-	player._pInfraFlag = file.NextBool32();
-	player.position.temp.x = file.NextLE<int32_t>();
-	player.position.temp.y = file.NextLE<int32_t>();
-	player.tempDirection = static_cast<Direction>(file.NextLE<int32_t>());
-	player.spellLevel = file.NextLE<int32_t>();
-	file.Skip(4); // skip _pVar5, was used for storing position of a tile which should have its HorizontalMovingPlayer flag removed after walking
-	player.position.offset2.deltaX = file.NextLE<int32_t>();
-	player.position.offset2.deltaY = file.NextLE<int32_t>();
-	file.Skip(4); // Skip actionFrame
 
 	for (uint8_t i = 0; i < giNumberOfLevels; i++)
 		player._pLvlVisited[i] = file.NextBool8();
@@ -427,33 +1089,7 @@ void LoadPlayer(LoadHelper &file, Player &player)
 	for (uint8_t i = 0; i < giNumberOfLevels; i++)
 		player._pSLvlVisited[i] = file.NextBool8();
 
-	file.Skip(2);     // Alignment
-	file.Skip(4);     // skip _pGFXLoad
-	file.Skip(4 * 8); // Skip pointers _pNAnim
-	player._pNFrames = file.NextLE<int32_t>();
-	file.Skip(4);     // skip _pNWidth
-	file.Skip(4 * 8); // Skip pointers _pWAnim
-	player._pWFrames = file.NextLE<int32_t>();
-	file.Skip(4);     // skip _pWWidth
-	file.Skip(4 * 8); // Skip pointers _pAAnim
-	player._pAFrames = file.NextLE<int32_t>();
-	file.Skip(4); // skip _pAWidth
-	player._pAFNum = file.NextLE<int32_t>();
-	file.Skip(4 * 8); // Skip pointers _pLAnim
-	file.Skip(4 * 8); // Skip pointers _pFAnim
-	file.Skip(4 * 8); // Skip pointers _pTAnim
-	player._pSFrames = file.NextLE<int32_t>();
-	file.Skip(4); // skip _pSWidth
-	player._pSFNum = file.NextLE<int32_t>();
-	file.Skip(4 * 8); // Skip pointers _pHAnim
-	player._pHFrames = file.NextLE<int32_t>();
-	file.Skip(4);     // skip _pHWidth
-	file.Skip(4 * 8); // Skip pointers _pDAnim
-	player._pDFrames = file.NextLE<int32_t>();
-	file.Skip(4);     // skip _pDWidth
-	file.Skip(4 * 8); // Skip pointers _pBAnim
-	player._pBFrames = file.NextLE<int32_t>();
-	file.Skip(4); // skip _pBWidth
+	ReadRecord<PlayerFramesLayout>(file, player);
 
 	for (Item &item : player.InvBody)
 		LoadItemData(file, item);
@@ -461,182 +1097,35 @@ void LoadPlayer(LoadHelper &file, Player &player)
 	for (Item &item : player.InvList)
 		LoadItemData(file, item);
 
-	player._pNumInv = file.NextLE<int32_t>();
-
-	for (int8_t &cell : player.InvGrid)
-		cell = file.NextLE<int8_t>();
+	ReadRecord<PlayerInvGridLayout>(file, player);
 
 	for (Item &item : player.SpdList)
 		LoadItemData(file, item);
 
 	LoadItemData(file, player.HoldItem);
 
-	player._pIMinDam = file.NextLE<int32_t>();
-	player._pIMaxDam = file.NextLE<int32_t>();
-	player._pIAC = file.NextLE<int32_t>();
-	player._pIBonusDam = file.NextLE<int32_t>();
-	player._pIBonusToHit = file.NextLE<int32_t>();
-	player._pIBonusAC = file.NextLE<int32_t>();
-	player._pIBonusDamMod = file.NextLE<int32_t>();
-	file.Skip(4); // Alignment
-
-	player._pISpells = file.NextLE<uint64_t>();
-	player._pIFlags = file.NextLE<int32_t>();
-	player._pIGetHit = file.NextLE<int32_t>();
-	player._pISplLvlAdd = file.NextLE<int8_t>();
-	file.Skip(1); // Unused
-	file.Skip(2); // Alignment
-	player._pISplDur = file.NextLE<int32_t>();
-	player._pIEnAc = file.NextLE<int32_t>();
-	player._pIFMinDam = file.NextLE<int32_t>();
-	player._pIFMaxDam = file.NextLE<int32_t>();
-	player._pILMinDam = file.NextLE<int32_t>();
-	player._pILMaxDam = file.NextLE<int32_t>();
-	player._pOilType = static_cast<item_misc_id>(file.NextLE<int32_t>());
-	player.pTownWarps = file.NextLE<uint8_t>();
-	player.pDungMsgs = file.NextLE<uint8_t>();
-	player.pLvlLoad = file.NextLE<uint8_t>();
-
+	ReadRecord(file, player, PlayerItemStatsLayout { gbIsHellfireSaveGame });
 	if (gbIsHellfireSaveGame) {
-		player.pDungMsgs2 = file.NextLE<uint8_t>();
 		player.pBattleNet = false;
 	} else {
 		player.pDungMsgs2 = 0;
-		player.pBattleNet = file.NextBool8();
-	}
-	player.pManaShield = file.NextBool8();
-	if (gbIsHellfireSaveGame) {
-		player.pOriginalCathedral = file.NextBool8();
-	} else {
-		file.Skip(1);
 		player.pOriginalCathedral = true;
 	}
-	file.Skip(2); // Available bytes
-	player.wReflections = file.NextLE<uint16_t>();
-	file.Skip(14); // Available bytes
-
-	player.pDiabloKillLevel = file.NextLE<uint32_t>();
-	player.pDifficulty = static_cast<_difficulty>(file.NextLE<uint32_t>());
-	player.pDamAcFlags = file.NextLE<uint32_t>();
-	file.Skip(20); // Available bytes
 	CalcPlrItemVals(player, false);
-
-	// Omit pointer _pNData
-	// Omit pointer _pWData
-	// Omit pointer _pAData
-	// Omit pointer _pLData
-	// Omit pointer _pFData
-	// Omit pointer  _pTData
-	// Omit pointer _pHData
-	// Omit pointer _pDData
-	// Omit pointer _pBData
-	// Omit pointer pReserved
 }
 
 bool gbSkipSync = false;
 
 void LoadMonster(LoadHelper *file, Monster &monster)
 {
-	monster._mMTidx = file->NextLE<int32_t>();
-	monster._mmode = static_cast<MonsterMode>(file->NextLE<int32_t>());
-	monster._mgoal = static_cast<monster_goal>(file->NextLE<uint8_t>());
-	file->Skip(3); // Alignment
-	monster._mgoalvar1 = file->NextLE<int32_t>();
-	monster._mgoalvar2 = file->NextLE<int32_t>();
-	monster._mgoalvar3 = file->NextLE<int32_t>();
-	file->Skip(4); // Unused
-	monster._pathcount = file->NextLE<uint8_t>();
-	file->Skip(3); // Alignment
-	monster.position.tile.x = file->NextLE<int32_t>();
-	monster.position.tile.y = file->NextLE<int32_t>();
-	monster.position.future.x = file->NextLE<int32_t>();
-	monster.position.future.y = file->NextLE<int32_t>();
-	monster.position.old.x = file->NextLE<int32_t>();
-	monster.position.old.y = file->NextLE<int32_t>();
-	monster.position.offset.deltaX = file->NextLE<int32_t>();
-	monster.position.offset.deltaY = file->NextLE<int32_t>();
-	monster.position.velocity.deltaX = file->NextLE<int32_t>();
-	monster.position.velocity.deltaY = file->NextLE<int32_t>();
-	monster._mdir = static_cast<Direction>(file->NextLE<int32_t>());
-	monster._menemy = file->NextLE<int32_t>();
-	monster.enemyPosition.x = file->NextLE<uint8_t>();
-	monster.enemyPosition.y = file->NextLE<uint8_t>();
-	file->Skip(2); // Unused
-
-	file->Skip(4); // Skip pointer _mAnimData
 	monster.AnimInfo = {};
-	monster.AnimInfo.TicksPerFrame = file->NextLE<int32_t>();
-	monster.AnimInfo.TickCounterOfCurrentFrame = file->NextLE<int32_t>();
-	monster.AnimInfo.NumberOfFrames = file->NextLE<int32_t>();
-	monster.AnimInfo.CurrentFrame = file->NextLE<int32_t>();
-	file->Skip(4); // Skip _meflag
-	monster._mDelFlag = file->NextBool32();
-	monster._mVar1 = file->NextLE<int32_t>();
-	monster._mVar2 = file->NextLE<int32_t>();
-	monster._mVar3 = file->NextLE<int32_t>();
-	monster.position.temp.x = file->NextLE<int32_t>();
-	monster.position.temp.y = file->NextLE<int32_t>();
-	monster.position.offset2.deltaX = file->NextLE<int32_t>();
-	monster.position.offset2.deltaY = file->NextLE<int32_t>();
-	file->Skip(4); // Skip actionFrame
-	monster._mmaxhp = file->NextLE<int32_t>();
-	monster._mhitpoints = file->NextLE<int32_t>();
-
-	monster._mAi = static_cast<_mai_id>(file->NextLE<uint8_t>());
-	monster._mint = file->NextLE<uint8_t>();
-	file->Skip(2); // Alignment
-	monster._mFlags = file->NextLE<uint32_t>();
-	monster._msquelch = file->NextLE<uint8_t>();
-	file->Skip(3); // Alignment
-	file->Skip(4); // Unused
-	monster.position.last.x = file->NextLE<int32_t>();
-	monster.position.last.y = file->NextLE<int32_t>();
-	monster._mRndSeed = file->NextLE<uint32_t>();
-	monster._mAISeed = file->NextLE<uint32_t>();
-	file->Skip(4); // Unused
-
-	monster._uniqtype = file->NextLE<uint8_t>();
-	monster._uniqtrans = file->NextLE<uint8_t>();
-	monster._udeadval = file->NextLE<int8_t>();
-
-	monster.mWhoHit = file->NextLE<int8_t>();
-	monster.mLevel = file->NextLE<int8_t>();
-	file->Skip(1); // Alignment
-	monster.mExp = file->NextLE<uint16_t>();
-
-	if ((monster._mFlags & MFLAG_GOLEM) != 0) // Don't skip for golems
-		monster.mHit = file->NextLE<uint8_t>();
-	else
-		file->Skip(1); // Skip mHit as it's already initialized
-	monster.mMinDamage = file->NextLE<uint8_t>();
-	monster.mMaxDamage = file->NextLE<uint8_t>();
-	file->Skip(1); // Skip mHit2 as it's already initialized
-	monster.mMinDamage2 = file->NextLE<uint8_t>();
-	monster.mMaxDamage2 = file->NextLE<uint8_t>();
-	monster.mArmorClass = file->NextLE<uint8_t>();
-	file->Skip(1); // Alignment
-	monster.mMagicRes = file->NextLE<uint16_t>();
-	file->Skip(2); // Alignment
-
-	monster.mtalkmsg = static_cast<_speech_id>(file->NextLE<int32_t>());
-	if (monster.mtalkmsg == TEXT_KING1) // Fix original bad mapping of NONE for monsters
-		monster.mtalkmsg = TEXT_NONE;
-	monster.leader = file->NextLE<uint8_t>();
-	monster.leaderRelation = static_cast<LeaderRelation>(file->NextLE<uint8_t>());
-	monster.packsize = file->NextLE<uint8_t>();
-	monster.mlid = file->NextLE<int8_t>();
-	if (monster.mlid == 0)
-		monster.mlid = NO_LIGHT; // Correct incorect values in old saves
+	ReadRecord<MonsterLayout>(*file, monster);
 
 	if ((monster._mFlags & MFLAG_BERSERK) != 0) {
 		int lightRadius = (currlevel < 17 || currlevel > 20) ? 3 : 9;
 		monster.mlid = AddLight(monster.position.tile, lightRadius);
 	}
 
-	// Omit pointer mName;
-	// Omit pointer MType;
-	// Omit pointer MData;
-
 	if (gbSkipSync)
 		return;
 
@@ -664,89 +1153,13 @@ void SyncPackSize(Monster &leader)
 
 void LoadMissile(LoadHelper *file, Missile &missile)
 {
-	missile._mitype = static_cast<missile_id>(file->NextLE<int32_t>());
-	missile.position.tile.x = file->NextLE<int32_t>();
-	missile.position.tile.y = file->NextLE<int32_t>();
-	missile.position.offset.deltaX = file->NextLE<int32_t>();
-	missile.position.offset.deltaY = file->NextLE<int32_t>();
-	missile.position.velocity.deltaX = file->NextLE<int32_t>();
-	missile.position.velocity.deltaY = file->NextLE<int32_t>();
-	missile.position.start.x = file->NextLE<int32_t>();
-	missile.position.start.y = file->NextLE<int32_t>();
-	missile.position.traveled.deltaX = file->NextLE<int32_t>();
-	missile.position.traveled.deltaY = file->NextLE<int32_t>();
-	missile._mimfnum = file->NextLE<int32_t>();
-	missile._mispllvl = file->NextLE<int32_t>();
-	missile._miDelFlag = file->NextBool32();
-	missile._miAnimType = file->NextLE<uint8_t>();
-	file->Skip(3); // Alignment
-	missile._miAnimFlags = static_cast<MissileDataFlags>(file->NextLE<int32_t>());
-	file->Skip(4); // Skip pointer _miAnimData
-	missile._miAnimDelay = file->NextLE<int32_t>();
-	missile._miAnimLen = file->NextLE<int32_t>();
-	missile._miAnimWidth = file->NextLE<int32_t>();
-	missile._miAnimWidth2 = file->NextLE<int32_t>();
-	missile._miAnimCnt = file->NextLE<int32_t>();
-	missile._miAnimAdd = file->NextLE<int32_t>();
-	missile._miAnimFrame = file->NextLE<int32_t>();
-	missile._miDrawFlag = file->NextBool32();
-	missile._miLightFlag = file->NextBool32();
-	missile._miPreFlag = file->NextBool32();
-	missile._miUniqTrans = file->NextLE<uint32_t>();
-	missile._mirange = file->NextLE<int32_t>();
-	missile._misource = file->NextLE<int32_t>();
-	missile._micaster = static_cast<mienemy_type>(file->NextLE<int32_t>());
-	missile._midam = file->NextLE<int32_t>();
-	missile._miHitFlag = file->NextBool32();
-	missile._midist = file->NextLE<int32_t>();
-	missile._mlid = file->NextLE<int32_t>();
-	missile._mirnd = file->NextLE<int32_t>();
-	missile.var1 = file->NextLE<int32_t>();
-	missile.var2 = file->NextLE<int32_t>();
-	missile.var3 = file->NextLE<int32_t>();
-	missile.var4 = file->NextLE<int32_t>();
-	missile.var5 = file->NextLE<int32_t>();
-	missile.var6 = file->NextLE<int32_t>();
-	missile.var7 = file->NextLE<int32_t>();
-	missile.limitReached = file->NextBool32();
+	ReadRecord<MissileLayout>(*file, missile);
 	missile.lastCollisionTargetHash = 0;
 }
 
 void LoadObject(LoadHelper &file, Object &object)
 {
-	object._otype = static_cast<_object_id>(file.NextLE<int32_t>());
-	object.position.x = file.NextLE<int32_t>();
-	object.position.y = file.NextLE<int32_t>();
-	object._oLight = file.NextBool32();
-	object._oAnimFlag = file.NextLE<uint32_t>();
-	file.Skip(4); // Skip pointer _oAnimData
-	object._oAnimDelay = file.NextLE<int32_t>();
-	object._oAnimCnt = file.NextLE<int32_t>();
-	object._oAnimLen = file.NextLE<uint32_t>();
-	object._oAnimFrame = file.NextLE<uint32_t>();
-	object._oAnimWidth = file.NextLE<int32_t>();
-	file.Skip(4); // Skip _oAnimWidth2
-	object._oDelFlag = file.NextBool32();
-	object._oBreak = file.NextLE<int8_t>();
-	file.Skip(3); // Alignment
-	object._oSolidFlag = file.NextBool32();
-	object._oMissFlag = file.NextBool32();
-
-	object._oSelFlag = file.NextLE<int8_t>();
-	file.Skip(3); // Alignment
-	object._oPreFlag = file.NextBool32();
-	object._oTrapFlag = file.NextBool32();
-	object._oDoorFlag = file.NextBool32();
-	object._olid = file.NextLE<int32_t>();
-	object._oRndSeed = file.NextLE<uint32_t>();
-	object._oVar1 = file.NextLE<int32_t>();
-	object._oVar2 = file.NextLE<int32_t>();
-	object._oVar3 = file.NextLE<int32_t>();
-	object._oVar4 = file.NextLE<int32_t>();
-	object._oVar5 = file.NextLE<int32_t>();
-	object._oVar6 = file.NextLE<uint32_t>();
-	object.bookMessage = static_cast<_speech_id>(file.NextLE<int32_t>());
-	object._oVar8 = file.NextLE<int32_t>();
+	ReadRecord<ObjectLayout>(file, object);
 }
 
 void LoadItem(LoadHelper &file, Item &item)
@@ -937,259 +1350,21 @@ void RemoveEmptyLevelItems()
 
 void SaveItem(SaveHelper &file, const Item &item)
 {
-	auto idx = item.IDidx;
-	if (!gbIsHellfire)
-		idx = RemapItemIdxToDiablo(idx);
-	if (gbIsSpawn)
-		idx = RemapItemIdxToSpawn(idx);
-	ItemType iType = item._itype;
-	if (idx == -1) {
-		idx = _item_indexes::IDI_GOLD;
-		iType = ItemType::None;
-	}
-
-	file.WriteLE<int32_t>(item._iSeed);
-	file.WriteLE<int16_t>(item._iCreateInfo);
-	file.Skip(2); // Alignment
-	file.WriteLE<int32_t>(static_cast<int32_t>(iType));
-	file.WriteLE<int32_t>(item.position.x);
-	file.WriteLE<int32_t>(item.position.y);
-	file.WriteLE<uint32_t>(item._iAnimFlag ? 1 : 0);
-	file.Skip(4); // Skip pointer _iAnimData
-	file.WriteLE<int32_t>(item.AnimInfo.NumberOfFrames);
-	file.WriteLE<int32_t>(item.AnimInfo.CurrentFrame);
-	// write _iAnimWidth for vanilla compatibility
-	file.WriteLE<int32_t>(ItemAnimWidth);
-	// write _iAnimWidth2 for vanilla compatibility
-	file.WriteLE<int32_t>(CalculateWidth2(ItemAnimWidth));
-	file.Skip<uint32_t>(); // _delFlag, unused since 1.02
-	file.WriteLE<uint8_t>(item._iSelFlag);
-	file.Skip(3); // Alignment
-	file.WriteLE<uint32_t>(item._iPostDraw ? 1 : 0);
-	file.WriteLE<uint32_t>(item._iIdentified ? 1 : 0);
-	file.WriteLE<int8_t>(item._iMagical);
-	file.WriteBytes(item._iName, 64);
-	file.WriteBytes(item._iIName, 64);
-	file.WriteLE<int8_t>(item._iLoc);
-	file.WriteLE<uint8_t>(item._iClass);
-	file.Skip(1); // Alignment
-	file.WriteLE<int32_t>(item._iCurs);
-	file.WriteLE<int32_t>(item._ivalue);
-	file.WriteLE<int32_t>(item._iIvalue);
-	file.WriteLE<int32_t>(item._iMinDam);
-	file.WriteLE<int32_t>(item._iMaxDam);
-	file.WriteLE<int32_t>(item._iAC);
-	file.WriteLE<uint32_t>(item._iFlags);
-	file.WriteLE<int32_t>(item._iMiscId);
-	file.WriteLE<int32_t>(item._iSpell);
-	file.WriteLE<int32_t>(item._iCharges);
-	file.WriteLE<int32_t>(item._iMaxCharges);
-	file.WriteLE<int32_t>(item._iDurability);
-	file.WriteLE<int32_t>(item._iMaxDur);
-	file.WriteLE<int32_t>(item._iPLDam);
-	file.WriteLE<int32_t>(item._iPLToHit);
-	file.WriteLE<int32_t>(item._iPLAC);
-	file.WriteLE<int32_t>(item._iPLStr);
-	file.WriteLE<int32_t>(item._iPLMag);
-	file.WriteLE<int32_t>(item._iPLDex);
-	file.WriteLE<int32_t>(item._iPLVit);
-	file.WriteLE<int32_t>(item._iPLFR);
-	file.WriteLE<int32_t>(item._iPLLR);
-	file.WriteLE<int32_t>(item._iPLMR);
-	file.WriteLE<int32_t>(item._iPLMana);
-	file.WriteLE<int32_t>(item._iPLHP);
-	file.WriteLE<int32_t>(item._iPLDamMod);
-	file.WriteLE<int32_t>(item._iPLGetHit);
-	file.WriteLE<int32_t>(item._iPLLight);
-	file.WriteLE<int8_t>(item._iSplLvlAdd);
-	file.WriteLE<int8_t>(item._iRequest ? 1 : 0);
-	file.Skip(2); // Alignment
-	file.WriteLE<int32_t>(item._iUid);
-	file.WriteLE<int32_t>(item._iFMinDam);
-	file.WriteLE<int32_t>(item._iFMaxDam);
-	file.WriteLE<int32_t>(item._iLMinDam);
-	file.WriteLE<int32_t>(item._iLMaxDam);
-	file.WriteLE<int32_t>(item._iPLEnAc);
-	file.WriteLE<int8_t>(item._iPrePower);
-	file.WriteLE<int8_t>(item._iSufPower);
-	file.Skip(2); // Alignment
-	file.WriteLE<int32_t>(item._iVAdd1);
-	file.WriteLE<int32_t>(item._iVMult1);
-	file.WriteLE<int32_t>(item._iVAdd2);
-	file.WriteLE<int32_t>(item._iVMult2);
-	file.WriteLE<int8_t>(item._iMinStr);
-	file.WriteLE<uint8_t>(item._iMinMag);
-	file.WriteLE<int8_t>(item._iMinDex);
-	file.Skip(1); // Alignment
-	file.WriteLE<uint32_t>(item._iStatFlag ? 1 : 0);
-	file.WriteLE<int32_t>(idx);
-	file.WriteLE<uint32_t>(item.dwBuff);
+	WriteRecord<ItemLayout>(file, item);
 	if (gbIsHellfire)
 		file.WriteLE<uint32_t>(item._iDamAcFlags);
 }
 
 void SavePlayer(SaveHelper &file, const Player &player)
 {
-	file.WriteLE<int32_t>(player._pmode);
-	for (int8_t step : player.walkpath)
-		file.WriteLE<int8_t>(step);
-	file.WriteLE<uint8_t>(player.plractive ? 1 : 0);
-	file.Skip(2); // Alignment
-	file.WriteLE<int32_t>(player.destAction);
-	file.WriteLE<int32_t>(player.destParam1);
-	file.WriteLE<int32_t>(player.destParam2);
-	file.WriteLE<int32_t>(static_cast<int32_t>(player.destParam3));
-	file.WriteLE<int32_t>(player.destParam4);
-	file.WriteLE<uint32_t>(player.plrlevel);
-	file.WriteLE<int32_t>(player.position.tile.x);
-	file.WriteLE<int32_t>(player.position.tile.y);
-	file.WriteLE<int32_t>(player.position.future.x);
-	file.WriteLE<int32_t>(player.position.future.y);
-
-	// For backwards compatibility
-	const Point target = player.GetTargetPosition();
-	file.WriteLE<int32_t>(target.x);
-	file.WriteLE<int32_t>(target.y);
-
-	file.WriteLE<int32_t>(player.position.last.x);
-	file.WriteLE<int32_t>(player.position.last.y);
-	file.WriteLE<int32_t>(player.position.old.x);
-	file.WriteLE<int32_t>(player.position.old.y);
-	file.WriteLE<int32_t>(player.position.offset.deltaX);
-	file.WriteLE<int32_t>(player.position.offset.deltaY);
-	file.WriteLE<int32_t>(player.position.velocity.deltaX);
-	file.WriteLE<int32_t>(player.position.velocity.deltaY);
-	file.WriteLE<int32_t>(static_cast<int32_t>(player._pdir));
-	file.Skip(4); // Unused
-	file.WriteLE<int32_t>(player._pgfxnum);
-	file.Skip(4); // Skip pointer _pAnimData
-	file.WriteLE<int32_t>(std::max(0, player.AnimInfo.TicksPerFrame - 1));
-	file.WriteLE<int32_t>(player.AnimInfo.TickCounterOfCurrentFrame);
-	file.WriteLE<int32_t>(player.AnimInfo.NumberOfFrames);
-	file.WriteLE<int32_t>(player.AnimInfo.CurrentFrame);
-	// write _pAnimWidth for vanilla compatibility
-	int animWidth = player.AnimInfo.pCelSprite == nullptr ? 96 : player.AnimInfo.pCelSprite->Width();
-	file.WriteLE<int32_t>(animWidth);
-	// write _pAnimWidth2 for vanilla compatibility
-	file.WriteLE<int32_t>(CalculateWidth2(animWidth));
-	file.Skip<uint32_t>(); // Skip _peflag
-	file.WriteLE<int32_t>(player._plid);
-	file.WriteLE<int32_t>(player._pvid);
-
-	file.WriteLE<int32_t>(player._pSpell);
-	file.WriteLE<int8_t>(player._pSplType);
-	file.WriteLE<int8_t>(player._pSplFrom);
-	file.Skip(2); // Alignment
-	file.WriteLE<int32_t>(player._pTSpell);
-	file.Skip<int8_t>(); // Skip _pTSplType
-	file.Skip(3);        // Alignment
-	file.WriteLE<int32_t>(player._pRSpell);
-	file.WriteLE<int8_t>(player._pRSplType);
-	file.Skip(3); // Alignment
-	file.WriteLE<int32_t>(player._pSBkSpell);
-	file.Skip<int8_t>(); // Skip _pSBkSplType
-
-	for (int8_t spellLevel : player._pSplLvl)
-		file.WriteLE<int8_t>(spellLevel);
-
-	file.Skip(7); // Alignment
-	file.WriteLE<uint64_t>(player._pMemSpells);
-	file.WriteLE<uint64_t>(player._pAblSpells);
-	file.WriteLE<uint64_t>(player._pScrlSpells);
-	file.WriteLE<uint8_t>(player._pSpellFlags);
-	file.Skip(3); // Alignment
-
-	for (auto &spellId : player._pSplHotKey)
-		file.WriteLE<int32_t>(spellId);
+	WriteRecord<PlayerLayout>(file, player);
 
-	for (auto &spellType : player._pSplTHotKey)
-		file.WriteLE<int8_t>(spellType);
-
-	file.WriteLE<int32_t>(player.UsesRangedWeapon() ? 1 : 0);
-	file.WriteLE<uint8_t>(player._pBlockFlag ? 1 : 0);
-	file.WriteLE<uint8_t>(player._pInvincible ? 1 : 0);
-	file.WriteLE<int8_t>(player._pLightRad);
-	file.WriteLE<uint8_t>(player._pLvlChanging ? 1 : 0);
-
-	file.WriteBytes(player._pName, PLR_NAME_LEN);
-	file.WriteLE<int8_t>(static_cast<int8_t>(player._pClass));
-	file.Skip(3); // Alignment
-	file.WriteLE<int32_t>(player._pStrength);
-	file.WriteLE<int32_t>(player._pBaseStr);
-	file.WriteLE<int32_t>(player._pMagic);
-	file.WriteLE<int32_t>(player._pBaseMag);
-	file.WriteLE<int32_t>(player._pDexterity);
-	file.WriteLE<int32_t>(player._pBaseDex);
-	file.WriteLE<int32_t>(player._pVitality);
-	file.WriteLE<int32_t>(player._pBaseVit);
-	file.WriteLE<int32_t>(player._pStatPts);
-	file.WriteLE<int32_t>(player._pDamageMod);
-
-	file.WriteLE<int32_t>(player._pBaseToBlk);
-	file.WriteLE<int32_t>(player._pHPBase);
-	file.WriteLE<int32_t>(player._pMaxHPBase);
-	file.WriteLE<int32_t>(player._pHitPoints);
-	file.WriteLE<int32_t>(player._pMaxHP);
-	file.Skip<int32_t>(); // Skip _pHPPer
-	file.WriteLE<int32_t>(player._pManaBase);
-	file.WriteLE<int32_t>(player._pMaxManaBase);
-	file.WriteLE<int32_t>(player._pMana);
-	file.WriteLE<int32_t>(player._pMaxMana);
-	file.Skip<int32_t>(); // Skip _pManaPer
-	file.WriteLE<int8_t>(player._pLevel);
-	file.WriteLE<int8_t>(player._pMaxLvl);
-	file.Skip(2); // Alignment
-	file.WriteLE<uint32_t>(player._pExperience);
-	file.Skip<uint32_t>(); // Skip _pMaxExp
-	file.WriteLE<uint32_t>(player._pNextExper);
-	file.WriteLE<int8_t>(player._pArmorClass);
-	file.WriteLE<int8_t>(player._pMagResist);
-	file.WriteLE<int8_t>(player._pFireResist);
-	file.WriteLE<int8_t>(player._pLghtResist);
-	file.WriteLE<int32_t>(player._pGold);
-
-	file.WriteLE<uint32_t>(player._pInfraFlag ? 1 : 0);
-	file.WriteLE<int32_t>(player.position.temp.x);
-	file.WriteLE<int32_t>(player.position.temp.y);
-	file.WriteLE<int32_t>(static_cast<int32_t>(player.tempDirection));
-	file.WriteLE<int32_t>(player.spellLevel);
-	file.Skip<int32_t>(); // skip _pVar5, was used for storing position of a tile which should have its HorizontalMovingPlayer flag removed after walking
-	file.WriteLE<int32_t>(player.position.offset2.deltaX);
-	file.WriteLE<int32_t>(player.position.offset2.deltaY);
-	file.Skip<int32_t>(); // Skip _pVar8
 	for (uint8_t i = 0; i < giNumberOfLevels; i++)
 		file.WriteLE<uint8_t>(player._pLvlVisited[i] ? 1 : 0);
 	for (uint8_t i = 0; i < giNumberOfLevels; i++)
 		file.WriteLE<uint8_t>(player._pSLvlVisited[i] ? 1 : 0); // only 10 used
 
-	file.Skip(2); // Alignment
-
-	file.Skip<int32_t>(); // Skip _pGFXLoad
-	file.Skip(4 * 8);     // Skip pointers _pNAnim
-	file.WriteLE<int32_t>(player._pNFrames);
-	file.Skip(4);     // Skip _pNWidth
-	file.Skip(4 * 8); // Skip pointers _pWAnim
-	file.WriteLE<int32_t>(player._pWFrames);
-	file.Skip(4);     // Skip _pWWidth
-	file.Skip(4 * 8); // Skip pointers _pAAnim
-	file.WriteLE<int32_t>(player._pAFrames);
-	file.Skip(4); // Skip _pAWidth
-	file.WriteLE<int32_t>(player._pAFNum);
-	file.Skip(4 * 8); // Skip pointers _pLAnim
-	file.Skip(4 * 8); // Skip pointers _pFAnim
-	file.Skip(4 * 8); // Skip pointers _pTAnim
-	file.WriteLE<int32_t>(player._pSFrames);
-	file.Skip(4); // Skip _pSWidth
-	file.WriteLE<int32_t>(player._pSFNum);
-	file.Skip(4 * 8); // Skip pointers _pHAnim
-	file.WriteLE<int32_t>(player._pHFrames);
-	file.Skip(4);     // Skip _pHWidth
-	file.Skip(4 * 8); // Skip pointers _pDAnim
-	file.WriteLE<int32_t>(player._pDFrames);
-	file.Skip(4);     // Skip _pDWidth
-	file.Skip(4 * 8); // Skip pointers _pBAnim
-	file.WriteLE<int32_t>(player._pBFrames);
-	file.Skip(4); // Skip _pBWidth
+	WriteRecord<PlayerFramesLayout>(file, player);
 
 	for (const Item &item : player.InvBody)
 		SaveItem(file, item);
@@ -1197,247 +1372,29 @@ void SavePlayer(SaveHelper &file, const Player &player)
 	for (const Item &item : player.InvList)
 		SaveItem(file, item);
 
-	file.WriteLE<int32_t>(player._pNumInv);
-
-	for (int8_t cell : player.InvGrid)
-		file.WriteLE<int8_t>(cell);
+	WriteRecord<PlayerInvGridLayout>(file, player);
 
 	for (const Item &item : player.SpdList)
 		SaveItem(file, item);
 
 	SaveItem(file, player.HoldItem);
 
-	file.WriteLE<int32_t>(player._pIMinDam);
-	file.WriteLE<int32_t>(player._pIMaxDam);
-	file.WriteLE<int32_t>(player._pIAC);
-	file.WriteLE<int32_t>(player._pIBonusDam);
-	file.WriteLE<int32_t>(player._pIBonusToHit);
-	file.WriteLE<int32_t>(player._pIBonusAC);
-	file.WriteLE<int32_t>(player._pIBonusDamMod);
-	file.Skip(4); // Alignment
-
-	file.WriteLE<uint64_t>(player._pISpells);
-	file.WriteLE<int32_t>(player._pIFlags);
-	file.WriteLE<int32_t>(player._pIGetHit);
-
-	file.WriteLE<int8_t>(player._pISplLvlAdd);
-	file.Skip<uint8_t>(); // Skip _pISplCost
-	file.Skip(2);         // Alignment
-	file.WriteLE<int32_t>(player._pISplDur);
-	file.WriteLE<int32_t>(player._pIEnAc);
-	file.WriteLE<int32_t>(player._pIFMinDam);
-	file.WriteLE<int32_t>(player._pIFMaxDam);
-	file.WriteLE<int32_t>(player._pILMinDam);
-	file.WriteLE<int32_t>(player._pILMaxDam);
-	file.WriteLE<int32_t>(player._pOilType);
-	file.WriteLE<uint8_t>(player.pTownWarps);
-	file.WriteLE<uint8_t>(player.pDungMsgs);
-	file.WriteLE<uint8_t>(player.pLvlLoad);
-	if (gbIsHellfire)
-		file.WriteLE<uint8_t>(player.pDungMsgs2);
-	else
-		file.WriteLE<uint8_t>(player.pBattleNet ? 1 : 0);
-	file.WriteLE<uint8_t>(player.pManaShield ? 1 : 0);
-	file.WriteLE<uint8_t>(player.pOriginalCathedral ? 1 : 0);
-	file.Skip(2); // Available bytes
-	file.WriteLE<uint16_t>(player.wReflections);
-	file.Skip(14); // Available bytes
-
-	file.WriteLE<uint32_t>(player.pDiabloKillLevel);
-	file.WriteLE<uint32_t>(player.pDifficulty);
-	file.WriteLE<uint32_t>(player.pDamAcFlags);
-	file.Skip(20); // Available bytes
-
-	// Omit pointer _pNData
-	// Omit pointer _pWData
-	// Omit pointer _pAData
-	// Omit pointer _pLData
-	// Omit pointer _pFData
-	// Omit pointer  _pTData
-	// Omit pointer _pHData
-	// Omit pointer _pDData
-	// Omit pointer _pBData
-	// Omit pointer pReserved
+	WriteRecord(file, player, PlayerItemStatsLayout { gbIsHellfire });
 }
 
 void SaveMonster(SaveHelper *file, Monster &monster)
 {
-	file->WriteLE<int32_t>(monster._mMTidx);
-	file->WriteLE<int32_t>(static_cast<int>(monster._mmode));
-	file->WriteLE<uint8_t>(monster._mgoal);
-	file->Skip(3); // Alignment
-	file->WriteLE<int32_t>(monster._mgoalvar1);
-	file->WriteLE<int32_t>(monster._mgoalvar2);
-	file->WriteLE<int32_t>(monster._mgoalvar3);
-	file->Skip(4); // Unused
-	file->WriteLE<uint8_t>(monster._pathcount);
-	file->Skip(3); // Alignment
-	file->WriteLE<int32_t>(monster.position.tile.x);
-	file->WriteLE<int32_t>(monster.position.tile.y);
-	file->WriteLE<int32_t>(monster.position.future.x);
-	file->WriteLE<int32_t>(monster.position.future.y);
-	file->WriteLE<int32_t>(monster.position.old.x);
-	file->WriteLE<int32_t>(monster.position.old.y);
-	file->WriteLE<int32_t>(monster.position.offset.deltaX);
-	file->WriteLE<int32_t>(monster.position.offset.deltaY);
-	file->WriteLE<int32_t>(monster.position.velocity.deltaX);
-	file->WriteLE<int32_t>(monster.position.velocity.deltaY);
-	file->WriteLE<int32_t>(static_cast<int32_t>(monster._mdir));
-	file->WriteLE<int32_t>(monster._menemy);
-	file->WriteLE<uint8_t>(monster.enemyPosition.x);
-	file->WriteLE<uint8_t>(monster.enemyPosition.y);
-	file->Skip(2); // Unused
-
-	file->Skip(4); // Skip pointer _mAnimData
-	file->WriteLE<int32_t>(monster.AnimInfo.TicksPerFrame);
-	file->WriteLE<int32_t>(monster.AnimInfo.TickCounterOfCurrentFrame);
-	file->WriteLE<int32_t>(monster.AnimInfo.NumberOfFrames);
-	file->WriteLE<int32_t>(monster.AnimInfo.CurrentFrame);
-	file->Skip<uint32_t>(); // Skip _meflag
-	file->WriteLE<uint32_t>(monster._mDelFlag ? 1 : 0);
-	file->WriteLE<int32_t>(monster._mVar1);
-	file->WriteLE<int32_t>(monster._mVar2);
-	file->WriteLE<int32_t>(monster._mVar3);
-	file->WriteLE<int32_t>(monster.position.temp.x);
-	file->WriteLE<int32_t>(monster.position.temp.y);
-	file->WriteLE<int32_t>(monster.position.offset2.deltaX);
-	file->WriteLE<int32_t>(monster.position.offset2.deltaY);
-	file->Skip<int32_t>(); // Skip _mVar8
-	file->WriteLE<int32_t>(monster._mmaxhp);
-	file->WriteLE<int32_t>(monster._mhitpoints);
-
-	file->WriteLE<uint8_t>(monster._mAi);
-	file->WriteLE<uint8_t>(monster._mint);
-	file->Skip(2); // Alignment
-	file->WriteLE<uint32_t>(monster._mFlags);
-	file->WriteLE<uint8_t>(monster._msquelch);
-	file->Skip(3); // Alignment
-	file->Skip(4); // Unused
-	file->WriteLE<int32_t>(monster.position.last.x);
-	file->WriteLE<int32_t>(monster.position.last.y);
-	file->WriteLE<uint32_t>(monster._mRndSeed);
-	file->WriteLE<uint32_t>(monster._mAISeed);
-	file->Skip(4); // Unused
-
-	file->WriteLE<uint8_t>(monster._uniqtype);
-	file->WriteLE<uint8_t>(monster._uniqtrans);
-	file->WriteLE<int8_t>(monster._udeadval);
-
-	file->WriteLE<int8_t>(monster.mWhoHit);
-	file->WriteLE<int8_t>(monster.mLevel);
-	file->Skip(1); // Alignment
-	file->WriteLE<uint16_t>(monster.mExp);
-
-	file->WriteLE<uint8_t>(std::min<uint16_t>(monster.mHit, std::numeric_limits<uint8_t>::max())); // For backwards compatibility
-	file->WriteLE<uint8_t>(monster.mMinDamage);
-	file->WriteLE<uint8_t>(monster.mMaxDamage);
-	file->WriteLE<uint8_t>(std::min<uint16_t>(monster.mHit2, std::numeric_limits<uint8_t>::max())); // For backwards compatibility
-	file->WriteLE<uint8_t>(monster.mMinDamage2);
-	file->WriteLE<uint8_t>(monster.mMaxDamage2);
-	file->WriteLE<uint8_t>(monster.mArmorClass);
-	file->Skip(1); // Alignment
-	file->WriteLE<uint16_t>(monster.mMagicRes);
-	file->Skip(2); // Alignment
-
-	file->WriteLE<int32_t>(monster.mtalkmsg == TEXT_NONE ? 0 : monster.mtalkmsg); // Replicate original bad mapping of none for monsters
-	file->WriteLE<uint8_t>(monster.leader);
-	file->WriteLE<uint8_t>(static_cast<std::uint8_t>(monster.leaderRelation));
-	file->WriteLE<uint8_t>(monster.packsize);
-	// vanilla compatibility
-	if (monster.mlid == NO_LIGHT)
-		file->WriteLE<int8_t>(0);
-	else
-		file->WriteLE<int8_t>(monster.mlid);
-
-	// Omit pointer mName;
-	// Omit pointer MType;
-	// Omit pointer MData;
+	WriteRecord<MonsterLayout>(*file, monster);
 }
 
 void SaveMissile(SaveHelper *file, Missile &missile)
 {
-	file->WriteLE<int32_t>(missile._mitype);
-	file->WriteLE<int32_t>(missile.position.tile.x);
-	file->WriteLE<int32_t>(missile.position.tile.y);
-	file->WriteLE<int32_t>(missile.position.offset.deltaX);
-	file->WriteLE<int32_t>(missile.position.offset.deltaY);
-	file->WriteLE<int32_t>(missile.position.velocity.deltaX);
-	file->WriteLE<int32_t>(missile.position.velocity.deltaY);
-	file->WriteLE<int32_t>(missile.position.start.x);
-	file->WriteLE<int32_t>(missile.position.start.y);
-	file->WriteLE<int32_t>(missile.position.traveled.deltaX);
-	file->WriteLE<int32_t>(missile.position.traveled.deltaY);
-	file->WriteLE<int32_t>(missile._mimfnum);
-	file->WriteLE<int32_t>(missile._mispllvl);
-	file->WriteLE<uint32_t>(missile._miDelFlag ? 1 : 0);
-	file->WriteLE<uint8_t>(missile._miAnimType);
-	file->Skip(3); // Alignment
-	file->WriteLE<int32_t>(static_cast<int32_t>(missile._miAnimFlags));
-	file->Skip(4); // Skip pointer _miAnimData
-	file->WriteLE<int32_t>(missile._miAnimDelay);
-	file->WriteLE<int32_t>(missile._miAnimLen);
-	file->WriteLE<int32_t>(missile._miAnimWidth);
-	file->WriteLE<int32_t>(missile._miAnimWidth2);
-	file->WriteLE<int32_t>(missile._miAnimCnt);
-	file->WriteLE<int32_t>(missile._miAnimAdd);
-	file->WriteLE<int32_t>(missile._miAnimFrame);
-	file->WriteLE<uint32_t>(missile._miDrawFlag ? 1 : 0);
-	file->WriteLE<uint32_t>(missile._miLightFlag ? 1 : 0);
-	file->WriteLE<uint32_t>(missile._miPreFlag ? 1 : 0);
-	file->WriteLE<uint32_t>(missile._miUniqTrans);
-	file->WriteLE<int32_t>(missile._mirange);
-	file->WriteLE<int32_t>(missile._misource);
-	file->WriteLE<int32_t>(missile._micaster);
-	file->WriteLE<int32_t>(missile._midam);
-	file->WriteLE<uint32_t>(missile._miHitFlag ? 1 : 0);
-	file->WriteLE<int32_t>(missile._midist);
-	file->WriteLE<int32_t>(missile._mlid);
-	file->WriteLE<int32_t>(missile._mirnd);
-	file->WriteLE<int32_t>(missile.var1);
-	file->WriteLE<int32_t>(missile.var2);
-	file->WriteLE<int32_t>(missile.var3);
-	file->WriteLE<int32_t>(missile.var4);
-	file->WriteLE<int32_t>(missile.var5);
-	file->WriteLE<int32_t>(missile.var6);
-	file->WriteLE<int32_t>(missile.var7);
-	file->WriteLE<uint32_t>(missile.limitReached ? 1 : 0);
+	WriteRecord<MissileLayout>(*file, missile);
 }
 
 void SaveObject(SaveHelper &file, const Object &object)
 {
-	file.WriteLE<int32_t>(object._otype);
-	file.WriteLE<int32_t>(object.position.x);
-	file.WriteLE<int32_t>(object.position.y);
-	file.WriteLE<uint32_t>(object._oLight ? 1 : 0);
-	file.WriteLE<uint32_t>(object._oAnimFlag);
-	file.Skip(4); // Skip pointer _oAnimData
-	file.WriteLE<int32_t>(object._oAnimDelay);
-	file.WriteLE<int32_t>(object._oAnimCnt);
-	file.WriteLE<uint32_t>(object._oAnimLen);
-	file.WriteLE<uint32_t>(object._oAnimFrame);
-	file.WriteLE<int32_t>(object._oAnimWidth);
-	file.WriteLE<int32_t>(CalculateWidth2(object._oAnimWidth)); // Write _oAnimWidth2 for vanilla compatibility
-	file.WriteLE<uint32_t>(object._oDelFlag ? 1 : 0);
-	file.WriteLE<int8_t>(object._oBreak);
-	file.Skip(3); // Alignment
-	file.WriteLE<uint32_t>(object._oSolidFlag ? 1 : 0);
-	file.WriteLE<uint32_t>(object._oMissFlag ? 1 : 0);
-
-	file.WriteLE<int8_t>(object._oSelFlag);
-	file.Skip(3); // Alignment
-	file.WriteLE<uint32_t>(object._oPreFlag ? 1 : 0);
-	file.WriteLE<uint32_t>(object._oTrapFlag ? 1 : 0);
-	file.WriteLE<uint32_t>(object._oDoorFlag ? 1 : 0);
-	file.WriteLE<int32_t>(object._olid);
-	file.WriteLE<uint32_t>(object._oRndSeed);
-	file.WriteLE<int32_t>(object._oVar1);
-	file.WriteLE<int32_t>(object._oVar2);
-	file.WriteLE<int32_t>(object._oVar3);
-	file.WriteLE<int32_t>(object._oVar4);
-	file.WriteLE<int32_t>(object._oVar5);
-	file.WriteLE<uint32_t>(object._oVar6);
-	file.WriteLE<int32_t>(object.bookMessage);
-	file.WriteLE<int32_t>(object._oVar8);
+	WriteRecord<ObjectLayout>(file, object);
 }
 
 void SaveQuest(SaveHelper *file, int i)
@@ -1539,6 +1496,274 @@ void SaveDroppedItemLocations(SaveHelper &file, const std::unordered_map<uint8_t
 const int DiabloItemSaveSize = 368;
 const int HellfireItemSaveSize = 372;
 
+/** Starts level files that store their grids with SaveGrid, older level files have no header. */
+const uint32_t LevelFileMagic = LoadLE32("DLVL");
+/** Version of the level file layout that follows LevelFileMagic. */
+const uint8_t LevelFileVersion = 1;
+
+enum class GridEncoding : uint8_t {
+	/** The grid bytes as they are in memory */
+	Raw,
+	/** uint8_t background value, uint32_t size, then the grid XOR the background encoded with ZeroRunEncode */
+	ZeroRun,
+};
+
+/**
+ * @brief Stores a grid in bulk, run-length encoded when it is uniform enough for that to be smaller.
+ *
+ * Runs are taken of the most common value, which is 0 for most grids but the darkness level for the light grids.
+ * Unlike the per tile loops of the older level files, the grid is stored in memory order.
+ */
+void SaveGridBytes(SaveHelper &file, const void *grid, size_t size)
+{
+	const auto *bytes = static_cast<const uint8_t *>(grid);
+	uint32_t counts[256] = {};
+	for (size_t i = 0; i < size; i++)
+		counts[bytes[i]]++;
+	const auto background = static_cast<uint8_t>(std::max_element(std::begin(counts), std::end(counts)) - std::begin(counts));
+
+	std::unique_ptr<byte[]> masked { new byte[size] };
+	for (size_t i = 0; i < size; i++)
+		masked[i] = static_cast<byte>(bytes[i] ^ background);
+	std::unique_ptr<byte[]> encoded { new byte[size] };
+	const uint32_t encodedSize = ZeroRunEncode(masked.get(), static_cast<uint32_t>(size), encoded.get(), static_cast<uint32_t>(size - sizeof(uint32_t) - 1));
+	if (encodedSize == 0) {
+		file.WriteLE<uint8_t>(static_cast<uint8_t>(GridEncoding::Raw));
+		file.WriteBytes(bytes, size);
+		return;
+	}
+	file.WriteLE<uint8_t>(static_cast<uint8_t>(GridEncoding::ZeroRun));
+	file.WriteLE<uint8_t>(background);
+	file.WriteLE<uint32_t>(encodedSize);
+	file.WriteBytes(encoded.get(), encodedSize);
+}
+
+void LoadGridBytes(LoadHelper &file, void *grid, size_t size)
+{
+	auto *bytes = static_cast<byte *>(grid);
+	const auto encoding = static_cast<GridEncoding>(file.NextLE<uint8_t>());
+	if (encoding == GridEncoding::Raw && file.IsValid(size)) {
+		file.NextBytes(bytes, size);
+		return;
+	}
+	if (encoding == GridEncoding::ZeroRun) {
+		const uint8_t background = file.NextLE<uint8_t>();
+		const uint32_t encodedSize = file.NextLE<uint32_t>();
+		if (file.IsValid(encodedSize)) {
+			std::unique_ptr<byte[]> encoded { new byte[encodedSize] };
+			file.NextBytes(encoded.get(), encodedSize);
+			if (ZeroRunDecode(encoded.get(), encodedSize, bytes, static_cast<uint32_t>(size))) {
+				for (size_t i = 0; i < size; i++)
+					bytes[i] ^= static_cast<byte>(background);
+				return;
+			}
+		}
+	}
+	app_fatal("%s", _("Invalid save file"));
+}
+
+template <typename T, size_t Width, size_t Height>
+void SaveGrid(SaveHelper &file, const T (&grid)[Width][Height])
+{
+	static_assert(sizeof(T) == 1, "Grids with larger values are stored per byte, see SaveMonsterGrid");
+	SaveGridBytes(file, grid, sizeof(grid));
+}
+
+template <typename T, size_t Width, size_t Height>
+void LoadGrid(LoadHelper &file, T (&grid)[Width][Height])
+{
+	static_assert(sizeof(T) == 1, "Grids with larger values are stored per byte, see LoadMonsterGrid");
+	LoadGridBytes(file, grid, sizeof(grid));
+}
+
+/**
+ * @brief Stores dMonster as a grid of its low bytes followed by a grid of its high bytes.
+ *
+ * Split like this each grid is mostly zero, and the high bytes are almost entirely so.
+ */
+void SaveMonsterGrid(SaveHelper &file)
+{
+	uint8_t planes[2][MAXDUNX][MAXDUNY];
+	for (int i = 0; i < MAXDUNX; i++) {
+		for (int j = 0; j < MAXDUNY; j++) {
+			const auto value = static_cast<uint16_t>(dMonster[i][j]);
+			planes[0][i][j] = static_cast<uint8_t>(value);
+			planes[1][i][j] = static_cast<uint8_t>(value >> 8);
+		}
+	}
+	SaveGrid(file, planes[0]);
+	SaveGrid(file, planes[1]);
+}
+
+void LoadMonsterGrid(LoadHelper &file)
+{
+	uint8_t planes[2][MAXDUNX][MAXDUNY];
+	LoadGrid(file, planes[0]);
+	LoadGrid(file, planes[1]);
+	for (int i = 0; i < MAXDUNX; i++) {
+		for (int j = 0; j < MAXDUNY; j++)
+			dMonster[i][j] = static_cast<int16_t>(planes[0][i][j] | (planes[1][i][j] << 8));
+	}
+}
+
+/** Number of level saves written as deltas before a full keyframe is written again. */
+constexpr uint8_t LevelKeyframeInterval = 16;
+
+/**
+ * @brief The last full image written for a level.
+ *
+ * Level files are split in sections (grids, monsters, items, ...) that are diffed separately,
+ * so a section that changes in size does not shift everything after it.
+ */
+struct LevelKeyframe {
+	/** Temp file name of the level, which identifies it */
+	std::string name;
+	std::vector<byte> data;
+	std::vector<uint32_t> sectionEnds;
+	uint32_t hash;
+	/** Number of deltas written against this keyframe */
+	uint8_t deltaCount;
+};
+
+/** Keyframe of the level that was loaded last, SaveLevel writes its delta against it. */
+std::optional<LevelKeyframe> CurrentLevelKeyframe;
+
+uint32_t SectionBegin(const std::vector<uint32_t> &sectionEnds, size_t section)
+{
+	return section == 0 ? 0 : sectionEnds[section - 1];
+}
+
+/**
+ * @brief Writes the changes of a level image against its keyframe to the level's delta file.
+ *
+ * The delta file starts with the hash, size, delta count and sections of the keyframe, followed by the size
+ * and the changed byte ranges of each section of the image.
+ * @return false when the delta would be larger than sizeLimit, nothing is written then.
+ */
+bool WriteLevelDelta(const char *szName, const LevelKeyframe &keyframe, const byte *image, const std::vector<uint32_t> &sectionEnds, size_t sizeLimit)
+{
+	std::vector<std::vector<LevelPatch>> patches(sectionEnds.size());
+	size_t size = 2 * sizeof(uint32_t) + 2 * sizeof(uint8_t) + keyframe.sectionEnds.size() * sizeof(uint32_t);
+	for (size_t section = 0; section < sectionEnds.size(); section++) {
+		const uint32_t keyframeBegin = SectionBegin(keyframe.sectionEnds, section);
+		const uint32_t imageBegin = SectionBegin(sectionEnds, section);
+		patches[section] = DiffLevelImage(keyframe.data.data() + keyframeBegin, keyframe.sectionEnds[section] - keyframeBegin,
+		    image + imageBegin, sectionEnds[section] - imageBegin);
+		size += 2 * sizeof(uint32_t);
+		for (const LevelPatch &patch : patches[section])
+			size += 2 * sizeof(uint32_t) + patch.length;
+	}
+	if (size > sizeLimit)
+		return false;
+
+	SaveHelper file(szName, size);
+	file.WriteLE<uint32_t>(keyframe.hash);
+	file.WriteLE<uint32_t>(static_cast<uint32_t>(keyframe.data.size()));
+	file.WriteLE<uint8_t>(keyframe.deltaCount);
+	file.WriteLE<uint8_t>(static_cast<uint8_t>(keyframe.sectionEnds.size()));
+	for (uint32_t end : keyframe.sectionEnds)
+		file.WriteLE<uint32_t>(end);
+	for (size_t section = 0; section < sectionEnds.size(); section++) {
+		const uint32_t imageBegin = SectionBegin(sectionEnds, section);
+		file.WriteLE<uint32_t>(sectionEnds[section] - imageBegin);
+		file.WriteLE<uint32_t>(static_cast<uint32_t>(patches[section].size()));
+		for (const LevelPatch &patch : patches[section]) {
+			file.WriteLE<uint32_t>(patch.offset);
+			file.WriteLE<uint32_t>(patch.length);
+			file.WriteBytes(image + imageBegin + patch.offset, patch.length);
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Reads the keyframe of the current level and applies its delta, if there is one.
+ *
+ * Remembers the keyframe, so leaving the level again only has to write a delta.
+ */
+LoadHelper ReadLevelImage()
+{
+	CurrentLevelKeyframe = std::nullopt;
+
+	PFileLevel level = pfile_read_level();
+	if (level.data == nullptr)
+		app_fatal("%s", _("Unable to open save file archive"));
+	std::unique_ptr<byte[]> keyframe = std::move(level.data);
+	const size_t size = level.size;
+
+	LoadHelper delta(std::move(level.delta), level.deltaSize);
+	if (!delta.IsValid()) {
+		// Saved by a version that always wrote the full level
+		return LoadHelper(std::move(keyframe), size);
+	}
+
+	const uint32_t hash = delta.NextLE<uint32_t>();
+	if (delta.NextLE<uint32_t>() != size || hash != HashLevelImage(keyframe.get(), size)) {
+		LogError("Level delta {} does not belong to {}, ignoring it", level.deltaName, level.name);
+		return LoadHelper(std::move(keyframe), size);
+	}
+
+	LevelKeyframe levelKeyframe;
+	char szTempName[MAX_PATH];
+	GetTempLevelNames(szTempName);
+	levelKeyframe.name = szTempName;
+	levelKeyframe.hash = hash;
+	levelKeyframe.deltaCount = delta.NextLE<uint8_t>();
+	const uint8_t sectionCount = delta.NextLE<uint8_t>();
+	for (uint8_t section = 0; section < sectionCount; section++) {
+		const uint32_t end = delta.NextLE<uint32_t>();
+		if (end < SectionBegin(levelKeyframe.sectionEnds, section) || end > size)
+			app_fatal("%s", _("Invalid save file"));
+		levelKeyframe.sectionEnds.push_back(end);
+	}
+
+	std::vector<byte> image;
+	image.reserve(size);
+	for (uint8_t section = 0; section < sectionCount; section++) {
+		const uint32_t length = delta.NextLE<uint32_t>();
+		const uint32_t patchCount = delta.NextLE<uint32_t>();
+		const size_t imageBegin = image.size();
+		const uint32_t keyframeBegin = SectionBegin(levelKeyframe.sectionEnds, section);
+		const uint32_t keyframeLength = levelKeyframe.sectionEnds[section] - keyframeBegin;
+		image.insert(image.end(), keyframe.get() + keyframeBegin, keyframe.get() + keyframeBegin + std::min(length, keyframeLength));
+		image.resize(imageBegin + length);
+		for (uint32_t i = 0; i < patchCount; i++) {
+			const uint32_t offset = delta.NextLE<uint32_t>();
+			const uint32_t patchLength = delta.NextLE<uint32_t>();
+			if (offset > length || patchLength > length - offset || !delta.IsValid(patchLength))
+				app_fatal("%s", _("Invalid save file"));
+			delta.NextBytes(&image[imageBegin + offset], patchLength);
+		}
+	}
+
+	levelKeyframe.data.assign(keyframe.get(), keyframe.get() + size);
+	CurrentLevelKeyframe = std::move(levelKeyframe);
+
+	std::unique_ptr<byte[]> buffer { new byte[image.size()] };
+	memcpy(buffer.get(), image.data(), image.size());
+	return LoadHelper(std::move(buffer), image.size());
+}
+
+/** @brief Enough for any single record, a player with all of their items is the largest. */
+const size_t MaxRecordSize = 32 * 1024;
+
+template <class Save>
+std::vector<byte> SaveRecordToBuffer(Save save)
+{
+	SaveHelper file(nullptr, MaxRecordSize);
+	save(file);
+	std::vector<byte> record(file.Data(), file.Data() + file.Position());
+	file.Discard();
+	return record;
+}
+
+LoadHelper LoadRecordFromBuffer(const std::vector<byte> &record)
+{
+	std::unique_ptr<byte[]> buffer { new byte[record.size()] };
+	memcpy(buffer.get(), record.data(), record.size());
+	return LoadHelper(std::move(buffer), record.size());
+}
+
 } // namespace
 
 void RemoveInvalidItem(Item &item)
@@ -1751,7 +1976,8 @@ void LoadGame(bool firstflag)
 {
 	FreeGameMem();
 
-	LoadHelper file("game");
+	// The level is loaded as soon as the player is parsed, while the save thread is still decoding the rest of the file
+	LoadHelper file(std::make_unique<PFileStream>("game"));
 	if (!file.IsValid())
 		app_fatal("%s", _("Unable to open save file archive"));
 
@@ -2130,60 +2356,92 @@ void SaveLevel()
 	char szName[MAX_PATH];
 	GetTempLevelNames(szName);
 	SaveHelper file(szName, 256 * 1024);
+	std::vector<uint32_t> sectionEnds;
+	auto endSection = [&]() { sectionEnds.push_back(static_cast<uint32_t>(file.Position())); };
+
+	file.WriteLE<uint32_t>(LevelFileMagic);
+	file.WriteLE<uint8_t>(LevelFileVersion);
 
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dCorpse[i][j]);
-		}
+		SaveGrid(file, dCorpse);
+		endSection();
 	}
 
 	file.WriteBE<int32_t>(ActiveMonsterCount);
 	file.WriteBE<int32_t>(ActiveItemCount);
 	file.WriteBE<int32_t>(ActiveObjectCount);
+	endSection();
 
 	if (leveltype != DTYPE_TOWN) {
 		for (int monsterId : ActiveMonsters)
 			file.WriteBE<int32_t>(monsterId);
+		endSection();
 		for (int i = 0; i < ActiveMonsterCount; i++)
 			SaveMonster(&file, Monsters[ActiveMonsters[i]]);
+		endSection();
 		for (int objectId : ActiveObjects)
 			file.WriteLE<int8_t>(objectId);
 		for (int objectId : AvailableObjects)
 			file.WriteLE<int8_t>(objectId);
+		endSection();
 		for (int i = 0; i < ActiveObjectCount; i++)
 			SaveObject(file, Objects[ActiveObjects[i]]);
+		endSection();
 	}
 
 	auto itemIndexes = SaveDroppedItems(file);
+	endSection();
 
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			file.WriteLE<uint8_t>(static_cast<uint8_t>(dFlags[i][j] & DungeonFlag::SavedFlags));
+	uint8_t grid[MAXDUNX][MAXDUNY];
+	for (int i = 0; i < MAXDUNX; i++) {
+		for (int j = 0; j < MAXDUNY; j++)
+			grid[i][j] = static_cast<uint8_t>(dFlags[i][j] & DungeonFlag::SavedFlags);
 	}
-	SaveDroppedItemLocations(file, itemIndexes);
+	SaveGrid(file, grid);
+	endSection();
+	for (int i = 0; i < MAXDUNX; i++) {
+		for (int j = 0; j < MAXDUNY; j++)
+			grid[i][j] = itemIndexes.at(dItem[i][j]);
+	}
+	SaveGrid(file, grid);
+	endSection();
 
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteBE<int32_t>(dMonster[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dObject[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dLight[i][j]);
-		}
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<int8_t>(dPreLight[i][j]);
-		}
-		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++) // NOLINT(modernize-loop-convert)
-				file.WriteLE<uint8_t>(AutomapView[i][j]);
-		}
+		SaveMonsterGrid(file);
+		endSection();
+		SaveGrid(file, dObject);
+		endSection();
+		SaveGrid(file, dLight);
+		endSection();
+		SaveGrid(file, dPreLight);
+		endSection();
+		SaveGrid(file, AutomapView);
+		endSection();
+	}
+
+	// The keyframe belongs to the visit that ends here, a level that is generated anew starts without one
+	std::optional<LevelKeyframe> keyframe = std::move(CurrentLevelKeyframe);
+	CurrentLevelKeyframe = std::nullopt;
+
+	char szDeltaName[MAX_PATH];
+	GetTempLevelDeltaNames(szDeltaName);
+	bool wroteDelta = false;
+	if (keyframe && keyframe->name == szName && keyframe->sectionEnds.size() == sectionEnds.size() && keyframe->deltaCount + 1 < LevelKeyframeInterval) {
+		keyframe->deltaCount++;
+		// A delta that is not much smaller than the level is not worth the extra work when loading
+		wroteDelta = WriteLevelDelta(szDeltaName, *keyframe, file.Data(), sectionEnds, file.Position() / 2);
+	}
+	if (wroteDelta) {
+		file.Discard();
+	} else {
+		LevelKeyframe newKeyframe;
+		newKeyframe.name = szName;
+		newKeyframe.data.assign(file.Data(), file.Data() + file.Position());
+		newKeyframe.sectionEnds = std::move(sectionEnds);
+		newKeyframe.hash = HashLevelImage(newKeyframe.data.data(), newKeyframe.data.size());
+		newKeyframe.deltaCount = 0;
+		// Replaces any delta against the previous keyframe
+		WriteLevelDelta(szDeltaName, newKeyframe, newKeyframe.data.data(), newKeyframe.sectionEnds, SIZE_MAX);
 	}
 
 	if (!setlevel)
@@ -2194,16 +2452,28 @@ void SaveLevel()
 
 void LoadLevel()
 {
-	char szName[MAX_PATH];
-	GetPermLevelNames(szName);
-	LoadHelper file(szName);
+	LoadHelper file = ReadLevelImage();
 	if (!file.IsValid())
 		app_fatal("%s", _("Unable to open save file archive"));
 
+	uint8_t version = 0;
+	if (file.PeekLE<uint32_t>() == LevelFileMagic) {
+		file.Skip<uint32_t>();
+		version = file.NextLE<uint8_t>();
+		if (version > LevelFileVersion)
+			app_fatal("%s", _("Invalid save file"));
+	}
+	// Versions from 1 on store the grids in bulk
+	const bool bulkGrids = version >= 1;
+
 	if (leveltype != DTYPE_TOWN) {
-		for (int j = 0; j < MAXDUNY; j++) {
-			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-				dCorpse[i][j] = file.NextLE<int8_t>();
+		if (bulkGrids) {
+			LoadGrid(file, dCorpse);
+		} else {
+			for (int j = 0; j < MAXDUNY; j++) {
+				for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
+					dCorpse[i][j] = file.NextLE<int8_t>();
+			}
 		}
 		SyncUniqDead();
 	}
@@ -2231,14 +2501,33 @@ void LoadLevel()
 
 	auto itemIndexes = LoadDroppedItems(file);
 
-	for (int j = 0; j < MAXDUNY; j++) {
-		for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
-			dFlags[i][j] = static_cast<DungeonFlag>(file.NextLE<uint8_t>()) & DungeonFlag::LoadedFlags;
+	if (bulkGrids) {
+		uint8_t grid[MAXDUNX][MAXDUNY];
+		LoadGrid(file, grid);
+		for (int i = 0; i < MAXDUNX; i++) {
+			for (int j = 0; j < MAXDUNY; j++)
+				dFlags[i][j] = static_cast<DungeonFlag>(grid[i][j]) & DungeonFlag::LoadedFlags;
+		}
+		LoadGrid(file, grid);
+		for (int i = 0; i < MAXDUNX; i++) {
+			for (int j = 0; j < MAXDUNY; j++)
+				dItem[i][j] = itemIndexes.at(grid[i][j]);
+		}
+	} else {
+		for (int j = 0; j < MAXDUNY; j++) {
+			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
+				dFlags[i][j] = static_cast<DungeonFlag>(file.NextLE<uint8_t>()) & DungeonFlag::LoadedFlags;
+		}
+		LoadDroppedItemLocations(file, itemIndexes);
 	}
 
-	LoadDroppedItemLocations(file, itemIndexes);
-
-	if (leveltype != DTYPE_TOWN) {
+	if (leveltype != DTYPE_TOWN && bulkGrids) {
+		LoadMonsterGrid(file);
+		LoadGrid(file, dObject);
+		LoadGrid(file, dLight);
+		LoadGrid(file, dPreLight);
+		LoadGrid(file, AutomapView);
+	} else if (leveltype != DTYPE_TOWN) {
 		for (int j = 0; j < MAXDUNY; j++) {
 			for (int i = 0; i < MAXDUNX; i++) // NOLINT(modernize-loop-convert)
 				dMonster[i][j] = file.NextBE<int32_t>();
@@ -2256,9 +2545,15 @@ void LoadLevel()
 				dPreLight[i][j] = file.NextLE<int8_t>();
 		}
 		for (int j = 0; j < DMAXY; j++) {
-			for (int i = 0; i < DMAXX; i++) { // NOLINT(modernize-loop-convert)
-				const auto automapView = static_cast<MapExplorationType>(file.NextLE<uint8_t>());
-				AutomapView[i][j] = automapView == MAP_EXP_OLD ? MAP_EXP_SELF : automapView;
+			for (int i = 0; i < DMAXX; i++) // NOLINT(modernize-loop-convert)
+				AutomapView[i][j] = file.NextLE<uint8_t>();
+		}
+	}
+	if (leveltype != DTYPE_TOWN) {
+		for (auto &column : AutomapView) {
+			for (uint8_t &automapView : column) {
+				if (automapView == MAP_EXP_OLD)
+					automapView = MAP_EXP_SELF;
 			}
 		}
 	}
@@ -2281,4 +2576,68 @@ void LoadLevel()
 	}
 }
 
+void ClearLevelKeyframe()
+{
+	CurrentLevelKeyframe = std::nullopt;
+}
+
+std::vector<byte> SaveItemRecord(const Item &item)
+{
+	return SaveRecordToBuffer([&](SaveHelper &file) { SaveItem(file, item); });
+}
+
+std::vector<byte> SavePlayerRecord(const Player &player)
+{
+	return SaveRecordToBuffer([&](SaveHelper &file) { SavePlayer(file, player); });
+}
+
+std::vector<byte> SaveMonsterRecord(Monster &monster)
+{
+	return SaveRecordToBuffer([&](SaveHelper &file) { SaveMonster(&file, monster); });
+}
+
+std::vector<byte> SaveMissileRecord(Missile &missile)
+{
+	return SaveRecordToBuffer([&](SaveHelper &file) { SaveMissile(&file, missile); });
+}
+
+std::vector<byte> SaveObjectRecord(const Object &object)
+{
+	return SaveRecordToBuffer([&](SaveHelper &file) { SaveObject(file, object); });
+}
+
+void LoadItemRecord(const std::vector<byte> &record, Item &item)
+{
+	LoadHelper file = LoadRecordFromBuffer(record);
+	LoadItemData(file, item);
+}
+
+void LoadPlayerRecord(const std::vector<byte> &record, Player &player)
+{
+	LoadHelper file = LoadRecordFromBuffer(record);
+	LoadPlayer(file, player);
+}
+
+void LoadMonsterRecord(const std::vector<byte> &record, Monster &monster)
+{
+	LoadHelper file = LoadRecordFromBuffer(record);
+	// Without a level around it the monster type is unknown, so its animation is not synced
+	const bool skipSync = gbSkipSync;
+	gbSkipSync = true;
+	LoadMonster(&file, monster);
+	gbSkipSync = skipSync;
+}
+
+void LoadMissileRecord(const std::vector<byte> &record, Missile &missile)
+{
+	LoadHelper file = LoadRecordFromBuffer(record);
+	LoadMissile(&file, missile);
+}
+
+void LoadObjectRecord(const std::vector<byte> &record, Object &object)
+{
+	LoadHelper file = LoadRecordFromBuffer(record);
+	LoadObject(file, object);
+}
+
 } // namespace devilution
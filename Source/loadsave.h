@@ -5,10 +5,16 @@
  */
 #pragma once
 
+#include <vector>
+
 #include "player.h"
 
 namespace devilution {
 
+struct Missile;
+struct Monster;
+struct Object;
+
 extern bool gbIsHellfireSaveGame;
 extern uint8_t giNumberOfLevels;
 
@@ -35,7 +41,35 @@ void SaveHotkeys();
 void SaveHeroItems(Player &player);
 void SaveGameData();
 void SaveGame();
+/**
+ * @brief Saves the current level when leaving it.
+ *
+ * Only the bytes that changed since the level's keyframe are written, with a full keyframe every so often.
+ */
 void SaveLevel();
 void LoadLevel();
+/** @brief Forgets the keyframe of the loaded level, so the next SaveLevel writes a full one. */
+void ClearLevelKeyframe();
+
+/**
+ * @brief Encodes a single record the way it is stored in the save files, for checking the format without a game.
+ *
+ * Items and players follow gbIsHellfire, like SaveGame.
+ */
+std::vector<byte> SaveItemRecord(const Item &item);
+std::vector<byte> SavePlayerRecord(const Player &player);
+std::vector<byte> SaveMonsterRecord(Monster &monster);
+std::vector<byte> SaveMissileRecord(Missile &missile);
+std::vector<byte> SaveObjectRecord(const Object &object);
+/**
+ * @brief Decodes a record written by the matching Save*Record.
+ *
+ * Items and players follow gbIsHellfireSaveGame, like LoadGame.
+ */
+void LoadItemRecord(const std::vector<byte> &record, Item &item);
+void LoadPlayerRecord(const std::vector<byte> &record, Player &player);
+void LoadMonsterRecord(const std::vector<byte> &record, Monster &monster);
+void LoadMissileRecord(const std::vector<byte> &record, Missile &missile);
+void LoadObjectRecord(const std::vector<byte> &record, Object &object);
 
 } // namespace devilution
@@ -0,0 +1,274 @@
+#include "mpq/asset_pack.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#include <libmpq/mpq.h>
+
+#include "utils/endian.hpp"
+#include "utils/file_util.h"
+
+namespace devilution {
+
+namespace {
+
+/** Displacements tried per bucket before giving up on building the directory. */
+constexpr uint32_t MaxDisplacement = 1U << 24;
+
+/**
+ * @brief Seeks to an absolute offset.
+ *
+ * fseek takes a long, which is 32 bits on Windows, so packs larger than that are not supported.
+ */
+bool Seek(std::FILE *file, uint64_t offset)
+{
+	if (offset > static_cast<uint64_t>(std::numeric_limits<long>::max()))
+		return false;
+	return std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0;
+}
+
+uint64_t AlignToPage(uint64_t offset)
+{
+	return (offset + AssetPackPageSize - 1) / AssetPackPageSize * AssetPackPageSize;
+}
+
+} // namespace
+
+uint32_t AssetPackSlotIndex(uint32_t hash, uint32_t displacement, uint32_t slotCount)
+{
+	// Murmur3 finalizer, so that consecutive displacements give unrelated slots.
+	uint32_t x = hash ^ (displacement * 0x9E3779B1U);
+	x ^= x >> 16;
+	x *= 0x85EBCA6BU;
+	x ^= x >> 13;
+	x *= 0xC2B2AE35U;
+	x ^= x >> 16;
+	return x % slotCount;
+}
+
+std::optional<AssetPack> AssetPack::Open(const char *path, int32_t &error)
+{
+	error = 0;
+	std::unique_ptr<std::FILE, FileCloser> file { FOpen(path, "rb") };
+	if (file == nullptr) {
+		if (errno != ENOENT)
+			error = LIBMPQ_ERROR_OPEN;
+		return std::nullopt;
+	}
+
+	uint8_t header[AssetPackHeaderSize];
+	if (std::fread(header, sizeof(header), 1, file.get()) != 1) {
+		error = LIBMPQ_ERROR_FORMAT;
+		return std::nullopt;
+	}
+	if (std::memcmp(header, AssetPackMagic.data(), AssetPackMagic.size()) != 0 || LoadLE32(&header[4]) != AssetPackVersion) {
+		error = LIBMPQ_ERROR_FORMAT;
+		return std::nullopt;
+	}
+	const uint32_t bucketCount = LoadLE32(&header[12]);
+	const uint32_t slotCount = LoadLE32(&header[16]);
+	const uint64_t directoryOffset = LoadLE64(&header[24]);
+	const AssetPackSource source { LoadLE64(&header[32]), static_cast<int64_t>(LoadLE64(&header[40])) };
+	if (bucketCount == 0 || slotCount == 0) {
+		error = LIBMPQ_ERROR_FORMAT;
+		return std::nullopt;
+	}
+
+	const std::size_t directorySize = bucketCount * sizeof(uint32_t) + static_cast<std::size_t>(slotCount) * AssetPackSlotSize;
+	std::vector<uint8_t> buf(directorySize);
+	if (!Seek(file.get(), directoryOffset)
+	    || std::fread(buf.data(), directorySize, 1, file.get()) != 1) {
+		error = LIBMPQ_ERROR_FORMAT;
+		return std::nullopt;
+	}
+
+	auto directory = std::make_shared<Directory>();
+	directory->source = source;
+	const uint8_t *in = buf.data();
+	directory->displacements.resize(bucketCount);
+	for (uint32_t &displacement : directory->displacements) {
+		displacement = LoadLE32(in);
+		in += sizeof(uint32_t);
+	}
+	directory->slots.resize(slotCount);
+	for (AssetPackSlot &slot : directory->slots) {
+		slot.hash = { LoadLE32(&in[0]), LoadLE32(&in[4]), LoadLE32(&in[8]) };
+		slot.flags = LoadLE32(&in[12]);
+		slot.offset = LoadLE64(&in[16]);
+		slot.size = LoadLE64(&in[24]);
+		in += AssetPackSlotSize;
+	}
+
+	return AssetPack { path, std::move(file), std::move(directory) };
+}
+
+std::optional<AssetPack> AssetPack::Clone(int32_t &error) const
+{
+	std::unique_ptr<std::FILE, FileCloser> file { FOpen(path_.c_str(), "rb") };
+	if (file == nullptr) {
+		error = LIBMPQ_ERROR_OPEN;
+		return std::nullopt;
+	}
+	error = 0;
+	return AssetPack { path_, std::move(file), directory_ };
+}
+
+bool AssetPack::GetFileNumber(FileHash fileHash, uint32_t &fileNumber) const
+{
+	const uint32_t bucket = fileHash[0] % directory_->displacements.size();
+	const uint32_t slotCount = static_cast<uint32_t>(directory_->slots.size());
+	const uint32_t index = AssetPackSlotIndex(fileHash[1], directory_->displacements[bucket], slotCount);
+	const AssetPackSlot &slot = directory_->slots[index];
+	if ((slot.flags & AssetPackSlotUsed) == 0 || slot.hash != fileHash)
+		return false;
+	fileNumber = index;
+	return true;
+}
+
+int32_t AssetPack::Read(uint64_t offset, void *out, std::size_t size)
+{
+	if (!Seek(file_.get(), offset))
+		return LIBMPQ_ERROR_SEEK;
+	if (size != 0 && std::fread(out, size, 1, file_.get()) != 1)
+		return LIBMPQ_ERROR_READ;
+	return 0;
+}
+
+std::unique_ptr<byte[]> AssetPack::ReadFile(uint32_t fileNumber, std::size_t &fileSize, int32_t &error)
+{
+	const AssetPackSlot &slot = directory_->slots[fileNumber];
+	auto result = std::make_unique<byte[]>(slot.size);
+	error = Read(slot.offset, result.get(), slot.size);
+	if (error != 0)
+		return nullptr;
+	fileSize = slot.size;
+	return result;
+}
+
+int32_t AssetPack::ReadBlock(uint32_t fileNumber, uint32_t blockNumber, uint8_t *out, uint32_t outSize)
+{
+	if (outSize < GetBlockSize(fileNumber, blockNumber))
+		return LIBMPQ_ERROR_SIZE;
+	const AssetPackSlot &slot = directory_->slots[fileNumber];
+	return Read(slot.offset + static_cast<uint64_t>(blockNumber) * AssetPackPageSize, out, GetBlockSize(fileNumber, blockNumber));
+}
+
+uint32_t AssetPack::GetNumBlocks(uint32_t fileNumber) const
+{
+	const uint64_t size = directory_->slots[fileNumber].size;
+	return std::max<uint32_t>(static_cast<uint32_t>((size + AssetPackPageSize - 1) / AssetPackPageSize), 1);
+}
+
+std::size_t AssetPack::GetBlockSize(uint32_t fileNumber, uint32_t blockNumber) const
+{
+	const uint64_t size = directory_->slots[fileNumber].size;
+	const uint64_t blockOffset = static_cast<uint64_t>(blockNumber) * AssetPackPageSize;
+	if (blockOffset >= size)
+		return 0;
+	return std::min<uint64_t>(size - blockOffset, AssetPackPageSize);
+}
+
+bool AssetPackWriter::Open(const char *path)
+{
+	file_ = FOpen(path, "wb");
+	return file_ != nullptr;
+}
+
+bool AssetPackWriter::WriteAt(uint64_t offset, const void *data, std::size_t size)
+{
+	return Seek(file_, offset)
+	    && (size == 0 || std::fwrite(data, size, 1, file_) == 1);
+}
+
+bool AssetPackWriter::AddFile(AssetPack::FileHash fileHash, const byte *data, std::size_t size)
+{
+	const bool duplicate = std::any_of(files_.begin(), files_.end(), [&](const AssetPackSlot &file) { return file.hash == fileHash; });
+	if (duplicate)
+		return false;
+	if (!WriteAt(end_, data, size))
+		return false;
+	files_.push_back(AssetPackSlot { fileHash, AssetPackSlotUsed, end_, size });
+	end_ = AlignToPage(end_ + size);
+	return true;
+}
+
+bool AssetPackWriter::Finish(const AssetPackSource &source)
+{
+	const auto fileCount = static_cast<uint32_t>(files_.size());
+	const uint32_t bucketCount = std::max<uint32_t>((fileCount + 3) / 4, 1);
+	const uint32_t slotCount = fileCount + fileCount / 4 + 1;
+
+	std::vector<std::vector<uint32_t>> buckets(bucketCount);
+	for (uint32_t i = 0; i < fileCount; i++)
+		buckets[files_[i].hash[0] % bucketCount].push_back(i);
+
+	// Place the largest buckets first while most slots are still free.
+	std::vector<uint32_t> order(bucketCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+	std::vector<uint32_t> displacements(bucketCount, 0);
+	std::vector<AssetPackSlot> slots(slotCount, AssetPackSlot { { 0, 0, 0 }, 0, 0, 0 });
+	std::vector<uint32_t> candidate;
+	for (uint32_t bucket : order) {
+		const std::vector<uint32_t> &files = buckets[bucket];
+		if (files.empty())
+			break;
+		uint32_t displacement = 0;
+		for (; displacement < MaxDisplacement; displacement++) {
+			candidate.clear();
+			for (uint32_t file : files) {
+				const uint32_t index = AssetPackSlotIndex(files_[file].hash[1], displacement, slotCount);
+				if (slots[index].flags != 0 || std::find(candidate.begin(), candidate.end(), index) != candidate.end())
+					break;
+				candidate.push_back(index);
+			}
+			if (candidate.size() == files.size())
+				break;
+		}
+		if (displacement == MaxDisplacement)
+			return false;
+		displacements[bucket] = displacement;
+		for (std::size_t i = 0; i < files.size(); i++)
+			slots[candidate[i]] = files_[files[i]];
+	}
+
+	std::vector<uint8_t> directory(bucketCount * sizeof(uint32_t) + static_cast<std::size_t>(slotCount) * AssetPackSlotSize);
+	uint8_t *out = directory.data();
+	for (uint32_t displacement : displacements) {
+		StoreLE32(out, displacement);
+		out += sizeof(uint32_t);
+	}
+	for (const AssetPackSlot &slot : slots) {
+		StoreLE32(&out[0], slot.hash[0]);
+		StoreLE32(&out[4], slot.hash[1]);
+		StoreLE32(&out[8], slot.hash[2]);
+		StoreLE32(&out[12], slot.flags);
+		StoreLE64(&out[16], slot.offset);
+		StoreLE64(&out[24], slot.size);
+		out += AssetPackSlotSize;
+	}
+	if (!WriteAt(end_, directory.data(), directory.size()))
+		return false;
+
+	uint8_t header[AssetPackHeaderSize] = {};
+	std::memcpy(header, AssetPackMagic.data(), AssetPackMagic.size());
+	StoreLE32(&header[4], AssetPackVersion);
+	StoreLE32(&header[8], fileCount);
+	StoreLE32(&header[12], bucketCount);
+	StoreLE32(&header[16], slotCount);
+	StoreLE64(&header[24], end_);
+	StoreLE64(&header[32], source.size);
+	StoreLE64(&header[40], static_cast<uint64_t>(source.modified));
+	if (!WriteAt(0, header, sizeof(header)))
+		return false;
+
+	const bool closed = std::fclose(file_) == 0;
+	file_ = nullptr;
+	return closed;
+}
+
+} // namespace devilution
@@ -0,0 +1,166 @@
+/**
+ * @file mpq/asset_pack.hpp
+ *
+ * Interface of the fast-loading asset pack format produced from MPQ archives by devilutionx-pack.
+ *
+ * Layout, all integers little-endian:
+ *
+ *     header         48 bytes: magic, version, file count, bucket count, slot count, 4 unused bytes,
+ *                    directory offset (u64), then the size (u64) and modification time (i64) of the source MPQ
+ *     payloads       uncompressed file contents, each starting on an AssetPackPageSize boundary
+ *     displacements  uint32_t[bucketCount]
+ *     slots          AssetPackSlotSize bytes each: hash[3], flags, offset (u64), size (u64)
+ *
+ * Files are looked up by their MPQ file hash through a perfect hash (hash and displace):
+ * `hash[0]` selects a bucket, and the bucket's displacement combined with `hash[1]` selects
+ * the only slot the file can be in, so a lookup never probes more than one slot.
+ *
+ * A pack is only used while its source MPQ is unchanged, see AssetPackSource.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "utils/stdcompat/cstddef.hpp"
+#include "utils/stdcompat/optional.hpp"
+
+namespace devilution {
+
+constexpr std::array<char, 4> AssetPackMagic { 'D', 'V', 'P', 'K' };
+constexpr uint32_t AssetPackVersion = 2;
+constexpr uint32_t AssetPackPageSize = 4096;
+constexpr uint32_t AssetPackHeaderSize = 48;
+constexpr uint32_t AssetPackSlotSize = 32;
+constexpr char AssetPackExtension[] = ".dvp";
+
+struct AssetPackSlot {
+	std::array<uint32_t, 3> hash;
+	uint32_t flags;
+	uint64_t offset;
+	uint64_t size;
+};
+
+constexpr uint32_t AssetPackSlotUsed = 1;
+
+/**
+ * @brief The MPQ a pack was made from, as it was on disk then.
+ *
+ * When the MPQ no longer matches, for example after it was replaced by another language or version,
+ * the pack is stale and the MPQ is read instead.
+ */
+struct AssetPackSource {
+	uint64_t size;
+	/** As returned by GetFileStatus, only compared for equality */
+	int64_t modified;
+};
+
+/** @brief Returns the slot for a hash given its bucket's displacement. */
+uint32_t AssetPackSlotIndex(uint32_t hash, uint32_t displacement, uint32_t slotCount);
+
+/**
+ * @brief Read-only access to an asset pack.
+ *
+ * Mirrors the reading interface of MpqArchive. Error codes are libmpq error codes,
+ * so MpqArchive::ErrorMessage can describe them.
+ */
+class AssetPack {
+public:
+	using FileHash = std::array<std::uint32_t, 3>;
+
+	// If the file does not exist, returns nullopt without an error.
+	static std::optional<AssetPack> Open(const char *path, int32_t &error);
+
+	std::optional<AssetPack> Clone(int32_t &error) const;
+
+	// Returns false if the file does not exit.
+	bool GetFileNumber(FileHash fileHash, uint32_t &fileNumber) const;
+
+	std::unique_ptr<byte[]> ReadFile(uint32_t fileNumber, std::size_t &fileSize, int32_t &error);
+
+	// Returns error code.
+	int32_t ReadBlock(uint32_t fileNumber, uint32_t blockNumber, uint8_t *out, uint32_t outSize);
+
+	std::size_t GetUnpackedFileSize(uint32_t fileNumber) const
+	{
+		return directory_->slots[fileNumber].size;
+	}
+
+	uint32_t GetNumBlocks(uint32_t fileNumber) const;
+
+	std::size_t GetBlockSize(uint32_t fileNumber, uint32_t blockNumber) const;
+
+	const AssetPackSource &GetSource() const
+	{
+		return directory_->source;
+	}
+
+	// File numbers are below this, not every slot holds a file.
+	uint32_t GetNumSlots() const
+	{
+		return static_cast<uint32_t>(directory_->slots.size());
+	}
+
+private:
+	struct Directory {
+		AssetPackSource source;
+		std::vector<uint32_t> displacements;
+		std::vector<AssetPackSlot> slots;
+	};
+
+	struct FileCloser {
+		void operator()(std::FILE *file) const
+		{
+			std::fclose(file);
+		}
+	};
+
+	AssetPack(std::string path, std::unique_ptr<std::FILE, FileCloser> file, std::shared_ptr<const Directory> directory)
+	    : path_(std::move(path))
+	    , file_(std::move(file))
+	    , directory_(std::move(directory))
+	{
+	}
+
+	int32_t Read(uint64_t offset, void *out, std::size_t size);
+
+	std::string path_;
+	std::unique_ptr<std::FILE, FileCloser> file_;
+	std::shared_ptr<const Directory> directory_;
+};
+
+/**
+ * @brief Writes an asset pack. Files are appended one at a time, the directory is built by Finish.
+ */
+class AssetPackWriter {
+public:
+	bool Open(const char *path);
+
+	~AssetPackWriter()
+	{
+		if (file_ != nullptr)
+			std::fclose(file_);
+	}
+
+	/** @brief Appends a file; returns false on I/O error or if a file with the same hash was already added. */
+	bool AddFile(AssetPack::FileHash fileHash, const byte *data, std::size_t size);
+
+	/**
+	 * @brief Builds the perfect-hash directory and writes the header.
+	 * @param source The MPQ the files were taken from
+	 */
+	bool Finish(const AssetPackSource &source);
+
+private:
+	bool WriteAt(uint64_t offset, const void *data, std::size_t size);
+
+	std::FILE *file_ = nullptr;
+	uint64_t end_ = AssetPackPageSize;
+	std::vector<AssetPackSlot> files_;
+};
+
+} // namespace devilution
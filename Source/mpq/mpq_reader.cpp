@@ -2,6 +2,8 @@
 
 #include <libmpq/mpq.h>
 
+#include "utils/file_util.h"
+#include "utils/log.hpp"
 #include "utils/stdcompat/optional.hpp"
 
 namespace devilution {
@@ -18,8 +20,30 @@ std::optional<MpqArchive> MpqArchive::Open(const char *path, int32_t &error)
 	return MpqArchive { std::string(path), archive };
 }
 
+std::optional<MpqArchive> MpqArchive::OpenAssetPack(const char *path, const char *mpqPath, int32_t &error)
+{
+	std::optional<AssetPack> pack = AssetPack::Open(path, error);
+	if (!pack)
+		return std::nullopt;
+	// Without the MPQ there is nothing newer to fall back to
+	std::uintmax_t mpqSize;
+	std::int64_t mpqModified;
+	if (GetFileStatus(mpqPath, &mpqSize, &mpqModified)
+	    && (mpqSize != pack->GetSource().size || mpqModified != pack->GetSource().modified)) {
+		LogInfo("Ignoring {}, {} changed since it was made", path, mpqPath);
+		return std::nullopt;
+	}
+	return MpqArchive { std::string(path), std::move(*pack) };
+}
+
 std::optional<MpqArchive> MpqArchive::Clone(int32_t &error)
 {
+	if (pack_) {
+		std::optional<AssetPack> copy = pack_->Clone(error);
+		if (!copy)
+			return std::nullopt;
+		return MpqArchive { path_, std::move(*copy) };
+	}
 	mpq_archive_s *copy;
 	error = libmpq__archive_dup(archive_, path_.c_str(), &copy);
 	if (error != 0)
@@ -45,6 +69,8 @@ MpqArchive &MpqArchive::operator=(MpqArchive &&other) noexcept
 	if (archive_ != nullptr)
 		libmpq__archive_close(archive_);
 	archive_ = other.archive_;
+	other.archive_ = nullptr;
+	pack_ = std::move(other.pack_);
 	tmp_buf_ = std::move(other.tmp_buf_);
 	return *this;
 }
@@ -57,6 +83,8 @@ MpqArchive::~MpqArchive()
 
 bool MpqArchive::GetFileNumber(MpqArchive::FileHash fileHash, uint32_t &fileNumber)
 {
+	if (pack_)
+		return pack_->GetFileNumber(fileHash, fileNumber);
 	return libmpq__file_number_from_hash(archive_, fileHash[0], fileHash[1], fileHash[2], &fileNumber) == 0;
 }
 
@@ -64,6 +92,13 @@ std::unique_ptr<byte[]> MpqArchive::ReadFile(const char *filename, std::size_t &
 {
 	std::unique_ptr<byte[]> result;
 	std::uint32_t fileNumber;
+	if (pack_) {
+		if (!pack_->GetFileNumber(CalculateFileHash(filename), fileNumber)) {
+			error = LIBMPQ_ERROR_EXIST;
+			return result;
+		}
+		return pack_->ReadFile(fileNumber, fileSize, error);
+	}
 	error = libmpq__file_number(archive_, filename, &fileNumber);
 	if (error != 0)
 		return result;
@@ -103,6 +138,8 @@ std::unique_ptr<byte[]> MpqArchive::ReadFile(const char *filename, std::size_t &
 
 int32_t MpqArchive::ReadBlock(uint32_t fileNumber, uint32_t blockNumber, uint8_t *out, uint32_t outSize)
 {
+	if (pack_)
+		return pack_->ReadBlock(fileNumber, blockNumber, out, outSize);
 	std::vector<std::uint8_t> &tmpBuf = GetTemporaryBuffer(outSize);
 	return libmpq__block_read_with_temporary_buffer(
 	    archive_, fileNumber, blockNumber, out, static_cast<libmpq__off_t>(outSize),
@@ -112,6 +149,10 @@ int32_t MpqArchive::ReadBlock(uint32_t fileNumber, uint32_t blockNumber, uint8_t
 
 std::size_t MpqArchive::GetUnpackedFileSize(uint32_t fileNumber, int32_t &error)
 {
+	if (pack_) {
+		error = 0;
+		return pack_->GetUnpackedFileSize(fileNumber);
+	}
 	libmpq__off_t unpackedSize;
 	error = libmpq__file_size_unpacked(archive_, fileNumber, &unpackedSize);
 	return unpackedSize;
@@ -119,24 +160,48 @@ std::size_t MpqArchive::GetUnpackedFileSize(uint32_t fileNumber, int32_t &error)
 
 uint32_t MpqArchive::GetNumBlocks(uint32_t fileNumber, int32_t &error)
 {
+	if (pack_) {
+		error = 0;
+		return pack_->GetNumBlocks(fileNumber);
+	}
 	uint32_t numBlocks;
 	error = libmpq__file_blocks(archive_, fileNumber, &numBlocks);
 	return numBlocks;
 }
 
+uint32_t MpqArchive::GetNumFiles(int32_t &error)
+{
+	if (pack_) {
+		error = 0;
+		return pack_->GetNumSlots();
+	}
+	uint32_t numFiles;
+	error = libmpq__archive_files(archive_, &numFiles);
+	return numFiles;
+}
+
 int32_t MpqArchive::OpenBlockOffsetTable(uint32_t fileNumber, const char *filename)
 {
+	// Asset pack entries are stored uncompressed and have no block offset table.
+	if (pack_)
+		return 0;
 	return libmpq__block_open_offset_with_filename(archive_, fileNumber, filename);
 }
 
 int32_t MpqArchive::CloseBlockOffsetTable(uint32_t fileNumber)
 {
+	if (pack_)
+		return 0;
 	return libmpq__block_close_offset(archive_, fileNumber);
 }
 
 // Requires the block offset table to be open
 std::size_t MpqArchive::GetBlockSize(uint32_t fileNumber, uint32_t blockNumber, int32_t &error)
 {
+	if (pack_) {
+		error = 0;
+		return pack_->GetBlockSize(fileNumber, blockNumber);
+	}
 	libmpq__off_t blockSize;
 	error = libmpq__block_size_unpacked(archive_, fileNumber, blockNumber, &blockSize);
 	return blockSize;
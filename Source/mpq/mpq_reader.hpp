@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 
+#include "mpq/asset_pack.hpp"
 #include "utils/stdcompat/cstddef.hpp"
 #include "utils/stdcompat/optional.hpp"
 
@@ -21,6 +22,11 @@ public:
 	// If the file does not exist, returns nullopt without an error.
 	static std::optional<MpqArchive> Open(const char *path, int32_t &error);
 
+	// Opens an asset pack created by devilutionx-pack, which is then read through the same interface.
+	// If the file does not exist, or the MPQ at mpqPath is no longer the one the pack was made from,
+	// returns nullopt without an error.
+	static std::optional<MpqArchive> OpenAssetPack(const char *path, const char *mpqPath, int32_t &error);
+
 	std::optional<MpqArchive> Clone(int32_t &error);
 
 	static const char *ErrorMessage(int32_t errorCode);
@@ -31,6 +37,7 @@ public:
 	MpqArchive(MpqArchive &&other) noexcept
 	    : path_(std::move(other.path_))
 	    , archive_(other.archive_)
+	    , pack_(std::move(other.pack_))
 	    , tmp_buf_(std::move(other.tmp_buf_))
 	{
 		other.archive_ = nullptr;
@@ -52,6 +59,9 @@ public:
 
 	uint32_t GetNumBlocks(uint32_t fileNumber, int32_t &error);
 
+	// File numbers go from 0 to this. In an MPQ every one of them is a file, in an asset pack some are unused.
+	uint32_t GetNumFiles(int32_t &error);
+
 	int32_t OpenBlockOffsetTable(uint32_t fileNumber, const char *filename);
 
 	int32_t CloseBlockOffsetTable(uint32_t fileNumber);
@@ -66,6 +76,13 @@ private:
 	{
 	}
 
+	MpqArchive(std::string path, AssetPack pack)
+	    : path_(std::move(path))
+	    , archive_(nullptr)
+	    , pack_(std::move(pack))
+	{
+	}
+
 	std::vector<std::uint8_t> &GetTemporaryBuffer(std::size_t size)
 	{
 		if (tmp_buf_.size() < size)
@@ -75,6 +92,7 @@ private:
 
 	std::string path_;
 	mpq_archive_s *archive_;
+	std::optional<AssetPack> pack_;
 	std::vector<std::uint8_t> tmp_buf_;
 };
 
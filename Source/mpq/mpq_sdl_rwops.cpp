@@ -1,13 +1,161 @@
 #include "mpq/mpq_sdl_rwops.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+#include "utils/sdl_cond.h"
+#include "utils/sdl_mutex.h"
+#include "utils/sdl_thread.h"
+
 namespace devilution {
 
 namespace {
 
+/** Number of decompressed blocks kept per streamed file. */
+constexpr uint32_t NumCachedBlocks = 4;
+
+/** Number of blocks past the current one that the worker decompresses ahead of the reader. */
+constexpr uint32_t NumReadaheadBlocks = NumCachedBlocks - 1;
+
+enum class BlockState : uint8_t {
+	Empty,
+	Queued,
+	Ready,
+};
+
+struct CachedBlock {
+	uint32_t blockNumber;
+	BlockState state = BlockState::Empty;
+	std::unique_ptr<uint8_t[]> data;
+};
+
+/**
+ * @brief Ring of decompressed blocks shared between a thread-safe MPQ RWops and the readahead worker.
+ *
+ * Block `n` lives in slot `n % NumCachedBlocks`. The mutex guards both the slots
+ * and the archive, so the reader and the worker never decompress concurrently
+ * and a reader asking for a block that is being decompressed simply waits for it.
+ */
+struct ReadaheadState : std::enable_shared_from_this<ReadaheadState> {
+	SdlMutex mutex;
+	MpqArchive *mpqArchive;
+	uint32_t fileNumber;
+	uint32_t blockSize;
+	uint32_t lastBlockSize;
+	uint32_t numBlocks;
+	bool closed = false;
+	std::array<CachedBlock, NumCachedBlocks> cache;
+
+	[[nodiscard]] uint32_t GetBlockSize(uint32_t blockNumber) const
+	{
+		return blockNumber + 1 == numBlocks ? lastBlockSize : blockSize;
+	}
+
+	/**
+	 * @brief Copies the block into `out`, decompressing it in place if readahead has not got to it yet.
+	 * @return MPQ error code
+	 */
+	int32_t Read(uint32_t blockNumber, uint8_t *out);
+
+	/** @brief Queues the blocks following `blockNumber` for decompression on the worker thread. */
+	void Prefetch(uint32_t blockNumber);
+
+	/** @brief Called on the worker thread to fill a queued slot. */
+	void Load(uint32_t blockNumber);
+};
+
+struct ReadaheadRequest {
+	std::shared_ptr<ReadaheadState> state;
+	uint32_t blockNumber;
+};
+
+std::optional<SdlMutex> ReadaheadMutex;
+std::optional<SdlCond> ReadaheadWorkToDo;
+std::deque<ReadaheadRequest> ReadaheadRequests;
+/** Written under ReadaheadMutex, also read without it by threads opening files */
+std::atomic<bool> ReadaheadRunning;
+SdlThread ReadaheadThread;
+
+void ReadaheadHandler()
+{
+	std::lock_guard<SdlMutex> lock(*ReadaheadMutex);
+	while (true) {
+		while (!ReadaheadRequests.empty()) {
+			ReadaheadRequest request = std::move(ReadaheadRequests.front());
+			ReadaheadRequests.pop_front();
+
+			ReadaheadMutex->unlock();
+			request.state->Load(request.blockNumber);
+			request.state = nullptr;
+			ReadaheadMutex->lock();
+		}
+		if (!ReadaheadRunning)
+			return;
+		ReadaheadWorkToDo->wait(*ReadaheadMutex);
+	}
+}
+
+void QueueReadahead(std::shared_ptr<ReadaheadState> state, uint32_t blockNumber)
+{
+	std::lock_guard<SdlMutex> lock(*ReadaheadMutex);
+	ReadaheadRequests.push_back(ReadaheadRequest { std::move(state), blockNumber });
+	ReadaheadWorkToDo->signal();
+}
+
+int32_t ReadaheadState::Read(uint32_t blockNumber, uint8_t *out)
+{
+	std::lock_guard<SdlMutex> lock(mutex);
+	CachedBlock &slot = cache[blockNumber % NumCachedBlocks];
+	if (slot.state == BlockState::Ready && slot.blockNumber == blockNumber) {
+		std::memcpy(out, slot.data.get(), GetBlockSize(blockNumber));
+		return 0;
+	}
+
+	// Either a miss or the worker has not started on this block yet: claim the
+	// slot so the worker skips it, and decompress directly into the output.
+	if (slot.state == BlockState::Queued && slot.blockNumber == blockNumber)
+		slot.state = BlockState::Empty;
+	return mpqArchive->ReadBlock(fileNumber, blockNumber, out, GetBlockSize(blockNumber));
+}
+
+void ReadaheadState::Prefetch(uint32_t blockNumber)
+{
+	std::lock_guard<SdlMutex> lock(mutex);
+	const uint32_t lastBlock = std::min(blockNumber + NumReadaheadBlocks, numBlocks - 1);
+	for (uint32_t next = blockNumber + 1; next <= lastBlock; ++next) {
+		CachedBlock &slot = cache[next % NumCachedBlocks];
+		if (slot.state != BlockState::Empty && slot.blockNumber == next)
+			continue;
+		if (slot.state == BlockState::Queued)
+			continue;
+		if (slot.data == nullptr)
+			slot.data = std::unique_ptr<uint8_t[]> { new uint8_t[blockSize] };
+		slot.blockNumber = next;
+		slot.state = BlockState::Queued;
+		// The request keeps the state alive after the RWops is closed,
+		// `closed` then stops the worker from touching the archive.
+		QueueReadahead(shared_from_this(), next);
+	}
+}
+
+void ReadaheadState::Load(uint32_t blockNumber)
+{
+	std::lock_guard<SdlMutex> lock(mutex);
+	if (closed)
+		return;
+	CachedBlock &slot = cache[blockNumber % NumCachedBlocks];
+	if (slot.state != BlockState::Queued || slot.blockNumber != blockNumber)
+		return;
+	const int32_t error = mpqArchive->ReadBlock(fileNumber, blockNumber, slot.data.get(), GetBlockSize(blockNumber));
+	slot.state = error == 0 ? BlockState::Ready : BlockState::Empty;
+}
+
 struct Data {
 	// File information:
 	std::optional<MpqArchive> ownedArchive;
@@ -22,6 +170,9 @@ struct Data {
 	uint32_t position;
 	bool blockRead;
 	std::unique_ptr<uint8_t[]> blockData;
+
+	// Set for thread-safe handles while the readahead worker is running.
+	std::shared_ptr<ReadaheadState> readahead;
 };
 
 Data *GetData(struct SDL_RWops *context)
@@ -112,12 +263,16 @@ static SizeType MpqFileRwRead(struct SDL_RWops *context, void *ptr, SizeType siz
 		const uint32_t currentBlockSize = blockNumber + 1 == data.numBlocks ? data.lastBlockSize : data.blockSize;
 
 		if (!data.blockRead) {
-			const int32_t error = data.mpqArchive->ReadBlock(data.fileNumber, blockNumber, data.blockData.get(), currentBlockSize);
+			const int32_t error = data.readahead != nullptr
+			    ? data.readahead->Read(blockNumber, data.blockData.get())
+			    : data.mpqArchive->ReadBlock(data.fileNumber, blockNumber, data.blockData.get(), currentBlockSize);
 			if (error != 0) {
 				SDL_SetError("MpqFileRwRead ReadBlock: %s", MpqArchive::ErrorMessage(error));
 				return 0;
 			}
 			data.blockRead = true;
+			if (data.readahead != nullptr)
+				data.readahead->Prefetch(blockNumber);
 		}
 
 		const uint32_t blockPosition = data.position - blockNumber * data.blockSize;
@@ -143,7 +298,13 @@ static SizeType MpqFileRwRead(struct SDL_RWops *context, void *ptr, SizeType siz
 static int MpqFileRwClose(struct SDL_RWops *context)
 {
 	Data *data = GetData(context);
-	data->mpqArchive->CloseBlockOffsetTable(data->fileNumber);
+	if (data->readahead != nullptr) {
+		std::lock_guard<SdlMutex> lock(data->readahead->mutex);
+		data->readahead->closed = true;
+		data->mpqArchive->CloseBlockOffsetTable(data->fileNumber);
+	} else {
+		data->mpqArchive->CloseBlockOffsetTable(data->fileNumber);
+	}
 	delete data;
 	delete context;
 	return 0;
@@ -225,8 +386,43 @@ SDL_RWops *SDL_RWops_FromMpqFile(MpqArchive &mpqArchive, uint32_t fileNumber, co
 	data->position = 0;
 	data->blockRead = false;
 
+	if (threadsafe && numBlocks > 1 && ReadaheadRunning) {
+		auto readahead = std::make_shared<ReadaheadState>();
+		readahead->mpqArchive = data->mpqArchive;
+		readahead->fileNumber = data->fileNumber;
+		readahead->blockSize = data->blockSize;
+		readahead->lastBlockSize = data->lastBlockSize;
+		readahead->numBlocks = data->numBlocks;
+		data->readahead = std::move(readahead);
+	}
+
 	SetData(result.get(), data.release());
 	return result.release();
 }
 
+void MpqReadaheadStart()
+{
+	ReadaheadRunning = true;
+	ReadaheadMutex.emplace();
+	ReadaheadWorkToDo.emplace();
+	ReadaheadThread = SdlThread { ReadaheadHandler };
+}
+
+void MpqReadaheadCleanup()
+{
+	if (!ReadaheadRunning)
+		return;
+
+	{
+		std::lock_guard<SdlMutex> lock(*ReadaheadMutex);
+		ReadaheadRunning = false;
+		ReadaheadRequests.clear();
+		ReadaheadWorkToDo->signal();
+	}
+
+	ReadaheadThread.join();
+	ReadaheadMutex = std::nullopt;
+	ReadaheadWorkToDo = std::nullopt;
+}
+
 } // namespace devilution
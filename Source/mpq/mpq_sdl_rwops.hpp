@@ -10,4 +10,16 @@ namespace devilution {
 
 SDL_RWops *SDL_RWops_FromMpqFile(MpqArchive &mpqArchive, uint32_t fileNumber, const char *filename, bool threadsafe);
 
+/**
+ * @brief Starts the worker that decompresses upcoming blocks of thread-safe (streamed) MPQ files.
+ *
+ * Handles opened while the worker is not running read every block on demand.
+ */
+void MpqReadaheadStart();
+
+/**
+ * @brief Stops the readahead worker. All streamed MPQ files must be closed before the archives are.
+ */
+void MpqReadaheadCleanup();
+
 } // namespace devilution
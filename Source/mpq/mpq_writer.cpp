@@ -1,10 +1,16 @@
 #include "mpq/mpq_writer.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <iterator>
 #include <memory>
+#include <string>
 #include <type_traits>
+#include <vector>
 
 #include "appfat.h"
 #include "encrypt.h"
@@ -12,6 +18,7 @@
 #include "utils/endian.hpp"
 #include "utils/file_util.h"
 #include "utils/log.hpp"
+#include "utils/sdl_thread.h"
 
 namespace devilution {
 
@@ -43,6 +50,7 @@ constexpr std::size_t BlockEntrySize = INDEX_ENTRIES * sizeof(_BLOCKENTRY);
 constexpr std::size_t HashEntrySize = INDEX_ENTRIES * sizeof(_HASHENTRY);
 constexpr std::ios::off_type MpqBlockEntryOffset = sizeof(_FILEHEADER);
 constexpr std::ios::off_type MpqHashEntryOffset = MpqBlockEntryOffset + BlockEntrySize;
+constexpr std::size_t TablesSize = MpqHashEntryOffset + HashEntrySize;
 
 void ByteSwapHdr(_FILEHEADER *hdr)
 {
@@ -57,12 +65,214 @@ void ByteSwapHdr(_FILEHEADER *hdr)
 	hdr->blockcount = SDL_SwapLE32(hdr->blockcount);
 }
 
+constexpr size_t SectorSize = 4096;
+/** The largest save files have fewer than 100 sectors, more threads than this gain little */
+constexpr int MaxCompressionThreads = 4;
+
+/** Sectors of one file, each compressed in place in its own SectorSize slot */
+struct SectorCompression {
+	CompressionCodec codec;
+	byte *sectors;
+	uint32_t *sectorSizes;
+	size_t dataLen;
+	uint32_t numSectors;
+	std::atomic<uint32_t> nextSector;
+};
+
+void CompressSectors(SectorCompression &job)
+{
+	for (uint32_t i = job.nextSector++; i < job.numSectors; i = job.nextSector++) {
+		const size_t offset = i * SectorSize;
+		const uint32_t len = std::min(job.dataLen - offset, SectorSize);
+		job.sectorSizes[i] = CompressInPlace(job.codec, &job.sectors[offset], len);
+	}
+}
+
+int SDLCALL CompressSectorsThread(void *data)
+{
+	CompressSectors(*static_cast<SectorCompression *>(data));
+	return 0;
+}
+
+/*
+ * The journal holds the tables of a commit until they are in place:
+ * magic, file size, header and tables, and a checksum over all of that.
+ */
+constexpr const char *JournalSuffix = ".journal";
+constexpr std::size_t JournalHeaderSize = 2 * sizeof(uint32_t);
+constexpr std::size_t JournalSize = JournalHeaderSize + TablesSize + sizeof(uint32_t);
+
+/* The checksum file: magic, count, then each file as name length, name and checksum. */
+constexpr const char *ChecksumSuffix = ".sum";
+
+constexpr uint32_t RotateLeft(uint32_t value, unsigned bits)
+{
+	return (value << bits) | (value >> (32 - bits));
+}
+
+/** @brief Writes the tables over the ones at the start of the archive and sets its size. */
+bool ApplyTables(const char *path, const byte *tables, uint32_t fileSize)
+{
+	LoggedFStream stream;
+	if (!stream.Open(path, std::ios::in | std::ios::out | std::ios::binary))
+		return false;
+	const bool written = stream.Write(reinterpret_cast<const char *>(tables), TablesSize);
+	stream.Close();
+	return written && ResizeFile(path, fileSize) && SyncFile(path);
+}
+
+bool WriteJournal(const std::string &path, const byte *tables, uint32_t fileSize)
+{
+	std::unique_ptr<byte[]> journal { new byte[JournalSize] };
+	StoreLE32(&journal[0], LoadLE32("MPQJ"));
+	StoreLE32(&journal[sizeof(uint32_t)], fileSize);
+	memcpy(&journal[JournalHeaderSize], tables, TablesSize);
+	StoreLE32(&journal[JournalHeaderSize + TablesSize], MpqFileChecksum(journal.get(), JournalHeaderSize + TablesSize));
+
+	// The first commit creates the journal, which is lost in a crash unless its directory entry is on the disk too
+	const bool created = !FileExists(path.c_str());
+	LoggedFStream stream;
+	if (!stream.Open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc))
+		return false;
+	const bool written = stream.Write(reinterpret_cast<const char *>(journal.get()), JournalSize);
+	stream.Close();
+	return written && SyncFile(path.c_str()) && (!created || SyncParentDirectory(path.c_str()));
+}
+
+std::map<std::string, uint32_t> ReadChecksums(const char *archivePath)
+{
+	std::map<std::string, uint32_t> checksums;
+	const std::string path = std::string(archivePath) + ChecksumSuffix;
+	std::uintmax_t size;
+	if (!GetFileSize(path.c_str(), &size) || size < 2 * sizeof(uint32_t))
+		return checksums;
+	std::unique_ptr<byte[]> data { new byte[size] };
+	LoggedFStream stream;
+	if (!stream.Open(path.c_str(), std::ios::in | std::ios::binary) || !stream.Read(reinterpret_cast<char *>(data.get()), size))
+		return checksums;
+	if (LoadLE32(&data[0]) != LoadLE32("MPQS"))
+		return checksums;
+
+	const uint32_t count = LoadLE32(&data[sizeof(uint32_t)]);
+	size_t offset = 2 * sizeof(uint32_t);
+	for (uint32_t i = 0; i < count && offset < size; i++) {
+		const size_t nameLength = static_cast<uint8_t>(data[offset]);
+		offset++;
+		if (size - offset < nameLength + sizeof(uint32_t))
+			break;
+		std::string name(reinterpret_cast<const char *>(&data[offset]), nameLength);
+		checksums[std::move(name)] = LoadLE32(&data[offset + nameLength]);
+		offset += nameLength + sizeof(uint32_t);
+	}
+	return checksums;
+}
+
+void WriteChecksums(const std::string &archivePath, const std::map<std::string, uint32_t> &checksums)
+{
+	std::vector<byte> data(2 * sizeof(uint32_t));
+	StoreLE32(&data[0], LoadLE32("MPQS"));
+	uint32_t count = 0;
+	for (const auto &checksum : checksums) {
+		if (checksum.first.size() > UINT8_MAX)
+			continue;
+		data.push_back(static_cast<byte>(checksum.first.size()));
+		const auto *name = reinterpret_cast<const byte *>(checksum.first.data());
+		data.insert(data.end(), name, name + checksum.first.size());
+		data.resize(data.size() + sizeof(uint32_t));
+		StoreLE32(&data[data.size() - sizeof(uint32_t)], checksum.second);
+		count++;
+	}
+	StoreLE32(&data[sizeof(uint32_t)], count);
+
+	// Only a hint: a stale or damaged file just means contents have to be checked the slow way
+	LoggedFStream stream;
+	const std::string path = archivePath + ChecksumSuffix;
+	if (stream.Open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc))
+		stream.Write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
 } // namespace
 
+uint32_t MpqFileChecksum(const byte *data, size_t size)
+{
+	constexpr uint32_t Prime1 = 0x9E3779B1U;
+	constexpr uint32_t Prime2 = 0x85EBCA77U;
+	constexpr uint32_t Prime3 = 0xC2B2AE3DU;
+	constexpr uint32_t Prime4 = 0x27D4EB2FU;
+	constexpr uint32_t Prime5 = 0x165667B1U;
+
+	const byte *end = data + size;
+	uint32_t hash;
+	if (size >= 16) {
+		// Four independent lanes, so the multiplications of one round overlap
+		uint32_t lanes[4] = { Prime1 + Prime2, Prime2, 0, 0U - Prime1 };
+		for (; end - data >= 16; data += 16) {
+			for (int i = 0; i < 4; i++)
+				lanes[i] = RotateLeft(lanes[i] + LoadLE32(&data[i * 4]) * Prime2, 13) * Prime1;
+		}
+		hash = RotateLeft(lanes[0], 1) + RotateLeft(lanes[1], 7) + RotateLeft(lanes[2], 12) + RotateLeft(lanes[3], 18);
+	} else {
+		hash = Prime5;
+	}
+	hash += static_cast<uint32_t>(size);
+	for (; end - data >= 4; data += 4)
+		hash = RotateLeft(hash + LoadLE32(data) * Prime3, 17) * Prime4;
+	for (; data != end; data++)
+		hash = RotateLeft(hash + static_cast<uint8_t>(*data) * Prime5, 11) * Prime1;
+
+	hash ^= hash >> 15;
+	hash *= Prime2;
+	hash ^= hash >> 13;
+	hash *= Prime3;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+std::optional<uint32_t> ReadMpqFileChecksum(const char *archivePath, const char *filename)
+{
+	const std::map<std::string, uint32_t> checksums = ReadChecksums(archivePath);
+	const auto checksum = checksums.find(filename);
+	if (checksum == checksums.end())
+		return std::nullopt;
+	return checksum->second;
+}
+
+void ReplayMpqJournal(const char *path)
+{
+	const std::string journalPath = std::string(path) + JournalSuffix;
+	std::uintmax_t size;
+	if (!GetFileSize(journalPath.c_str(), &size) || size == 0)
+		return;
+
+	if (size == JournalSize && FileExists(path)) {
+		std::unique_ptr<byte[]> journal { new byte[JournalSize] };
+		LoggedFStream stream;
+		bool valid = stream.Open(journalPath.c_str(), std::ios::in | std::ios::binary)
+		    && stream.Read(reinterpret_cast<char *>(journal.get()), JournalSize);
+		stream.Close();
+		// Anything else is a journal that was cut short itself, the archive was not touched yet
+		valid = valid && LoadLE32(&journal[0]) == LoadLE32("MPQJ")
+		    && LoadLE32(&journal[JournalHeaderSize + TablesSize]) == MpqFileChecksum(journal.get(), JournalHeaderSize + TablesSize);
+		if (valid) {
+			Log("Finishing the interrupted save of {}", path);
+			if (!ApplyTables(path, &journal[JournalHeaderSize], LoadLE32(&journal[sizeof(uint32_t)])))
+				return;
+		}
+	}
+	ResizeFile(journalPath.c_str(), 0);
+}
+
+void RemoveMpqSidecarFiles(const char *archivePath)
+{
+	RemoveFile((std::string(archivePath) + JournalSuffix).c_str());
+	RemoveFile((std::string(archivePath) + ChecksumSuffix).c_str());
+}
+
 bool MpqWriter::Open(const char *path)
 {
 	Close(/*clearTables=*/false);
 	LogDebug("Opening {}", path);
+	ReplayMpqJournal(path);
 	exists_ = FileExists(path);
 	std::ios::openmode mode = std::ios::in | std::ios::out | std::ios::binary;
 	if (exists_) {
@@ -97,6 +307,8 @@ bool MpqWriter::Open(const char *path)
 			uint32_t key = Hash("(block table)", 3);
 			Decrypt((DWORD *)blockTable_, BlockEntrySize, key);
 		}
+		LoadFreeBlocks();
+		checksums_ = fhdr.blockcount > 0 ? ReadChecksums(path) : std::map<std::string, uint32_t> {};
 		hashTable_ = new _HASHENTRY[HashEntrySize / sizeof(_HASHENTRY)];
 		std::memset(hashTable_, 255, HashEntrySize);
 		if (fhdr.hashcount > 0) {
@@ -132,24 +344,43 @@ bool MpqWriter::Close(bool clearTables)
 		return true;
 	LogDebug("Closing {}", name_);
 
-	bool result = true;
-	if (modified_ && !(stream_.Seekp(0, std::ios::beg) && WriteHeaderAndTables()))
-		result = false;
 	stream_.Close();
-	if (modified_ && result && size_ != 0) {
-		LogDebug("ResizeFile(\"{}\", {})", name_, size_);
-		result = ResizeFile(name_.c_str(), size_);
-	}
+	const bool result = !modified_ || Commit();
 	name_.clear();
 	if (clearTables) {
 		delete[] hashTable_;
 		hashTable_ = nullptr;
 		delete[] blockTable_;
 		blockTable_ = nullptr;
+		freeByOffset_.clear();
+		freeBySize_.clear();
+		checksums_.clear();
 	}
+	pendingRelease_.clear();
 	return result;
 }
 
+bool MpqWriter::Commit()
+{
+	// Nothing is written after this, so the space can be reused from the next Open on
+	for (const auto &space : pendingRelease_)
+		ReleaseSpace(space.first, space.second);
+	pendingRelease_.clear();
+
+	std::unique_ptr<byte[]> tables = BuildHeaderAndTables();
+	const uint32_t fileSize = static_cast<uint32_t>(size_);
+	const std::string journalPath = name_ + JournalSuffix;
+	// The files have to be on the disk before the tables that point to them
+	if (!SyncFile(name_.c_str()) || !WriteJournal(journalPath, tables.get(), fileSize))
+		return false;
+	LogDebug("Committing {} with size {}", name_, fileSize);
+	if (!ApplyTables(name_.c_str(), tables.get(), fileSize))
+		return false;
+	ResizeFile(journalPath.c_str(), 0);
+	WriteChecksums(name_, checksums_);
+	return true;
+}
+
 int MpqWriter::FetchHandle(const char *filename) const
 {
 	return GetHashIndex(Hash(filename, 0), Hash(filename, 1), Hash(filename, 2));
@@ -172,7 +403,8 @@ bool MpqWriter::IsValidMpqHeader(_FILEHEADER *hdr) const
 	    && hdr->headersize == 32
 	    && hdr->version <= 0
 	    && hdr->sectorsizeid == 3
-	    && hdr->filesize == size_
+	    && hdr->filesize >= TablesSize
+	    && hdr->filesize <= size_
 	    && hdr->hashoffset == MpqHashEntryOffset
 	    && hdr->blockoffset == sizeof(_FILEHEADER)
 	    && hdr->hashcount == INDEX_ENTRIES
@@ -189,6 +421,11 @@ bool MpqWriter::ReadMPQHeader(_FILEHEADER *hdr)
 	}
 	if (!hasHdr || !IsValidMpqHeader(hdr)) {
 		InitDefaultMpqHeader(hdr);
+	} else if (hdr->filesize < size_) {
+		// Files written after the last commit, the tables do not point to them
+		LogVerbose("Dropping {} uncommitted bytes from {}", size_ - hdr->filesize, name_);
+		size_ = hdr->filesize;
+		modified_ = true;
 	}
 	return true;
 }
@@ -213,78 +450,91 @@ _BLOCKENTRY *MpqWriter::NewBlock(int *blockIndex)
 		return blockEntry;
 	}
 
-	app_fatal("Out of free block entries");
+	LogError("Out of free block entries in {}", name_);
+	return nullptr;
 }
 
-void MpqWriter::AllocBlock(uint32_t blockOffset, uint32_t blockSize)
+void MpqWriter::InsertFreeBlock(uint32_t offset, uint32_t size)
 {
-	_BLOCKENTRY *block;
-	int i;
-
-	block = blockTable_;
-	i = INDEX_ENTRIES;
-	while (i-- != 0) {
-		if (block->offset != 0 && block->flags == 0 && block->sizefile == 0) {
-			if (block->offset + block->sizealloc == blockOffset) {
-				blockOffset = block->offset;
-				blockSize += block->sizealloc;
-				memset(block, 0, sizeof(_BLOCKENTRY));
-				AllocBlock(blockOffset, blockSize);
-				return;
-			}
-			if (blockOffset + blockSize == block->offset) {
-				blockSize += block->sizealloc;
-				memset(block, 0, sizeof(_BLOCKENTRY));
-				AllocBlock(blockOffset, blockSize);
-				return;
-			}
-		}
-		block++;
-	}
-	if (blockOffset + blockSize > size_) {
-		app_fatal("MPQ free list error");
-	}
-	if (blockOffset + blockSize == size_) {
-		size_ = blockOffset;
-	} else {
-		block = NewBlock(nullptr);
-		block->offset = blockOffset;
-		block->sizealloc = blockSize;
-		block->sizefile = 0;
-		block->flags = 0;
-	}
+	freeByOffset_.emplace(offset, size);
+	freeBySize_.emplace(size, offset);
 }
 
-int MpqWriter::FindFreeBlock(uint32_t size, uint32_t *blockSize)
+std::map<uint32_t, uint32_t>::iterator MpqWriter::EraseFreeBlock(std::map<uint32_t, uint32_t>::iterator block)
 {
-	int result;
+	freeBySize_.erase({ block->second, block->first });
+	return freeByOffset_.erase(block);
+}
 
-	_BLOCKENTRY *pBlockTbl = blockTable_;
-	for (int i = 0; i < INDEX_ENTRIES; i++, pBlockTbl++) {
-		if (pBlockTbl->offset == 0)
-			continue;
-		if (pBlockTbl->flags != 0)
-			continue;
-		if (pBlockTbl->sizefile != 0)
-			continue;
-		if (pBlockTbl->sizealloc < size)
+void MpqWriter::LoadFreeBlocks()
+{
+	freeByOffset_.clear();
+	freeBySize_.clear();
+	for (int i = 0; i < INDEX_ENTRIES; i++) {
+		_BLOCKENTRY &block = blockTable_[i];
+		if (block.offset == 0 || block.flags != 0 || block.sizefile != 0)
 			continue;
+		const uint32_t offset = block.offset;
+		const uint32_t size = block.sizealloc;
+		memset(&block, 0, sizeof(block));
+		// Entries pointing past the end of the file are left over from a damaged save
+		if (size != 0 && offset + size <= size_)
+			ReleaseSpace(offset, size);
+	}
+}
 
-		result = pBlockTbl->offset;
-		*blockSize = size;
-		pBlockTbl->offset += size;
-		pBlockTbl->sizealloc -= size;
+void MpqWriter::ReleaseSpace(uint32_t offset, uint32_t size)
+{
+	if (size == 0)
+		return;
+	if (offset + size > size_) {
+		// Losing the space is safe, handing it out again is not
+		LogError("MPQ free list error in {}", name_);
+		return;
+	}
 
-		if (pBlockTbl->sizealloc == 0)
-			memset(pBlockTbl, 0, sizeof(*pBlockTbl));
+	auto next = freeByOffset_.lower_bound(offset);
+	if (next != freeByOffset_.end() && next->first == offset + size) {
+		size += next->second;
+		next = EraseFreeBlock(next);
+	}
+	if (next != freeByOffset_.begin()) {
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset) {
+			offset = prev->first;
+			size += prev->second;
+			EraseFreeBlock(prev);
+		}
+	}
 
-		return result;
+	// Free space never borders the end of the file, the file shrinks instead
+	if (offset + size == size_) {
+		size_ = offset;
+		return;
 	}
+	InsertFreeBlock(offset, size);
+}
 
+uint32_t MpqWriter::FindFreeBlock(uint32_t size, uint32_t *blockSize)
+{
 	*blockSize = size;
-	result = size_;
-	size_ += size;
-	return result;
+
+	// Best fit: the smallest free block that is large enough, the lowest one of those
+	auto best = freeBySize_.lower_bound({ size, 0 });
+	if (best == freeBySize_.end()) {
+		const uint32_t offset = size_;
+		size_ += size;
+		return offset;
+	}
+
+	const uint32_t offset = best->second;
+	const uint32_t available = best->first;
+	freeBySize_.erase(best);
+	freeByOffset_.erase(offset);
+	// The rest cannot border other free space, or it would have been merged with it
+	if (available > size)
+		InsertFreeBlock(offset + size, available - size);
+	return offset;
 }
 
 int MpqWriter::GetHashIndex(int index, uint32_t hashA, uint32_t hashB) const
@@ -308,7 +558,7 @@ int MpqWriter::GetHashIndex(int index, uint32_t hashA, uint32_t hashB) const
 
 bool MpqWriter::WriteHeaderAndTables()
 {
-	return WriteHeader() && WriteBlockTable() && WriteHashTable();
+	return stream_.Write(reinterpret_cast<const char *>(BuildHeaderAndTables().get()), TablesSize);
 }
 
 _BLOCKENTRY *MpqWriter::AddFile(const char *pszName, _BLOCKENTRY *pBlk, int blockIndex)
@@ -316,8 +566,10 @@ _BLOCKENTRY *MpqWriter::AddFile(const char *pszName, _BLOCKENTRY *pBlk, int bloc
 	uint32_t h1 = Hash(pszName, 0);
 	uint32_t h2 = Hash(pszName, 1);
 	uint32_t h3 = Hash(pszName, 2);
-	if (GetHashIndex(h1, h2, h3) != -1)
-		app_fatal("Hash collision between \"%s\" and existing file\n", pszName);
+	if (GetHashIndex(h1, h2, h3) != -1) {
+		LogError("Hash collision between \"{}\" and existing file", pszName);
+		return nullptr;
+	}
 	unsigned int hIdx = h1 & 0x7FF;
 
 	bool hasSpace = false;
@@ -328,11 +580,15 @@ _BLOCKENTRY *MpqWriter::AddFile(const char *pszName, _BLOCKENTRY *pBlk, int bloc
 		}
 		hIdx = (hIdx + 1) & 0x7FF;
 	}
-	if (!hasSpace)
-		app_fatal("Out of hash space");
+	if (!hasSpace) {
+		LogError("Out of hash space in {}", name_);
+		return nullptr;
+	}
 
 	if (pBlk == nullptr)
 		pBlk = NewBlock(&blockIndex);
+	if (pBlk == nullptr)
+		return nullptr;
 
 	hashTable_[hIdx].hashcheck[0] = h2;
 	hashTable_[hIdx].hashcheck[1] = h3;
@@ -342,7 +598,7 @@ _BLOCKENTRY *MpqWriter::AddFile(const char *pszName, _BLOCKENTRY *pBlk, int bloc
 	return pBlk;
 }
 
-bool MpqWriter::WriteFileContents(const char *pszName, const byte *pbData, size_t dwLen, _BLOCKENTRY *pBlk)
+bool MpqWriter::WriteFileContents(const char *pszName, const byte *pbData, size_t dwLen, _BLOCKENTRY *pBlk, CompressionCodec codec)
 {
 	const char *tmp;
 	while ((tmp = strchr(pszName, ':')) != nullptr)
@@ -351,20 +607,16 @@ bool MpqWriter::WriteFileContents(const char *pszName, const byte *pbData, size_
 		pszName = tmp + 1;
 	Hash(pszName, 3);
 
-	constexpr size_t SectorSize = 4096;
+	// Uncompressed files are stored without a sector offset table
+	const bool compressed = codec != CompressionCodec::None;
 	const uint32_t numSectors = (dwLen + (SectorSize - 1)) / SectorSize;
-	const uint32_t offsetTableByteSize = sizeof(uint32_t) * (numSectors + 1);
+	const uint32_t offsetTableByteSize = compressed ? sizeof(uint32_t) * (numSectors + 1) : 0;
 	pBlk->offset = FindFreeBlock(dwLen + offsetTableByteSize, &pBlk->sizealloc);
 	pBlk->sizefile = dwLen;
-	pBlk->flags = 0x80000100;
-
-	// We populate the table of sector offset while we write the data.
-	// We can't pre-populate it because we don't know the compressed sector sizes yet.
-	// First offset is the start of the first sector, last offset is the end of the last sector.
-	std::unique_ptr<uint32_t[]> sectoroffsettable { new uint32_t[numSectors + 1] };
+	pBlk->flags = compressed ? 0x80000100 : 0x80000000;
 
 #ifdef CAN_SEEKP_BEYOND_EOF
-	if (!stream_.Seekp(pBlk->offset + offsetTableByteSize, std::ios::beg))
+	if (!stream_.Seekp(pBlk->offset, std::ios::beg))
 		return false;
 #else
 	// Ensure we do not Seekp beyond EOF by filling the missing space.
@@ -372,60 +624,66 @@ bool MpqWriter::WriteFileContents(const char *pszName, const byte *pbData, size_
 	if (!stream_.Seekp(0, std::ios::end) || !stream_.Tellp(&stream_end))
 		return false;
 	const std::uintmax_t cur_size = stream_end - stream_begin;
-	if (cur_size < pBlk->offset + offsetTableByteSize) {
-		if (cur_size < pBlk->offset) {
-			std::unique_ptr<char[]> filler { new char[pBlk->offset - cur_size] };
-			if (!stream_.Write(filler.get(), pBlk->offset - cur_size))
-				return false;
-		}
-		if (!stream_.Write(reinterpret_cast<const char *>(sectoroffsettable.get()), offsetTableByteSize))
+	if (cur_size < pBlk->offset) {
+		std::unique_ptr<char[]> filler { new char[pBlk->offset - cur_size] };
+		if (!stream_.Write(filler.get(), pBlk->offset - cur_size))
 			return false;
 	} else {
-		if (!stream_.Seekp(pBlk->offset + offsetTableByteSize, std::ios::beg))
+		if (!stream_.Seekp(pBlk->offset, std::ios::beg))
 			return false;
 	}
 #endif
 
-	uint32_t destsize = offsetTableByteSize;
-	byte mpqBuf[SectorSize];
-	std::size_t curSector = 0;
-	while (true) {
-		uint32_t len = std::min(dwLen, SectorSize);
-		memcpy(mpqBuf, pbData, len);
-		pbData += len;
-		len = PkwareCompress(mpqBuf, len);
-		if (!stream_.Write(reinterpret_cast<const char *>(&mpqBuf[0]), len))
+	if (!compressed) {
+		if (!stream_.Write(reinterpret_cast<const char *>(pbData), dwLen))
 			return false;
-		sectoroffsettable[curSector++] = SDL_SwapLE32(destsize);
-		destsize += len; // compressed length
-		if (dwLen <= SectorSize)
-			break;
+		ShrinkBlock(pBlk, dwLen);
+		return true;
+	}
 
-		dwLen -= SectorSize;
+	// Every sector is compressed in its own slot behind the offset table. The slots are then
+	// packed down, so the table and the data go out in a single write.
+	std::unique_ptr<byte[]> buffer { new byte[offsetTableByteSize + numSectors * SectorSize] };
+	std::unique_ptr<uint32_t[]> sectorSizes { new uint32_t[numSectors] };
+	byte *sectors = &buffer[offsetTableByteSize];
+	memcpy(sectors, pbData, dwLen);
+	SectorCompression job { codec, sectors, sectorSizes.get(), dwLen, numSectors, { 0 } };
+	RunOnThreads(CompressSectorsThread, &job, std::min(MaxCompressionThreads, static_cast<int>(numSectors)));
+
+	// First offset is the start of the first sector, last offset is the end of the last sector.
+	uint32_t destsize = offsetTableByteSize;
+	for (uint32_t i = 0; i < numSectors; i++) {
+		const uint32_t offset = SDL_SwapLE32(destsize);
+		memcpy(&buffer[i * sizeof(uint32_t)], &offset, sizeof(offset));
+		memmove(&buffer[destsize], &sectors[i * SectorSize], sectorSizes[i]);
+		destsize += sectorSizes[i];
 	}
+	const uint32_t end = SDL_SwapLE32(destsize);
+	memcpy(&buffer[numSectors * sizeof(uint32_t)], &end, sizeof(end));
 
-	sectoroffsettable[numSectors] = SDL_SwapLE32(destsize);
-	if (!stream_.Seekp(pBlk->offset, std::ios::beg))
-		return false;
-	if (!stream_.Write(reinterpret_cast<const char *>(sectoroffsettable.get()), offsetTableByteSize))
-		return false;
-	if (!stream_.Seekp(destsize - offsetTableByteSize, std::ios::cur))
+	if (!stream_.Write(reinterpret_cast<const char *>(buffer.get()), destsize))
 		return false;
 
-	if (destsize < pBlk->sizealloc) {
-		const uint32_t blockSize = pBlk->sizealloc - destsize;
+	ShrinkBlock(pBlk, destsize);
+	return true;
+}
+
+void MpqWriter::ShrinkBlock(_BLOCKENTRY *pBlk, uint32_t size)
+{
+	if (size < pBlk->sizealloc) {
+		const uint32_t blockSize = pBlk->sizealloc - size;
 		if (blockSize >= 1024) {
-			pBlk->sizealloc = destsize;
-			AllocBlock(pBlk->sizealloc + pBlk->offset, blockSize);
+			pBlk->sizealloc = size;
+			ReleaseSpace(pBlk->sizealloc + pBlk->offset, blockSize);
 		}
 	}
-	return true;
 }
 
-bool MpqWriter::WriteHeader()
+std::unique_ptr<byte[]> MpqWriter::BuildHeaderAndTables()
 {
-	_FILEHEADER fhdr;
+	std::unique_ptr<byte[]> tables { new byte[TablesSize] };
 
+	_FILEHEADER fhdr;
 	memset(&fhdr, 0, sizeof(fhdr));
 	fhdr.signature = SDL_SwapLE32(LoadLE32("MPQ\x1A"));
 	fhdr.headersize = SDL_SwapLE32(32);
@@ -436,24 +694,27 @@ bool MpqWriter::WriteHeader()
 	fhdr.blockoffset = SDL_SwapLE32(static_cast<uint32_t>(MpqBlockEntryOffset));
 	fhdr.hashcount = SDL_SwapLE32(INDEX_ENTRIES);
 	fhdr.blockcount = SDL_SwapLE32(INDEX_ENTRIES);
+	memcpy(tables.get(), &fhdr, sizeof(fhdr));
+
+	// On disk, free space is kept as block entries without a file
+	auto *blockTable = reinterpret_cast<_BLOCKENTRY *>(&tables[MpqBlockEntryOffset]);
+	memcpy(blockTable, blockTable_, BlockEntrySize);
+	auto freeBlock = freeByOffset_.begin();
+	for (int i = 0; i < INDEX_ENTRIES && freeBlock != freeByOffset_.end(); i++) {
+		_BLOCKENTRY &block = blockTable[i];
+		if (block.offset != 0 || block.sizealloc != 0 || block.flags != 0 || block.sizefile != 0)
+			continue;
+		block.offset = freeBlock->first;
+		block.sizealloc = freeBlock->second;
+		++freeBlock;
+	}
+	// Should the table ever fill up, the remaining free space is only lost, not corrupted
+	Encrypt((DWORD *)blockTable, BlockEntrySize, Hash("(block table)", 3));
 
-	return stream_.Write(reinterpret_cast<const char *>(&fhdr), sizeof(fhdr));
-}
-
-bool MpqWriter::WriteBlockTable()
-{
-	Encrypt((DWORD *)blockTable_, BlockEntrySize, Hash("(block table)", 3));
-	const bool success = stream_.Write(reinterpret_cast<const char *>(blockTable_), BlockEntrySize);
-	Decrypt((DWORD *)blockTable_, BlockEntrySize, Hash("(block table)", 3));
-	return success;
-}
-
-bool MpqWriter::WriteHashTable()
-{
-	Encrypt((DWORD *)hashTable_, HashEntrySize, Hash("(hash table)", 3));
-	const bool success = stream_.Write(reinterpret_cast<const char *>(hashTable_), HashEntrySize);
-	Decrypt((DWORD *)hashTable_, HashEntrySize, Hash("(hash table)", 3));
-	return success;
+	auto *hashTable = reinterpret_cast<_HASHENTRY *>(&tables[MpqHashEntryOffset]);
+	memcpy(hashTable, hashTable_, HashEntrySize);
+	Encrypt((DWORD *)hashTable, HashEntrySize, Hash("(hash table)", 3));
+	return tables;
 }
 
 void MpqWriter::RemoveHashEntry(const char *filename)
@@ -466,10 +727,10 @@ void MpqWriter::RemoveHashEntry(const char *filename)
 	_HASHENTRY *pHashTbl = &hashTable_[hIdx];
 	_BLOCKENTRY *blockEntry = &blockTable_[pHashTbl->block];
 	pHashTbl->block = -2;
-	int blockOffset = blockEntry->offset;
-	int blockSize = blockEntry->sizealloc;
+	if (blockEntry->sizealloc != 0)
+		pendingRelease_.emplace_back(blockEntry->offset, blockEntry->sizealloc);
 	memset(blockEntry, 0, sizeof(*blockEntry));
-	AllocBlock(blockOffset, blockSize);
+	checksums_.erase(filename);
 	modified_ = true;
 }
 
@@ -482,33 +743,46 @@ void MpqWriter::RemoveHashEntries(bool (*fnGetName)(uint8_t, char *))
 	}
 }
 
-bool MpqWriter::WriteFile(const char *filename, const byte *data, size_t size)
+bool MpqWriter::WriteFile(const char *filename, const byte *data, size_t size, CompressionCodec codec)
 {
 	_BLOCKENTRY *blockEntry;
 
 	modified_ = true;
 	RemoveHashEntry(filename);
 	blockEntry = AddFile(filename, nullptr, 0);
-	if (!WriteFileContents(filename, data, size, blockEntry)) {
+	if (blockEntry == nullptr)
+		return false;
+	assert(codec == CompressionCodec::None || codec == CompressionCodec::Pkware);
+	if (!WriteFileContents(filename, data, size, blockEntry, codec)) {
 		RemoveHashEntry(filename);
 		return false;
 	}
+	checksums_[filename] = MpqFileChecksum(data, size);
 	return true;
 }
 
-void MpqWriter::RenameFile(const char *name, const char *newName)
+bool MpqWriter::RenameFile(const char *name, const char *newName)
 {
 	int index = FetchHandle(name);
 	if (index == -1) {
-		return;
+		return true;
 	}
 
 	_HASHENTRY *hashEntry = &hashTable_[index];
 	int block = hashEntry->block;
 	_BLOCKENTRY *blockEntry = &blockTable_[block];
 	hashEntry->block = -2;
-	AddFile(newName, blockEntry, block);
+	if (AddFile(newName, blockEntry, block) == nullptr) {
+		hashEntry->block = block;
+		return false;
+	}
+	auto checksum = checksums_.find(name);
+	if (checksum != checksums_.end()) {
+		checksums_[newName] = checksum->second;
+		checksums_.erase(checksum);
+	}
 	modified_ = true;
+	return true;
 }
 
 bool MpqWriter::HasFile(const char *name) const
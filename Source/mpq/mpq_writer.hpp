@@ -6,9 +6,17 @@
 #pragma once
 
 #include <cstdint>
-
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils/compression.hpp"
 #include "utils/logged_fstream.hpp"
 #include "utils/stdcompat/cstddef.hpp"
+#include "utils/stdcompat/optional.hpp"
 
 namespace devilution {
 
@@ -38,6 +46,36 @@ struct _BLOCKENTRY {
 	uint32_t flags;
 };
 
+/** @brief Fast checksum (xxHash32) the writer records for the contents of each file it writes. */
+uint32_t MpqFileChecksum(const byte *data, size_t size);
+
+/**
+ * @brief Looks up the checksum recorded for a file when it was last written to the archive at archivePath.
+ *
+ * Compare it with MpqFileChecksum of the contents read back, to see if they are intact.
+ * @return nullopt if there is none, e.g. if the archive was written by an older version
+ */
+std::optional<uint32_t> ReadMpqFileChecksum(const char *archivePath, const char *filename);
+
+/**
+ * @brief Finishes a commit to the archive at path that was cut short after its journal was complete.
+ *
+ * MpqWriter::Open does this itself, anything else that reads an archive the writer may have been
+ * interrupted on must call it first. The journal is emptied rather than removed, so the next commit
+ * does not depend on a new directory entry.
+ */
+void ReplayMpqJournal(const char *path);
+
+/**
+ * @brief Removes the files the writer keeps next to an archive.
+ */
+void RemoveMpqSidecarFiles(const char *archivePath);
+
+/**
+ * Changes are committed atomically on Close: files only ever go to space the tables on disk
+ * do not use, and the new tables are written to a journal before they overwrite the old ones.
+ * A commit that was cut short is finished by the next Open.
+ */
 class MpqWriter {
 public:
 	bool Open(const char *path);
@@ -53,8 +91,14 @@ public:
 
 	void RemoveHashEntry(const char *filename);
 	void RemoveHashEntries(bool (*fnGetName)(uint8_t, char *));
-	bool WriteFile(const char *filename, const byte *data, size_t size);
-	void RenameFile(const char *name, const char *newName);
+	/**
+	 * @brief Adds or replaces a file.
+	 * @param codec CompressionCodec::Pkware, or CompressionCodec::None for data that does not compress.
+	 * Other codecs cannot be read back by MPQ readers.
+	 */
+	bool WriteFile(const char *filename, const byte *data, size_t size, CompressionCodec codec = CompressionCodec::Pkware);
+	/** @return false when newName cannot be added, the file then keeps its old name */
+	bool RenameFile(const char *name, const char *newName);
 
 private:
 	bool IsValidMpqHeader(_FILEHEADER *hdr) const;
@@ -62,15 +106,26 @@ private:
 	int FetchHandle(const char *filename) const;
 
 	bool ReadMPQHeader(_FILEHEADER *hdr);
+	/** @return nullptr when the name is taken or the tables are full, nothing is changed then */
 	_BLOCKENTRY *AddFile(const char *pszName, _BLOCKENTRY *pBlk, int blockIndex);
-	bool WriteFileContents(const char *pszName, const byte *pbData, size_t dwLen, _BLOCKENTRY *pBlk);
+	bool WriteFileContents(const char *pszName, const byte *pbData, size_t dwLen, _BLOCKENTRY *pBlk, CompressionCodec codec);
+	/** @brief Returns the unused end of a block to the free list. */
+	void ShrinkBlock(_BLOCKENTRY *pBlk, uint32_t size);
+	/** @return nullptr when the block table is full */
 	_BLOCKENTRY *NewBlock(int *blockIndex);
-	void AllocBlock(uint32_t blockOffset, uint32_t blockSize);
-	int FindFreeBlock(uint32_t size, uint32_t *blockSize);
+	/** @brief Moves the free space entries of a freshly read block table to the free list. */
+	void LoadFreeBlocks();
+	/** @brief Adds space to the free list, merging it with its neighbours, or shrinks the file if it is at the end. */
+	void ReleaseSpace(uint32_t offset, uint32_t size);
+	/** @brief Takes size bytes from the best fitting free block, or from the end of the file. */
+	uint32_t FindFreeBlock(uint32_t size, uint32_t *blockSize);
+	void InsertFreeBlock(uint32_t offset, uint32_t size);
+	std::map<uint32_t, uint32_t>::iterator EraseFreeBlock(std::map<uint32_t, uint32_t>::iterator block);
+	/** @brief The header, block table and hash table, encrypted, as they go at the start of the file. */
+	std::unique_ptr<byte[]> BuildHeaderAndTables();
 	bool WriteHeaderAndTables();
-	bool WriteHeader();
-	bool WriteBlockTable();
-	bool WriteHashTable();
+	/** @brief Makes the changes since Open durable, see the class comment. */
+	bool Commit();
 	void InitDefaultMpqHeader(_FILEHEADER *hdr);
 
 	LoggedFStream stream_;
@@ -78,8 +133,15 @@ private:
 	std::uintmax_t size_;
 	bool modified_;
 	bool exists_;
-	_HASHENTRY *hashTable_;
-	_BLOCKENTRY *blockTable_;
+	_HASHENTRY *hashTable_ = nullptr;
+	_BLOCKENTRY *blockTable_ = nullptr;
+	/** Free space between files, by offset to merge neighbours, and as (size, offset) for best fit */
+	std::map<uint32_t, uint32_t> freeByOffset_;
+	std::set<std::pair<uint32_t, uint32_t>> freeBySize_;
+	/** Space of files removed since Open, the tables on disk point to it until the next commit */
+	std::vector<std::pair<uint32_t, uint32_t>> pendingRelease_;
+	/** Checksums of the file contents by name, kept next to the archive */
+	std::map<std::string, uint32_t> checksums_;
 
 // Amiga cannot Seekp beyond EOF.
 // See https://github.com/bebbo/libnix/issues/30
@@ -3,8 +3,11 @@
  *
  * Implementation of function for sending and reciving network messages.
  */
+#include <array>
+#include <bitset>
 #include <climits>
 #include <memory>
+#include <vector>
 
 #include <fmt/format.h>
 #include <list>
@@ -32,6 +35,7 @@
 #include "town.h"
 #include "towners.h"
 #include "trigs.h"
+#include "utils/compression.hpp"
 #include "utils/language.h"
 
 namespace devilution {
@@ -64,9 +68,19 @@ _cmd_id sgbRecvCmd;
 LocalLevel sgLocals[NUMLEVELS];
 DJunk sgJunk;
 bool sgbDeltaChanged;
+/** Levels changed since their delta was last compressed by DeltaExportData. */
+std::bitset<NUMLEVELS> sgLevelDeltaDirty;
+/** Compressed CMD_DLEVEL_* payload of each level, reused for every joining player until the level changes. */
+std::array<std::vector<byte>, NUMLEVELS> sgLevelDeltaCache;
 BYTE sgbDeltaChunks;
 std::list<TMegaPkt> MegaPktList;
 
+void DeltaLevelChanged(uint8_t level)
+{
+	sgbDeltaChanged = true;
+	sgLevelDeltaDirty.set(level);
+}
+
 void GetNextPacket()
 {
 	MegaPktList.emplace_back();
@@ -299,20 +313,27 @@ void DeltaImportJunk(const byte *src)
 	}
 }
 
+/**
+ * Codec for level data sent to joining players. Joining requires the exact same version,
+ * so every peer can decode it; the first byte of each chunk records the codec used.
+ */
+constexpr CompressionCodec DeltaCodec = CompressionCodec::Lz;
+
 DWORD CompressData(byte *buffer, byte *end)
 {
 	DWORD size = end - buffer - 1;
-	DWORD pkSize = PkwareCompress(buffer + 1, size);
+	DWORD compressedSize = CompressInPlace(DeltaCodec, buffer + 1, size);
 
-	*buffer = size != pkSize ? byte { 1 } : byte { 0 };
+	*buffer = static_cast<byte>(size != compressedSize ? DeltaCodec : CompressionCodec::None);
 
-	return pkSize + 1;
+	return compressedSize + 1;
 }
 
 void DeltaImportData(_cmd_id cmd, DWORD recvOffset)
 {
-	if (sgRecvBuf[0] != byte { 0 })
-		PkwareDecompress(&sgRecvBuf[1], recvOffset, sizeof(sgRecvBuf) - 1);
+	const auto codec = static_cast<CompressionCodec>(sgRecvBuf[0]);
+	if (recvOffset == 0 || !DecompressInPlace(codec, &sgRecvBuf[1], recvOffset - 1, sizeof(sgRecvBuf) - 1))
+		app_fatal("Invalid level data");
 
 	byte *src = &sgRecvBuf[1];
 	if (cmd == CMD_DLEVEL_JUNK) {
@@ -322,6 +343,7 @@ void DeltaImportData(_cmd_id cmd, DWORD recvOffset)
 		src += DeltaImportItem(src, sgLevels[i].item);
 		src += DeltaImportObject(src, sgLevels[i].object);
 		DeltaImportMonster(src, sgLevels[i].monster);
+		sgLevelDeltaDirty.set(i);
 	} else {
 		app_fatal("Unkown network message type: %i", cmd);
 	}
@@ -376,7 +398,7 @@ void DeltaSyncGolem(const TCmdGolem &message, int pnum, uint8_t level)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	DeltaLevelChanged(level);
 	DMonsterStr &monster = sgLevels[level].monster[pnum];
 	monster._mx = message._mx;
 	monster._my = message._my;
@@ -400,7 +422,7 @@ void DeltaLeaveSync(BYTE bLevel)
 		auto &monster = Monsters[ma];
 		if (monster._mhitpoints == 0)
 			continue;
-		sgbDeltaChanged = true;
+		DeltaLevelChanged(bLevel);
 		DMonsterStr &delta = sgLevels[bLevel].monster[ma];
 		delta._mx = monster.position.tile.x;
 		delta._my = monster.position.tile.y;
@@ -418,7 +440,7 @@ void DeltaSyncObject(int oi, _cmd_id bCmd, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	DeltaLevelChanged(bLevel);
 	sgLevels[bLevel].object[oi].bCmd = bCmd;
 }
 
@@ -435,12 +457,12 @@ bool DeltaGetItem(const TCmdGItem &message, BYTE bLevel)
 			return true;
 		}
 		if (item.bCmd == CMD_STAND) {
-			sgbDeltaChanged = true;
+			DeltaLevelChanged(bLevel);
 			item.bCmd = CMD_WALKXY;
 			return true;
 		}
 		if (item.bCmd == CMD_ACK_PLRINFO) {
-			sgbDeltaChanged = true;
+			DeltaLevelChanged(bLevel);
 			item.bCmd = CMD_INVALID;
 			return true;
 		}
@@ -453,7 +475,7 @@ bool DeltaGetItem(const TCmdGItem &message, BYTE bLevel)
 
 	for (TCmdPItem &item : sgLevels[bLevel].item) {
 		if (item.bCmd == CMD_INVALID) {
-			sgbDeltaChanged = true;
+			DeltaLevelChanged(bLevel);
 			item.bCmd = CMD_WALKXY;
 			item.x = message.x;
 			item.y = message.y;
@@ -498,7 +520,7 @@ void DeltaPutItem(const TCmdPItem &message, Point position, BYTE bLevel)
 
 	for (TCmdPItem &item : sgLevels[bLevel].item) {
 		if (item.bCmd == CMD_INVALID) {
-			sgbDeltaChanged = true;
+			DeltaLevelChanged(bLevel);
 			memcpy(&item, &message, sizeof(TCmdPItem));
 			item.bCmd = CMD_ACK_PLRINFO;
 			item.x = position.x;
@@ -2009,30 +2031,41 @@ void run_delta_info()
 void DeltaExportData(int pnum)
 {
 	if (sgbDeltaChanged) {
+		std::unique_ptr<byte[]> buffer;
 		for (int i = 0; i < NUMLEVELS; i++) {
-			std::unique_ptr<byte[]> dst { new byte[sizeof(DLevel) + 1] };
-			byte *dstEnd = &dst.get()[1];
-			dstEnd = DeltaExportItem(dstEnd, sgLevels[i].item);
-			dstEnd = DeltaExportObject(dstEnd, sgLevels[i].object);
-			dstEnd = DeltaExportMonster(dstEnd, sgLevels[i].monster);
-			int size = CompressData(dst.get(), dstEnd);
-			dthread_send_delta(pnum, static_cast<_cmd_id>(i + CMD_DLEVEL_0), std::move(dst), size);
+			std::vector<byte> &cached = sgLevelDeltaCache[i];
+			if (sgLevelDeltaDirty.test(i)) {
+				if (buffer == nullptr)
+					buffer.reset(new byte[sizeof(DLevel) + 1]);
+				byte *dstEnd = &buffer.get()[1];
+				dstEnd = DeltaExportItem(dstEnd, sgLevels[i].item);
+				dstEnd = DeltaExportObject(dstEnd, sgLevels[i].object);
+				dstEnd = DeltaExportMonster(dstEnd, sgLevels[i].monster);
+				int size = CompressData(buffer.get(), dstEnd);
+				cached.assign(buffer.get(), buffer.get() + size);
+				sgLevelDeltaDirty.reset(i);
+			}
+			dthread_send_delta(pnum, static_cast<_cmd_id>(i + CMD_DLEVEL_0), cached.data(), cached.size());
 		}
 
-		std::unique_ptr<byte[]> dst { new byte[sizeof(DJunk) + 1] };
-		byte *dstEnd = &dst.get()[1];
+		// Quest state is read straight from the game, so the small junk chunk is always rebuilt
+		byte dst[sizeof(DJunk) + 1];
+		byte *dstEnd = &dst[1];
 		dstEnd = DeltaExportJunk(dstEnd);
-		int size = CompressData(dst.get(), dstEnd);
-		dthread_send_delta(pnum, CMD_DLEVEL_JUNK, std::move(dst), size);
+		int size = CompressData(dst, dstEnd);
+		dthread_send_delta(pnum, CMD_DLEVEL_JUNK, dst, size);
 	}
 
-	std::unique_ptr<byte[]> src { new byte[1] { static_cast<byte>(0) } };
-	dthread_send_delta(pnum, CMD_DLEVEL_END, std::move(src), 1);
+	byte src[1] = { static_cast<byte>(0) };
+	dthread_send_delta(pnum, CMD_DLEVEL_END, src, 1);
 }
 
 void delta_init()
 {
 	sgbDeltaChanged = false;
+	sgLevelDeltaDirty.set();
+	for (std::vector<byte> &cached : sgLevelDeltaCache)
+		cached.clear();
 	memset(&sgJunk, 0xFF, sizeof(sgJunk));
 	memset(sgLevels, 0xFF, sizeof(sgLevels));
 	memset(sgLocals, 0, sizeof(sgLocals));
@@ -2044,7 +2077,7 @@ void delta_kill_monster(int mi, Point position, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	DeltaLevelChanged(bLevel);
 	DMonsterStr *pD = &sgLevels[bLevel].monster[mi];
 	pD->_mx = position.x;
 	pD->_my = position.y;
@@ -2057,7 +2090,7 @@ void delta_monster_hp(int mi, int hp, BYTE bLevel)
 	if (!gbIsMultiplayer)
 		return;
 
-	sgbDeltaChanged = true;
+	DeltaLevelChanged(bLevel);
 	DMonsterStr *pD = &sgLevels[bLevel].monster[mi];
 	if (pD->_mhitpoints > hp)
 		pD->_mhitpoints = hp;
@@ -2069,7 +2102,7 @@ void delta_sync_monster(const TSyncMonster &monsterSync, uint8_t level)
 		return;
 
 	assert(level < NUMLEVELS);
-	sgbDeltaChanged = true;
+	DeltaLevelChanged(level);
 
 	DMonsterStr &monster = sgLevels[level].monster[monsterSync._mndx];
 	if (monster._mhitpoints == 0)
@@ -2112,7 +2145,7 @@ void DeltaAddItem(int ii)
 		if (item.bCmd != CMD_INVALID)
 			continue;
 
-		sgbDeltaChanged = true;
+		DeltaLevelChanged(currlevel);
 		item.bCmd = CMD_STAND;
 		item.x = Items[ii].position.x;
 		item.y = Items[ii].position.y;
@@ -15,6 +15,7 @@
 #include "engine/point.hpp"
 #include "engine/random.hpp"
 #include "menu.h"
+#include "netstats.h"
 #include "nthread.h"
 #include "options.h"
 #include "pfile.h"
@@ -299,6 +300,9 @@ void HandleAllPackets(int pnum, const byte *data, size_t size)
 		if (messageSize == 0) {
 			break;
 		}
+		// Timed messages are handed back to the local player, only count what came in over the network
+		if (pnum != MyPlayerId)
+			netstats::CountCommand(netstats::Direction::Received, static_cast<uint8_t>(data[offset]), messageSize);
 		offset += messageSize;
 	}
 }
@@ -317,11 +321,10 @@ void ProcessTmsgs()
 
 void SendPlayerInfo(int pnum, _cmd_id cmd)
 {
-	static_assert(alignof(PlayerPack) == 1, "Fix pkplr alignment");
-	std::unique_ptr<byte[]> pkplr { new byte[sizeof(PlayerPack)] };
+	PlayerPack pkplr;
 
-	PackPlayer(reinterpret_cast<PlayerPack *>(pkplr.get()), Players[MyPlayerId], true);
-	dthread_send_delta(pnum, cmd, std::move(pkplr), sizeof(PlayerPack));
+	PackPlayer(&pkplr, Players[MyPlayerId], true);
+	dthread_send_delta(pnum, cmd, reinterpret_cast<const byte *>(&pkplr), sizeof(PlayerPack));
 }
 
 dungeon_type InitLevelType(int l)
@@ -467,6 +470,7 @@ bool InitMulti(GameData *gameData)
 void NetSendLoPri(int playerId, const byte *data, size_t size)
 {
 	if (data != nullptr && size != 0) {
+		netstats::CountCommand(netstats::Direction::Sent, static_cast<uint8_t>(data[0]), size);
 		CopyPacket(&sgLoPriBuf, data, size);
 		SendPacket(playerId, data, size);
 	}
@@ -475,6 +479,7 @@ void NetSendLoPri(int playerId, const byte *data, size_t size)
 void NetSendHiPri(int playerId, const byte *data, size_t size)
 {
 	if (data != nullptr && size != 0) {
+		netstats::CountCommand(netstats::Direction::Sent, static_cast<uint8_t>(data[0]), size);
 		CopyPacket(&sgHiPriBuf, data, size);
 		SendPacket(playerId, data, size);
 	}
@@ -485,7 +490,10 @@ void NetSendHiPri(int playerId, const byte *data, size_t size)
 		size_t msgSize = gdwNormalMsgSize - sizeof(TPktHdr);
 		byte *hipriBody = ReceivePacket(&sgHiPriBuf, pkt.body, &msgSize);
 		byte *lowpriBody = ReceivePacket(&sgLoPriBuf, hipriBody, &msgSize);
-		msgSize = sync_all_monsters(lowpriBody, msgSize);
+		size_t syncSize = sync_all_monsters(lowpriBody, msgSize);
+		if (syncSize != msgSize)
+			netstats::CountCommand(netstats::Direction::Sent, CMD_SYNCDATA, msgSize - syncSize);
+		msgSize = syncSize;
 		size_t len = gdwNormalMsgSize - msgSize;
 		pkt.hdr.wLen = len;
 		if (!SNetSendMessage(SNPLAYER_OTHERS, &pkt.hdr, len))
@@ -500,6 +508,7 @@ void multi_send_msg_packet(uint32_t pmask, const byte *data, size_t size)
 	size_t t = size + sizeof(pkt.hdr);
 	pkt.hdr.wLen = t;
 	memcpy(pkt.body, data, size);
+	netstats::CountCommand(netstats::Direction::Sent, static_cast<uint8_t>(data[0]), size);
 	size_t p = 0;
 	for (size_t v = 1; p < MAX_PLRS; p++, v <<= 1) {
 		if ((v & pmask) != 0) {
@@ -636,6 +645,7 @@ void multi_send_zero_packet(int pnum, _cmd_id bCmd, const byte *data, size_t siz
 	assert(data != nullptr);
 	assert(size <= 0x0ffff);
 
+	netstats::CountCommand(netstats::Direction::Sent, bCmd, size);
 	for (size_t offset = 0; offset < size;) {
 		TPkt pkt {};
 		pkt.hdr.wCheck = LoadBE32("\0\0ip");
@@ -662,6 +672,7 @@ void multi_send_zero_packet(int pnum, _cmd_id bCmd, const byte *data, size_t siz
 
 		offset += message.wBytes;
 	}
+	DvlNet_Flush();
 }
 
 void NetClose()
@@ -0,0 +1,261 @@
+/**
+ * @file netstats.cpp
+ *
+ * Implementation of the network traffic counters and packet capture.
+ *
+ * A capture file starts with the magic "DNC1", followed by records of:
+ *
+ *     uint32_t time     little-endian milliseconds since the capture started
+ *     uint8_t  type     CaptureRecordType
+ *     int8_t   player
+ *     uint32_t size     little-endian
+ *     data
+ */
+#include "netstats.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+#include <SDL.h>
+#include <fmt/format.h>
+
+#include "utils/endian.hpp"
+#include "utils/log.hpp"
+#include "utils/sdl_mutex.h"
+
+namespace devilution {
+
+namespace netstats {
+
+namespace {
+
+constexpr char CaptureMagic[4] = { 'D', 'N', 'C', '1' };
+constexpr size_t CaptureRecordHeaderSize = 10;
+/** Larger than any storm message, anything bigger means the file is corrupt */
+constexpr uint32_t MaxCaptureRecordSize = 0x10000;
+
+/** Updated from the game, network and delta threads without a lock, a report may see a count without its bytes */
+struct Counter {
+	std::atomic<uint32_t> count;
+	std::atomic<uint64_t> bytes;
+};
+
+/** A counter as it was taken by Report */
+struct CounterValue {
+	uint32_t count;
+	uint64_t bytes;
+};
+
+template <typename T>
+using PerDirection = std::array<std::array<T, 256>, 2>;
+
+PerDirection<Counter> CommandCounters;
+PerDirection<Counter> PacketCounters;
+
+/** Set while CaptureFile is open, so Capture only takes StatsMutex when there is something to write */
+std::atomic<bool> Capturing;
+
+/** Guards everything below */
+SdlMutex StatsMutex;
+uint32_t PeriodStart;
+
+std::deque<uint32_t> TurnSendTimes;
+uint32_t TurnCount;
+uint32_t TurnLatencyTotal;
+uint32_t TurnLatencyMin;
+uint32_t TurnLatencyMax;
+
+std::ofstream CaptureFile;
+uint32_t CaptureStart;
+
+std::string ReplayFile;
+
+void Count(PerDirection<Counter> &counters, Direction direction, uint8_t id, size_t bytes)
+{
+	Counter &counter = counters[static_cast<size_t>(direction)][id];
+	counter.count.fetch_add(1, std::memory_order_relaxed);
+	counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+/** @brief Reads the counters and sets them back to zero. */
+PerDirection<CounterValue> TakeCounters(PerDirection<Counter> &counters)
+{
+	PerDirection<CounterValue> values;
+	for (size_t direction = 0; direction < counters.size(); direction++) {
+		for (size_t id = 0; id < counters[direction].size(); id++) {
+			Counter &counter = counters[direction][id];
+			values[direction][id] = { counter.count.exchange(0, std::memory_order_relaxed), counter.bytes.exchange(0, std::memory_order_relaxed) };
+		}
+	}
+	return values;
+}
+
+void WriteLE32(std::ostream &out, uint32_t value)
+{
+	char bytes[sizeof(value)];
+	StoreLE32(bytes, value);
+	out.write(bytes, sizeof(bytes));
+}
+
+void AppendCounters(std::string &out, const char *name, const PerDirection<CounterValue> &counters, float seconds)
+{
+	std::array<int, 256> ids;
+	for (int i = 0; i < 256; i++)
+		ids[i] = i;
+	auto totalBytes = [&](int id) {
+		return counters[0][id].bytes + counters[1][id].bytes;
+	};
+	std::sort(ids.begin(), ids.end(), [&](int a, int b) { return totalBytes(a) > totalBytes(b); });
+
+	for (int id : ids) {
+		const CounterValue &sent = counters[static_cast<size_t>(Direction::Sent)][id];
+		const CounterValue &received = counters[static_cast<size_t>(Direction::Received)][id];
+		if (sent.count == 0 && received.count == 0)
+			break;
+		out += fmt::format("\n{} {}: sent {:.1f}/s {:.0f} B/s, received {:.1f}/s {:.0f} B/s", name, id,
+		    sent.count / seconds, sent.bytes / seconds, received.count / seconds, received.bytes / seconds);
+	}
+}
+
+} // namespace
+
+void CountCommand(Direction direction, uint8_t cmd, size_t bytes)
+{
+	Count(CommandCounters, direction, cmd, bytes);
+}
+
+void CountPacket(Direction direction, uint8_t type, size_t bytes)
+{
+	Count(PacketCounters, direction, type, bytes);
+}
+
+void TurnSent()
+{
+	std::lock_guard<SdlMutex> lock(StatsMutex);
+	TurnSendTimes.push_back(SDL_GetTicks());
+}
+
+void TurnsReceived()
+{
+	std::lock_guard<SdlMutex> lock(StatsMutex);
+	if (TurnSendTimes.empty())
+		return;
+	const uint32_t latency = SDL_GetTicks() - TurnSendTimes.front();
+	TurnSendTimes.pop_front();
+	TurnLatencyMin = TurnCount == 0 ? latency : std::min(TurnLatencyMin, latency);
+	TurnLatencyMax = std::max(TurnLatencyMax, latency);
+	TurnLatencyTotal += latency;
+	TurnCount++;
+}
+
+std::string Report()
+{
+	std::lock_guard<SdlMutex> lock(StatsMutex);
+	const uint32_t now = SDL_GetTicks();
+	const float seconds = std::max(now - PeriodStart, 1U) / 1000.F;
+
+	std::string report = fmt::format("Network traffic over {:.1f}s", seconds);
+	if (TurnCount != 0) {
+		report += fmt::format("\nTurn latency: {} ms min, {} ms avg, {} ms max, {} in transit",
+		    TurnLatencyMin, TurnLatencyTotal / TurnCount, TurnLatencyMax, TurnSendTimes.size());
+	}
+	AppendCounters(report, "CMD", TakeCounters(CommandCounters), seconds);
+	AppendCounters(report, "PT", TakeCounters(PacketCounters), seconds);
+
+	TurnCount = 0;
+	TurnLatencyTotal = 0;
+	TurnLatencyMin = 0;
+	TurnLatencyMax = 0;
+	PeriodStart = now;
+	return report;
+}
+
+bool StartCapture(const std::string &path)
+{
+	std::lock_guard<SdlMutex> lock(StatsMutex);
+	Capturing = false;
+	CaptureFile.close();
+	CaptureFile.open(path, std::ios::binary | std::ios::trunc);
+	if (!CaptureFile.is_open()) {
+		LogError("Failed to create network capture {}", path);
+		return false;
+	}
+	CaptureFile.write(CaptureMagic, sizeof(CaptureMagic));
+	CaptureStart = SDL_GetTicks();
+	Capturing = true;
+	return true;
+}
+
+void StopCapture()
+{
+	std::lock_guard<SdlMutex> lock(StatsMutex);
+	Capturing = false;
+	CaptureFile.close();
+}
+
+bool IsCapturing()
+{
+	return Capturing;
+}
+
+void Capture(CaptureRecordType type, int player, const void *data, size_t size)
+{
+	if (!Capturing)
+		return;
+	std::lock_guard<SdlMutex> lock(StatsMutex);
+	// The capture may have stopped since the check
+	if (!CaptureFile.is_open())
+		return;
+	WriteLE32(CaptureFile, SDL_GetTicks() - CaptureStart);
+	CaptureFile.put(static_cast<char>(type));
+	CaptureFile.put(static_cast<char>(player));
+	WriteLE32(CaptureFile, size);
+	CaptureFile.write(static_cast<const char *>(data), size);
+}
+
+bool LoadCapture(const std::string &path, std::deque<CaptureRecord> &records)
+{
+	std::ifstream file(path, std::ios::binary);
+	char magic[sizeof(CaptureMagic)];
+	if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), CaptureMagic)) {
+		LogError("{} is not a network capture", path);
+		return false;
+	}
+
+	uint8_t header[CaptureRecordHeaderSize];
+	while (file.read(reinterpret_cast<char *>(header), sizeof(header))) {
+		CaptureRecord record;
+		record.time = LoadLE32(&header[0]);
+		record.type = static_cast<CaptureRecordType>(header[4]);
+		record.player = static_cast<int8_t>(header[5]);
+		const uint32_t size = LoadLE32(&header[6]);
+		if (record.type > CaptureRecordType::TurnReceived || size > MaxCaptureRecordSize) {
+			LogError("Network capture {} is corrupt", path);
+			return false;
+		}
+		record.data.resize(size);
+		if (!file.read(reinterpret_cast<char *>(record.data.data()), size)) {
+			LogError("Network capture {} is truncated", path);
+			return false;
+		}
+		records.push_back(std::move(record));
+	}
+	return true;
+}
+
+void SetReplayPath(std::string path)
+{
+	ReplayFile = std::move(path);
+}
+
+const std::string &ReplayPath()
+{
+	return ReplayFile;
+}
+
+} // namespace netstats
+
+} // namespace devilution
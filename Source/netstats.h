@@ -0,0 +1,73 @@
+/**
+ * @file netstats.h
+ *
+ * Interface of the network traffic counters and packet capture.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+namespace netstats {
+
+enum class Direction : uint8_t {
+	Sent,
+	Received,
+};
+
+/** @brief Counts one game command (CMD_*) of the given size. */
+void CountCommand(Direction direction, uint8_t cmd, size_t bytes);
+/** @brief Counts one dvlnet packet (PT_*) of the given size. */
+void CountPacket(Direction direction, uint8_t type, size_t bytes);
+/** @brief Notes when a turn was sent, TurnsReceived measures how long it took to come back. */
+void TurnSent();
+void TurnsReceived();
+
+/**
+ * @brief Describes the traffic per second since the previous report, then starts a new period.
+ */
+std::string Report();
+
+enum class CaptureRecordType : uint8_t {
+	MessageSent,
+	MessageReceived,
+	TurnSent,
+	TurnReceived,
+};
+
+/** @brief One message or turn from a capture file. */
+struct CaptureRecord {
+	/** Milliseconds since the capture started */
+	uint32_t time;
+	CaptureRecordType type;
+	/** Sender of a received message or turn, destination of a sent message */
+	int8_t player;
+	std::vector<byte> data;
+};
+
+/**
+ * @brief Starts writing every message and turn passing through the storm layer to path.
+ * @return false if the file could not be created.
+ */
+bool StartCapture(const std::string &path);
+void StopCapture();
+bool IsCapturing();
+void Capture(CaptureRecordType type, int player, const void *data, size_t size);
+
+/** @brief Reads a file written by StartCapture. */
+bool LoadCapture(const std::string &path, std::deque<CaptureRecord> &records);
+
+/** @brief Makes the loopback provider replay the messages received in a capture. */
+void SetReplayPath(std::string path);
+const std::string &ReplayPath();
+
+} // namespace netstats
+
+} // namespace devilution
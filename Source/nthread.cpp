@@ -4,13 +4,17 @@
  * Implementation of functions for managing game ticks.
  */
 
+#include <mutex>
+
 #include "nthread.h"
 #include "diablo.h"
 #include "engine/demomode.h"
 #include "gmenu.h"
 #include "storm/storm_net.hpp"
+#include "utils/sdl_cond.h"
 #include "utils/sdl_mutex.h"
 #include "utils/sdl_thread.h"
+#include "utils/stdcompat/optional.hpp"
 
 namespace devilution {
 
@@ -25,7 +29,13 @@ float gfProgressToNextGameTick = 0.0;
 
 namespace {
 
+/**
+ * Guards the turn state while the network thread works on it.
+ * The main thread only takes it to hand the network over or back.
+ */
 SdlMutex MemCrit;
+/** Wakes the network thread when it is handed the network, or when it should stop */
+std::optional<SdlCond> NetworkHandover;
 DWORD gdwDeltaBytesSec;
 bool nthread_should_run;
 char sgbSyncCountdown;
@@ -37,25 +47,19 @@ SdlThread Thread;
 
 void NthreadHandler()
 {
-	if (!nthread_should_run) {
-		return;
-	}
-
-	while (true) {
-		MemCrit.lock();
-		if (!nthread_should_run) {
-			MemCrit.unlock();
-			break;
+	std::lock_guard<SdlMutex> lock(MemCrit);
+	while (nthread_should_run) {
+		if (!sgbThreadIsRunning) {
+			// The main thread is running the game and keeps the turns going itself
+			NetworkHandover->wait(MemCrit);
+			continue;
 		}
 		nthread_send_and_recv_turn(0, 0);
 		int delta = gnTickDelay;
 		if (nthread_recv_turns())
 			delta = last_tick - SDL_GetTicks();
-		MemCrit.unlock();
 		if (delta > 0)
-			SDL_Delay(delta);
-		if (!nthread_should_run)
-			return;
+			NetworkHandover->wait(MemCrit, delta);
 	}
 }
 
@@ -96,6 +100,7 @@ uint32_t nthread_send_and_recv_turn(uint32_t curTurn, int turnDelta)
 		if (curTurn >= 0x7FFFFFFF)
 			curTurn &= 0xFFFF;
 	}
+	DvlNet_Flush();
 	return curTurn;
 }
 
@@ -180,22 +185,27 @@ void nthread_start(bool setTurnUpperBit)
 		gdwNormalMsgSize = largestMsgSize;
 	if (gbIsMultiplayer) {
 		sgbThreadIsRunning = false;
-		MemCrit.lock();
 		nthread_should_run = true;
+		NetworkHandover.emplace();
 		Thread = SdlThread { NthreadHandler };
 	}
 }
 
 void nthread_cleanup()
 {
-	nthread_should_run = false;
 	gdwTurnsInTransit = 0;
 	gdwNormalMsgSize = 0;
 	gdwLargestMsgSize = 0;
 	if (Thread.joinable() && Thread.get_id() != this_sdl_thread::get_id()) {
-		if (!sgbThreadIsRunning)
-			MemCrit.unlock();
+		{
+			std::lock_guard<SdlMutex> lock(MemCrit);
+			nthread_should_run = false;
+			NetworkHandover->signal();
+		}
 		Thread.join();
+		NetworkHandover = std::nullopt;
+	} else {
+		nthread_should_run = false;
 	}
 }
 
@@ -204,11 +214,10 @@ void nthread_ignore_mutex(bool bStart)
 	if (!Thread.joinable())
 		return;
 
-	if (bStart)
-		MemCrit.unlock();
-	else
-		MemCrit.lock();
+	// Waits for at most one turn of the network thread, which never sleeps while holding the lock
+	std::lock_guard<SdlMutex> lock(MemCrit);
 	sgbThreadIsRunning = bStart;
+	NetworkHandover->signal();
 }
 
 bool nthread_has_500ms_passed()
@@ -5,10 +5,19 @@
  */
 #include "pfile.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "codec.h"
 #include "engine.h"
+#include "herocache.h"
 #include "init.h"
 #include "loadsave.h"
 #include "menu.h"
@@ -17,7 +26,12 @@
 #include "utils/endian.hpp"
 #include "utils/file_util.h"
 #include "utils/language.h"
+#include "utils/log.hpp"
 #include "utils/paths.h"
+#include "utils/sdl_cond.h"
+#include "utils/sdl_mutex.h"
+#include "utils/sdl_thread.h"
+#include "utils/stdcompat/optional.hpp"
 #include "utils/utf8.hpp"
 
 namespace devilution {
@@ -33,16 +47,86 @@ namespace {
 
 MpqWriter archive;
 
+/*
+ * Writes to the save archive run in order on the save thread. The game thread only
+ * queues them, and waits for the queue to drain before it reads a save file back.
+ * While writes are pending the archive belongs to the save thread.
+ */
+SdlMutex SaveMutex;
+SdlCond SaveQueued;
+SdlCond SaveDrained;
+std::deque<std::function<void()>> SaveQueue;
+bool SaveInProgress;
+bool SaveThreadRunning;
+/** The untranslated message of the first error hit by the save thread, reported by the game thread at the next flush */
+const char *SaveError;
+std::optional<SdlThread> SaveThread;
+
+void SaveThreadHandler()
+{
+	std::unique_lock<SdlMutex> lock(SaveMutex);
+	while (true) {
+		while (SaveQueue.empty() && SaveThreadRunning)
+			SaveQueued.wait(SaveMutex);
+		if (SaveQueue.empty())
+			return;
+
+		std::function<void()> job = std::move(SaveQueue.front());
+		SaveQueue.pop_front();
+		// After a failure the archive is in an unknown state, so the rest of the save is dropped
+		if (SaveError == nullptr) {
+			SaveInProgress = true;
+			lock.unlock();
+			job();
+			lock.lock();
+			SaveInProgress = false;
+		}
+		if (SaveQueue.empty())
+			SaveDrained.signal();
+	}
+}
+
+void QueueSave(std::function<void()> job)
+{
+	if (!SaveThread) {
+		SaveThreadRunning = true;
+		SaveThread.emplace(SaveThreadHandler);
+	}
+	std::lock_guard<SdlMutex> lock(SaveMutex);
+	SaveQueue.push_back(std::move(job));
+	SaveQueued.signal();
+}
+
+/**
+ * @brief Called on the save thread, keeps the first error so the game can report it.
+ * @param message Marked with N_, it is translated by the game thread since translating is not thread-safe
+ */
+void SetSaveError(const char *message)
+{
+	std::lock_guard<SdlMutex> lock(SaveMutex);
+	if (SaveError == nullptr)
+		SaveError = message;
+}
+
+/**
+ * @brief Waits for the queued writes to finish.
+ * @return The untranslated message of the first error since the last drain, or nullptr
+ */
+const char *DrainSaveQueue()
+{
+	std::lock_guard<SdlMutex> lock(SaveMutex);
+	while (!SaveQueue.empty() || SaveInProgress)
+		SaveDrained.wait(SaveMutex);
+	const char *error = SaveError;
+	SaveError = nullptr;
+	return error;
+}
+
 /** List of character names for the character selection screen. */
 char hero_names[MAX_CHARACTERS][PLR_NAME_LEN];
 
-std::string GetSavePath(uint32_t saveNum)
+void AppendSavePrefix(std::string &path)
 {
-	std::string path = paths::PrefPath();
-	const char *ext = ".sv";
-	if (gbIsHellfire)
-		ext = ".hsv";
-
 	if (gbIsSpawn) {
 		if (!gbIsMultiplayer) {
 			path.append("spawn_");
@@ -56,6 +140,16 @@ std::string GetSavePath(uint32_t saveNum)
 			path.append("multi_");
 		}
 	}
+}
+
+std::string GetSavePath(uint32_t saveNum)
+{
+	std::string path = paths::PrefPath();
+	const char *ext = ".sv";
+	if (gbIsHellfire)
+		ext = ".hsv";
+
+	AppendSavePrefix(path);
 
 	char saveNumStr[21];
 	snprintf(saveNumStr, sizeof(saveNumStr) / sizeof(char), "%i", saveNum);
@@ -64,6 +158,33 @@ std::string GetSavePath(uint32_t saveNum)
 	return path;
 }
 
+std::string GetHeroCachePath()
+{
+	std::string path = paths::PrefPath();
+	AppendSavePrefix(path);
+	path.append(gbIsHellfire ? "heroes.hcache" : "heroes.cache");
+	return path;
+}
+
+/** Reading and decoding a save is mostly waiting on the disk and hashing, a few threads are plenty */
+constexpr int MaxHeroScanThreads = 8;
+
+/** Entries of the hero cache, loaded from disk when the heroes are first listed in a game mode */
+std::optional<std::vector<HeroCacheEntry>> HeroCache;
+/** The cache file HeroCache was loaded from, it differs between game modes */
+std::string HeroCachePath;
+
+/** @brief Drops the cached hero of a save, called before its archive is written. */
+void InvalidateHeroCacheEntry(uint32_t saveNum)
+{
+	if (!HeroCache || HeroCachePath != GetHeroCachePath())
+		return;
+	HeroCache->erase(std::remove_if(HeroCache->begin(), HeroCache->end(), [saveNum](const HeroCacheEntry &entry) {
+		return entry.saveNumber == saveNum;
+	}),
+	    HeroCache->end());
+}
+
 bool GetPermSaveNames(uint8_t dwIndex, char *szPerm)
 {
 	const char *fmt;
@@ -73,6 +194,12 @@ bool GetPermSaveNames(uint8_t dwIndex, char *szPerm)
 	else if (dwIndex < giNumberOfLevels * 2) {
 		dwIndex -= giNumberOfLevels;
 		fmt = "perms%02d";
+	} else if (dwIndex < giNumberOfLevels * 3) {
+		dwIndex -= giNumberOfLevels * 2;
+		fmt = "perml%02dd";
+	} else if (dwIndex < giNumberOfLevels * 4) {
+		dwIndex -= giNumberOfLevels * 3;
+		fmt = "perms%02dd";
 	} else
 		return false;
 
@@ -89,6 +216,12 @@ bool GetTempSaveNames(uint8_t dwIndex, char *szTemp)
 	else if (dwIndex < giNumberOfLevels * 2) {
 		dwIndex -= giNumberOfLevels;
 		fmt = "temps%02d";
+	} else if (dwIndex < giNumberOfLevels * 3) {
+		dwIndex -= giNumberOfLevels * 2;
+		fmt = "templ%02dd";
+	} else if (dwIndex < giNumberOfLevels * 4) {
+		dwIndex -= giNumberOfLevels * 3;
+		fmt = "temps%02dd";
 	} else
 		return false;
 
@@ -96,6 +229,7 @@ bool GetTempSaveNames(uint8_t dwIndex, char *szTemp)
 	return true;
 }
 
+/** @brief Runs on the save thread. */
 void RenameTempToPerm()
 {
 	char szTemp[MAX_PATH];
@@ -109,7 +243,10 @@ void RenameTempToPerm()
 		if (archive.HasFile(szTemp)) {
 			if (archive.HasFile(szPerm))
 				archive.RemoveHashEntry(szPerm);
-			archive.RenameFile(szTemp, szPerm);
+			if (!archive.RenameFile(szTemp, szPerm)) {
+				SetSaveError(N_("Failed to write to player archive."));
+				return;
+			}
 		}
 	}
 	assert(!GetPermSaveNames(dwIndex, szPerm));
@@ -157,8 +294,7 @@ void EncodeHero(const PlayerPack *pack)
 	std::unique_ptr<byte[]> packed { new byte[packedLen] };
 
 	memcpy(packed.get(), pack, sizeof(*pack));
-	codec_encode(packed.get(), sizeof(*pack), packedLen, pfile_get_password());
-	archive.WriteFile("hero", packed.get(), packedLen);
+	pfile_write_file("hero", std::move(packed), sizeof(*pack), CompressionCodec::Pkware);
 }
 
 bool OpenArchive(uint32_t saveNum)
@@ -166,10 +302,29 @@ bool OpenArchive(uint32_t saveNum)
 	return archive.Open(GetSavePath(saveNum).c_str());
 }
 
+void QueueOpenArchive(uint32_t saveNum)
+{
+	InvalidateHeroCacheEntry(saveNum);
+	QueueSave([path = GetSavePath(saveNum)]() {
+		if (!archive.Open(path.c_str()))
+			SetSaveError(N_("Failed to open player archive for writing."));
+	});
+}
+
+void QueueCloseArchive(bool clearTables)
+{
+	QueueSave([clearTables]() {
+		archive.Close(clearTables);
+	});
+}
+
 std::optional<MpqArchive> OpenSaveArchive(uint32_t saveNum)
 {
+	const std::string path = GetSavePath(saveNum);
+	// The game may have crashed while the tables were written, the reader must not see them half done
+	ReplayMpqJournal(path.c_str());
 	std::int32_t error;
-	return MpqArchive::Open(GetSavePath(saveNum).c_str(), error);
+	return MpqArchive::Open(path.c_str(), error);
 }
 
 void Game2UiPlayer(const Player &player, _uiheroinfo *heroinfo, bool bHasSaveFile)
@@ -204,25 +359,121 @@ bool GetFileName(uint8_t lvl, char *dst)
 			fmt = "game";
 		else if (lvl == giNumberOfLevels * 2 + 1)
 			fmt = "hero";
-		else
+		else if (lvl < giNumberOfLevels * 3 + 2) {
+			lvl -= giNumberOfLevels * 2 + 2;
+			fmt = "perml%02dd";
+		} else if (lvl < giNumberOfLevels * 4 + 2) {
+			lvl -= giNumberOfLevels * 3 + 2;
+			fmt = "perms%02dd";
+		} else
 			return false;
 	}
 	sprintf(dst, fmt, lvl);
 	return true;
 }
 
-bool ArchiveContainsGame(MpqArchive &hsArchive)
+/**
+ * @brief Reads the header of the saved game, without touching any game state so it can run on any thread.
+ *
+ * When the file still matches the checksum recorded when it was written, only the block holding the header is decoded.
+ */
+std::optional<uint32_t> ReadGameHeader(MpqArchive &hsArchive, uint32_t saveNum)
 {
 	if (gbIsMultiplayer)
-		return false;
+		return std::nullopt;
 
-	auto gameData = ReadArchive(hsArchive, "game");
-	if (gameData == nullptr)
-		return false;
+	int32_t error;
+	std::size_t length;
+	std::unique_ptr<byte[]> gameData = hsArchive.ReadFile("game", length, error);
+	if (error != 0)
+		return std::nullopt;
+
+	const std::optional<uint32_t> checksum = ReadMpqFileChecksum(GetSavePath(saveNum).c_str(), "game");
+	if (checksum && *checksum == MpqFileChecksum(gameData.get(), length)
+	    && length >= BlockSize + CodecSignatureSize && (length - CodecSignatureSize) % BlockSize == 0) {
+		CodecDecoder decoder(pfile_get_password());
+		decoder.Decode(gameData.get(), BlockSize);
+		return LoadLE32(gameData.get());
+	}
+
+	if (codec_decode(gameData.get(), length, pfile_get_password()) == 0)
+		return std::nullopt;
+
+	return LoadLE32(gameData.get());
+}
+
+bool ArchiveContainsGame(MpqArchive &hsArchive, uint32_t saveNum)
+{
+	std::optional<uint32_t> hdr = ReadGameHeader(hsArchive, saveNum);
+	return hdr && IsHeaderValid(*hdr);
+}
+
+/** The parts of a stale save archive that are read and decoded off the main thread */
+struct HeroScan {
+	HeroCacheEntry *entry;
+	std::optional<PlayerPack> pack;
+	std::optional<uint32_t> gameHeader;
+};
+
+struct HeroScanJob {
+	std::vector<HeroScan> scans;
+	std::atomic<size_t> nextScan { 0 };
+};
+
+void ScanHeroes(HeroScanJob &job)
+{
+	for (size_t i = job.nextScan++; i < job.scans.size(); i = job.nextScan++) {
+		HeroScan &scan = job.scans[i];
+		std::optional<MpqArchive> archive = OpenSaveArchive(scan.entry->saveNumber);
+		if (!archive)
+			continue;
+		PlayerPack pkplr;
+		if (!ReadHero(*archive, &pkplr))
+			continue;
+		scan.pack = pkplr;
+		scan.gameHeader = ReadGameHeader(*archive, scan.entry->saveNumber);
+	}
+}
+
+int SDLCALL ScanHeroesThread(void *data)
+{
+	ScanHeroes(*static_cast<HeroScanJob *>(data));
+	return 0;
+}
+
+/**
+ * @brief Fills in a cache entry from its scanned archive.
+ *
+ * Unpacking uses the global player and item state, so unlike the scan this runs on the main thread.
+ */
+void UnpackScannedHero(HeroScan &scan)
+{
+	HeroCacheEntry &entry = *scan.entry;
+	entry.heroName[0] = '\0';
+	entry.listed = false;
+	if (!scan.pack)
+		return;
+
+	PlayerPack &pkplr = *scan.pack;
+	memcpy(entry.heroName, pkplr.pName, sizeof(entry.heroName));
+	entry.heroName[sizeof(entry.heroName) - 1] = '\0';
+	bool hasSaveGame = scan.gameHeader && IsHeaderValid(*scan.gameHeader);
+	if (hasSaveGame)
+		pkplr.bIsHellfire = gbIsHellfireSaveGame ? 1 : 0;
+
+	auto &player = Players[0];
+
+	player = {};
 
-	uint32_t hdr = LoadLE32(gameData.get());
+	if (UnPackPlayer(&pkplr, player, false)) {
+		LoadHeroItems(player);
+		RemoveEmptyInventory(player);
+		CalcPlrInv(player, false);
 
-	return IsHeaderValid(hdr);
+		entry.heroInfo.saveNumber = entry.saveNumber;
+		Game2UiPlayer(player, &entry.heroInfo, hasSaveGame);
+		entry.listed = true;
+	}
 }
 
 } // namespace
@@ -238,18 +489,49 @@ PFileScopedArchiveWriter::PFileScopedArchiveWriter(bool clearTables)
     : save_num_(gSaveNumber)
     , clear_tables_(clearTables)
 {
-	if (!OpenArchive(save_num_))
-		app_fatal("%s", _("Failed to open player archive for writing."));
+	QueueOpenArchive(save_num_);
 }
 
 PFileScopedArchiveWriter::~PFileScopedArchiveWriter()
 {
-	archive.Close(clear_tables_);
+	QueueCloseArchive(clear_tables_);
+}
+
+void pfile_write_file(const char *name, std::unique_ptr<byte[]> data, size_t size, CompressionCodec codec)
+{
+	std::shared_ptr<byte[]> buffer(std::move(data));
+	QueueSave([name = std::string(name), buffer, size, codec, password = pfile_get_password()]() {
+		const size_t encodedLen = codec_get_encoded_len(size);
+		codec_encode(buffer.get(), size, encodedLen, password);
+		if (!archive.WriteFile(name.c_str(), buffer.get(), encodedLen, codec))
+			SetSaveError(N_("Failed to write to player archive."));
+	});
+}
+
+void pfile_flush_writes()
+{
+	const char *error = DrainSaveQueue();
+	if (error != nullptr)
+		app_fatal("%s", _(error));
 }
 
-MpqWriter &CurrentSaveArchive()
+void pfile_cleanup()
 {
-	return archive;
+	if (!SaveThread)
+		return;
+	// A fatal error on the save thread quits from there, and the thread cannot wait for itself
+	if (SaveThread->get_id() == this_sdl_thread::get_id())
+		return;
+	{
+		std::lock_guard<SdlMutex> lock(SaveMutex);
+		SaveThreadRunning = false;
+		SaveQueued.signal();
+	}
+	SaveThread->join();
+	SaveThread = std::nullopt;
+	if (SaveError != nullptr)
+		LogError("{}", _(SaveError));
+	SaveError = nullptr;
 }
 
 void pfile_write_hero(bool writeGameData, bool clearTables)
@@ -257,7 +539,7 @@ void pfile_write_hero(bool writeGameData, bool clearTables)
 	PFileScopedArchiveWriter scopedWriter(clearTables);
 	if (writeGameData) {
 		SaveGameData();
-		RenameTempToPerm();
+		QueueSave(RenameTempToPerm);
 	}
 	PlayerPack pkplr;
 	auto &myPlayer = Players[MyPlayerId];
@@ -272,36 +554,56 @@ void pfile_write_hero(bool writeGameData, bool clearTables)
 
 bool pfile_ui_set_hero_infos(bool (*uiAddHeroInfo)(_uiheroinfo *))
 {
+	pfile_flush_writes();
 	memset(hero_names, 0, sizeof(hero_names));
 
+	const std::string cachePath = GetHeroCachePath();
+	if (!HeroCache || HeroCachePath != cachePath) {
+		HeroCache = ReadHeroCache(cachePath.c_str());
+		HeroCachePath = cachePath;
+	}
+
+	// Only archives that changed since they were cached are read and decoded again
+	std::vector<HeroCacheEntry> entries;
+	std::vector<size_t> staleEntries;
 	for (uint32_t i = 0; i < MAX_CHARACTERS; i++) {
-		std::optional<MpqArchive> archive = OpenSaveArchive(i);
-		if (archive) {
-			PlayerPack pkplr;
-			if (ReadHero(*archive, &pkplr)) {
-				_uiheroinfo uihero;
-				uihero.saveNumber = i;
-				strcpy(hero_names[i], pkplr.pName);
-				bool hasSaveGame = ArchiveContainsGame(*archive);
-				if (hasSaveGame)
-					pkplr.bIsHellfire = gbIsHellfireSaveGame ? 1 : 0;
-
-				auto &player = Players[0];
-
-				player = {};
-
-				if (UnPackPlayer(&pkplr, player, false)) {
-					LoadHeroItems(player);
-					RemoveEmptyInventory(player);
-					CalcPlrInv(player, false);
-
-					Game2UiPlayer(player, &uihero, hasSaveGame);
-					uiAddHeroInfo(&uihero);
-				}
-			}
+		HeroCacheEntry entry {};
+		entry.saveNumber = i;
+		const std::string path = GetSavePath(i);
+		// Before the status is taken, so the cache holds that of the finished archive
+		ReplayMpqJournal(path.c_str());
+		if (!GetFileStatus(path.c_str(), &entry.archiveSize, &entry.archiveModified))
+			continue;
+		const HeroCacheEntry *cached = FindHeroCacheEntry(*HeroCache, entry.saveNumber, entry.archiveSize, entry.archiveModified);
+		if (cached != nullptr)
+			entry = *cached;
+		else
+			staleEntries.push_back(entries.size());
+		entries.push_back(entry);
+	}
+
+	const bool cacheChanged = !staleEntries.empty() || entries.size() != HeroCache->size();
+	if (!staleEntries.empty()) {
+		HeroScanJob job;
+		for (size_t index : staleEntries)
+			job.scans.push_back({ &entries[index], std::nullopt, std::nullopt });
+		RunOnThreads(ScanHeroesThread, &job, std::min(MaxHeroScanThreads, static_cast<int>(job.scans.size())));
+		for (HeroScan &scan : job.scans)
+			UnpackScannedHero(scan);
+	}
+
+	for (HeroCacheEntry &entry : entries) {
+		strcpy(hero_names[entry.saveNumber], entry.heroName);
+		if (entry.listed) {
+			_uiheroinfo uihero = entry.heroInfo;
+			uiAddHeroInfo(&uihero);
 		}
 	}
 
+	if (cacheChanged)
+		WriteHeroCache(cachePath.c_str(), entries);
+	HeroCache = std::move(entries);
+
 	return true;
 }
 
@@ -330,13 +632,15 @@ bool pfile_ui_save_create(_uiheroinfo *heroinfo)
 	uint32_t saveNum = heroinfo->saveNumber;
 	if (saveNum >= MAX_CHARACTERS)
 		return false;
-	if (!OpenArchive(saveNum))
-		return false;
+	pfile_flush_writes();
 	heroinfo->saveNumber = saveNum;
 
 	giNumberOfLevels = gbIsHellfire ? 25 : 17;
 
-	archive.RemoveHashEntries(GetFileName);
+	QueueOpenArchive(saveNum);
+	QueueSave([]() {
+		archive.RemoveHashEntries(GetFileName);
+	});
 	CopyUtf8(hero_names[saveNum], heroinfo->name, sizeof(hero_names[saveNum]));
 
 	auto &player = Players[0];
@@ -350,7 +654,13 @@ bool pfile_ui_save_create(_uiheroinfo *heroinfo)
 		SaveHeroItems(player);
 	}
 
-	archive.Close();
+	QueueCloseArchive(true);
+	// Failing to create a hero is reported by the menu, it does not end the game
+	const char *error = DrainSaveQueue();
+	if (error != nullptr) {
+		LogError("{}", _(error));
+		return false;
+	}
 	return true;
 }
 
@@ -358,8 +668,10 @@ bool pfile_delete_save(_uiheroinfo *heroInfo)
 {
 	uint32_t saveNum = heroInfo->saveNumber;
 	if (saveNum < MAX_CHARACTERS) {
+		pfile_flush_writes();
 		hero_names[saveNum][0] = '\0';
 		RemoveFile(GetSavePath(saveNum).c_str());
+		RemoveMpqSidecarFiles(GetSavePath(saveNum).c_str());
 	}
 	return true;
 }
@@ -370,13 +682,14 @@ void pfile_read_player_from_save(uint32_t saveNum, Player &player)
 
 	PlayerPack pkplr;
 	{
+		pfile_flush_writes();
 		std::optional<MpqArchive> archive = OpenSaveArchive(saveNum);
 		if (!archive)
 			app_fatal("%s", _("Unable to open archive"));
 		if (!ReadHero(*archive, &pkplr))
 			app_fatal("%s", _("Unable to load character"));
 
-		gbValidSaveFile = ArchiveContainsGame(*archive);
+		gbValidSaveFile = ArchiveContainsGame(*archive, saveNum);
 		if (gbValidSaveFile)
 			pkplr.bIsHellfire = gbIsHellfireSaveGame ? 1 : 0;
 	}
@@ -397,6 +710,7 @@ bool LevelFileExists()
 	GetPermLevelNames(szName);
 
 	uint32_t saveNum = gSaveNumber;
+	pfile_flush_writes();
 	if (!OpenArchive(saveNum))
 		app_fatal("%s", _("Unable to read to save file archive"));
 
@@ -417,6 +731,7 @@ void GetPermLevelNames(char *szPerm)
 {
 	uint32_t saveNum = gSaveNumber;
 	GetTempLevelNames(szPerm);
+	pfile_flush_writes();
 	if (!OpenArchive(saveNum))
 		app_fatal("%s", _("Unable to read to save file archive"));
 
@@ -430,27 +745,194 @@ void GetPermLevelNames(char *szPerm)
 	}
 }
 
+void GetTempLevelDeltaNames(char *szTemp)
+{
+	if (setlevel)
+		sprintf(szTemp, "temps%02dd", setlvlnum);
+	else
+		sprintf(szTemp, "templ%02dd", currlevel);
+}
+
 void pfile_remove_temp_files()
 {
 	if (gbIsMultiplayer)
 		return;
 
-	uint32_t saveNum = gSaveNumber;
-	if (!OpenArchive(saveNum))
-		app_fatal("%s", _("Unable to write to save file archive"));
-	archive.RemoveHashEntries(GetTempSaveNames);
-	archive.Close();
+	// The level keyframe may have been one of the temp files
+	ClearLevelKeyframe();
+
+	QueueSave([path = GetSavePath(gSaveNumber)]() {
+		if (!archive.Open(path.c_str())) {
+			SetSaveError(N_("Unable to write to save file archive"));
+			return;
+		}
+		archive.RemoveHashEntries(GetTempSaveNames);
+		archive.Close();
+	});
 }
 
 std::unique_ptr<byte[]> pfile_read(const char *pszName, size_t *pdwLen)
 {
 	uint32_t saveNum = gSaveNumber;
+	pfile_flush_writes();
 	std::optional<MpqArchive> archive = OpenSaveArchive(saveNum);
 	if (!archive)
 		return nullptr;
 	return ReadArchive(*archive, pszName, pdwLen);
 }
 
+namespace {
+
+/** @brief Turns the temp name of a level file into the perm one, unless this session has already saved the temp file. */
+void GetSavedLevelName(MpqArchive &archive, char *szName, bool delta)
+{
+	uint32_t fileNumber;
+	if (archive.GetFileNumber(MpqArchive::CalculateFileHash(szName), fileNumber))
+		return;
+	if (setlevel)
+		sprintf(szName, delta ? "perms%02dd" : "perms%02d", setlvlnum);
+	else
+		sprintf(szName, delta ? "perml%02dd" : "perml%02d", currlevel);
+}
+
+} // namespace
+
+PFileLevel pfile_read_level()
+{
+	PFileLevel level;
+	uint32_t saveNum = gSaveNumber;
+	pfile_flush_writes();
+	std::optional<MpqArchive> archive = OpenSaveArchive(saveNum);
+	if (!archive)
+		return level;
+
+	char szName[MAX_PATH];
+	GetTempLevelNames(szName);
+	GetSavedLevelName(*archive, szName, /*delta=*/false);
+	level.name = szName;
+	level.data = ReadArchive(*archive, szName, &level.size);
+
+	GetTempLevelDeltaNames(szName);
+	GetSavedLevelName(*archive, szName, /*delta=*/true);
+	level.deltaName = szName;
+	level.delta = ReadArchive(*archive, szName, &level.deltaSize);
+	return level;
+}
+
+/**
+ * The buffer is only written by the save thread, and only below the published size while the game
+ * thread reads it, so the mutex just guards the size and the flags.
+ */
+struct PFileStream::State {
+	SdlMutex mutex;
+	SdlCond progress;
+	std::unique_ptr<byte[]> data;
+	size_t available = 0;
+	bool done = false;
+	bool failed = false;
+
+	void Publish(size_t size)
+	{
+		std::lock_guard<SdlMutex> lock(mutex);
+		available = size;
+		progress.signal();
+	}
+
+	void Finish(bool ok)
+	{
+		std::lock_guard<SdlMutex> lock(mutex);
+		done = true;
+		failed = !ok;
+		progress.signal();
+	}
+
+	bool Decode(MpqArchive &archive, uint32_t fileNumber, const char *password)
+	{
+		int32_t error;
+		const size_t size = archive.GetUnpackedFileSize(fileNumber, error);
+		if (error != 0 || size <= CodecSignatureSize || (size - CodecSignatureSize) % BlockSize != 0)
+			return false;
+		const uint32_t numBlocks = archive.GetNumBlocks(fileNumber, error);
+		if (error != 0)
+			return false;
+
+		const size_t encodedSize = size - CodecSignatureSize;
+		data = std::unique_ptr<byte[]> { new byte[size] };
+		CodecDecoder decoder(password);
+		size_t read = 0;
+		size_t decoded = 0;
+		for (uint32_t block = 0; block < numBlocks; block++) {
+			const size_t blockSize = archive.GetBlockSize(fileNumber, block, error);
+			if (error != 0 || blockSize > size - read)
+				return false;
+			if (archive.ReadBlock(fileNumber, block, reinterpret_cast<uint8_t *>(&data[read]), static_cast<uint32_t>(blockSize)) != 0)
+				return false;
+			read += blockSize;
+
+			const size_t end = std::min(read, encodedSize) / BlockSize * BlockSize;
+			decoder.Decode(&data[decoded], end - decoded);
+			decoded = end;
+			// The last block holds padding, how much is only known from the signature
+			Publish(std::min(decoded, encodedSize - BlockSize));
+		}
+		if (read != size)
+			return false;
+
+		const size_t decodedSize = decoder.Finish(&data[encodedSize], encodedSize);
+		if (decodedSize == 0)
+			return false;
+		Publish(decodedSize);
+		return true;
+	}
+
+	void Read(uint32_t saveNum, const char *name, const char *password)
+	{
+		bool ok = false;
+		std::optional<MpqArchive> archive = OpenSaveArchive(saveNum);
+		uint32_t fileNumber;
+		if (archive && archive->GetFileNumber(MpqArchive::CalculateFileHash(name), fileNumber)
+		    && archive->OpenBlockOffsetTable(fileNumber, name) == 0) {
+			ok = Decode(*archive, fileNumber, password);
+			archive->CloseBlockOffsetTable(fileNumber);
+		}
+		Finish(ok);
+	}
+};
+
+PFileStream::PFileStream(const char *pszName)
+    : state_(std::make_shared<State>())
+{
+	// Earlier writes must be done before the read, the save thread runs the later ones after it
+	pfile_flush_writes();
+	QueueSave([state = state_, saveNum = gSaveNumber, name = std::string(pszName), password = pfile_get_password()]() {
+		state->Read(saveNum, name.c_str(), password);
+	});
+}
+
+PFileStream::~PFileStream()
+{
+	WaitFor(std::numeric_limits<size_t>::max());
+}
+
+size_t PFileStream::WaitFor(size_t len)
+{
+	std::lock_guard<SdlMutex> lock(state_->mutex);
+	while (state_->available < len && !state_->done)
+		state_->progress.wait(state_->mutex);
+	if (state_->failed) {
+		// Part of the file may already have been parsed, so it can't just be reported as missing
+		if (state_->available != 0)
+			app_fatal("%s", _("Invalid save file"));
+		return 0;
+	}
+	return state_->available;
+}
+
+const byte *PFileStream::Data() const
+{
+	return state_->data.get();
+}
+
 void pfile_update(bool forceSave)
 {
 	static Uint32 prevTick;
@@ -5,6 +5,9 @@
  */
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include "DiabloUI/diabloui.h"
 #include "mpq/mpq_writer.hpp"
 #include "player.h"
@@ -17,10 +20,10 @@ extern bool gbValidSaveFile;
 
 class PFileScopedArchiveWriter {
 public:
-	// Opens the player save file for writing
+	// Queues opening the player save file for writing
 	PFileScopedArchiveWriter(bool clearTables = !gbIsMultiplayer);
 
-	// Finishes writing and closes the player save file.
+	// Queues closing the player save file, once the files written in this scope are done.
 	~PFileScopedArchiveWriter();
 
 private:
@@ -28,8 +31,16 @@ private:
 	bool clear_tables_;
 };
 
-MpqWriter &CurrentSaveArchive();
 const char *pfile_get_password();
+/**
+ * @brief Queues a file for the open save archive, it is encoded and written on the save thread.
+ * @param data Buffer of at least codec_get_encoded_len(size) bytes, holding size bytes of plain data.
+ */
+void pfile_write_file(const char *name, std::unique_ptr<byte[]> data, size_t size, CompressionCodec codec);
+/** @brief Waits for every queued save write, reports the first one that failed. */
+void pfile_flush_writes();
+/** @brief Finishes the queued save writes and stops the save thread. */
+void pfile_cleanup();
 void pfile_write_hero(bool writeGameData = false, bool clearTables = !gbIsMultiplayer);
 bool pfile_ui_set_hero_infos(bool (*uiAddHeroInfo)(_uiheroinfo *));
 void pfile_ui_set_class_stats(unsigned int playerClass, _uidefaultstats *classStats);
@@ -40,8 +51,53 @@ void pfile_read_player_from_save(uint32_t saveNum, Player &player);
 bool LevelFileExists();
 void GetTempLevelNames(char *szTemp);
 void GetPermLevelNames(char *szPerm);
+void GetTempLevelDeltaNames(char *szTemp);
 void pfile_remove_temp_files();
 std::unique_ptr<byte[]> pfile_read(const char *pszName, size_t *pdwLen);
+
+/** @brief The saved image of the current level and its delta. */
+struct PFileLevel {
+	std::string name;
+	std::unique_ptr<byte[]> data;
+	size_t size = 0;
+	std::string deltaName;
+	/** nullptr if the level was saved without a delta */
+	std::unique_ptr<byte[]> delta;
+	size_t deltaSize = 0;
+};
+
+/** @brief Reads the current level and its delta, with a single flush and archive open for both. */
+PFileLevel pfile_read_level();
+
+/**
+ * @brief Reads a file of the current save on the save thread, decoding each sector as soon as it is read.
+ *
+ * The game can parse the start of the file while the rest is still being decompressed and decrypted.
+ */
+class PFileStream {
+public:
+	explicit PFileStream(const char *pszName);
+	/** Waits for the rest of the file, so a bad checksum is reported even if the end of it was never parsed */
+	~PFileStream();
+
+	PFileStream(const PFileStream &) = delete;
+	PFileStream &operator=(const PFileStream &) = delete;
+
+	/**
+	 * @brief Blocks until the first len bytes are decoded, or until the whole file is.
+	 * @return Number of bytes that can be read from Data(), 0 if the file is missing or invalid
+	 */
+	size_t WaitFor(size_t len);
+
+	/** @brief The decoded file, only valid up to the size last returned by WaitFor. */
+	const byte *Data() const;
+
+	struct State;
+
+private:
+	std::shared_ptr<State> state_;
+};
+
 void pfile_update(bool forceSave);
 
 } // namespace devilution
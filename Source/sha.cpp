@@ -6,147 +6,115 @@
 #include "sha.h"
 
 #include <cstdint>
-#include <cstring>
 
-#include <SDL.h>
-
-#include "appfat.h"
+#include "utils/endian.hpp"
 
 namespace devilution {
 
 // NOTE: Diablo's "SHA1" is different from actual SHA1 in that it uses arithmetic
-// right shifts (sign bit extension).
+// right shifts (sign bit extension), and its message schedule does not rotate.
+// Neither matches the SHA instructions of modern CPUs, so this stays portable code.
 
 namespace {
 
-struct SHA1Context {
-	uint32_t state[SHA1HashSize / sizeof(uint32_t)];
-	uint32_t buffer[BlockSize / sizeof(uint32_t)];
-};
-
-SHA1Context sgSHA1[3];
-
 /**
- * Diablo-"SHA1" circular left shift, portable version.
+ * Diablo-"SHA1" circular left shift.
+ *
+ * The SHA-like algorithm as originally implemented treated word as a signed value and used arithmetic right shifts
+ * (sign-extending). This results in the high 32-`bits` bits being set to 1 when the sign bit is set.
  */
-uint32_t SHA1CircularShift(uint32_t word, size_t bits)
+template <unsigned Bits>
+constexpr uint32_t SHA1CircularShift(uint32_t word)
 {
-	assert(bits < 32);
-	assert(bits > 0);
-
-	// The SHA-like algorithm as originally implemented treated word as a signed value and used arithmetic right shifts
-	//  (sign-extending). This results in the high 32-`bits` bits being set to 1.
-	if ((word & (1 << 31)) != 0)
-		return (0xFFFFFFFF << bits) | (word >> (32 - bits));
-	return (word << bits) | (word >> (32 - bits));
+	static_assert(Bits > 0 && Bits < 32, "invalid shift");
+	return (word << Bits) | (word >> (32 - Bits)) | ((0U - (word >> 31)) << Bits);
 }
 
-void SHA1Init(SHA1Context *context)
+constexpr uint32_t Choose(uint32_t b, uint32_t c, uint32_t d)
 {
-	context->state[0] = 0x67452301;
-	context->state[1] = 0xEFCDAB89;
-	context->state[2] = 0x98BADCFE;
-	context->state[3] = 0x10325476;
-	context->state[4] = 0xC3D2E1F0;
+	return d ^ (b & (c ^ d));
 }
 
-void SHA1ProcessMessageBlock(SHA1Context *context)
+constexpr uint32_t Parity(uint32_t b, uint32_t c, uint32_t d)
 {
-	std::uint32_t w[80];
-
-	for (int i = 0; i < 16; i++)
-		w[i] = SDL_SwapLE32(context->buffer[i]);
-
-	for (int i = 16; i < 80; i++) {
-		w[i] = w[i - 16] ^ w[i - 14] ^ w[i - 8] ^ w[i - 3];
-	}
-
-	std::uint32_t a = context->state[0];
-	std::uint32_t b = context->state[1];
-	std::uint32_t c = context->state[2];
-	std::uint32_t d = context->state[3];
-	std::uint32_t e = context->state[4];
-
-	for (int i = 0; i < 20; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + ((b & c) | ((~b) & d)) + e + w[i] + 0x5A827999;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
-
-	for (int i = 20; i < 40; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + (b ^ c ^ d) + e + w[i] + 0x6ED9EBA1;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
-
-	for (int i = 40; i < 60; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + ((b & c) | (b & d) | (c & d)) + e + w[i] + 0x8F1BBCDC;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
-
-	for (int i = 60; i < 80; i++) {
-		std::uint32_t temp = SHA1CircularShift(a, 5) + (b ^ c ^ d) + e + w[i] + 0xCA62C1D6;
-		e = d;
-		d = c;
-		c = SHA1CircularShift(b, 30);
-		b = a;
-		a = temp;
-	}
+	return b ^ c ^ d;
+}
 
-	context->state[0] += a;
-	context->state[1] += b;
-	context->state[2] += c;
-	context->state[3] += d;
-	context->state[4] += e;
+constexpr uint32_t Majority(uint32_t b, uint32_t c, uint32_t d)
+{
+	return (b & c) | (d & (b | c));
 }
 
-void SHA1Input(SHA1Context *context, const byte *messageArray, std::size_t len)
+/**
+ * @brief Runs rounds First to First + 19 with the given round function.
+ *
+ * Five rounds are unrolled per iteration, so the variables rotate by renaming instead of by copying.
+ */
+template <int First, uint32_t (*F)(uint32_t, uint32_t, uint32_t), uint32_t K>
+void SHA1Rounds(const uint32_t *w, uint32_t &a, uint32_t &b, uint32_t &c, uint32_t &d, uint32_t &e)
 {
-	for (auto i = len / BlockSize; i != 0; i--) {
-		memcpy(context->buffer, messageArray, BlockSize);
-		SHA1ProcessMessageBlock(context);
-		messageArray += BlockSize;
+	for (int i = First; i < First + 20; i += 5) {
+		e += SHA1CircularShift<5>(a) + F(b, c, d) + w[i] + K;
+		b = SHA1CircularShift<30>(b);
+		d += SHA1CircularShift<5>(e) + F(a, b, c) + w[i + 1] + K;
+		a = SHA1CircularShift<30>(a);
+		c += SHA1CircularShift<5>(d) + F(e, a, b) + w[i + 2] + K;
+		e = SHA1CircularShift<30>(e);
+		b += SHA1CircularShift<5>(c) + F(d, e, a) + w[i + 3] + K;
+		d = SHA1CircularShift<30>(d);
+		a += SHA1CircularShift<5>(b) + F(c, d, e) + w[i + 4] + K;
+		c = SHA1CircularShift<30>(c);
 	}
 }
 
 } // namespace
 
-void SHA1Clear()
+void SHA1Reset(SHA1Context &context)
 {
-	memset(sgSHA1, 0, sizeof(sgSHA1));
+	context.state[0] = 0x67452301;
+	context.state[1] = 0xEFCDAB89;
+	context.state[2] = 0x98BADCFE;
+	context.state[3] = 0x10325476;
+	context.state[4] = 0xC3D2E1F0;
 }
 
-void SHA1Result(int n, byte messageDigest[SHA1HashSize])
+void SHA1Calculate(SHA1Context &context, const byte data[BlockSize])
 {
-	std::uint32_t *messageDigestBlock = reinterpret_cast<std::uint32_t *>(messageDigest);
-	if (messageDigest != nullptr) {
-		for (auto &block : sgSHA1[n].state) {
-			*messageDigestBlock = SDL_SwapLE32(block);
-			messageDigestBlock++;
-		}
-	}
-}
+	uint32_t w[80];
 
-void SHA1Calculate(int n, const byte data[BlockSize], byte messageDigest[SHA1HashSize])
-{
-	SHA1Input(&sgSHA1[n], data, BlockSize);
-	if (messageDigest != nullptr)
-		SHA1Result(n, messageDigest);
+	for (int i = 0; i < 16; i++)
+		w[i] = LoadLE32(&data[i * 4]);
+
+	for (int i = 16; i < 80; i++)
+		w[i] = w[i - 16] ^ w[i - 14] ^ w[i - 8] ^ w[i - 3];
+
+	uint32_t a = context.state[0];
+	uint32_t b = context.state[1];
+	uint32_t c = context.state[2];
+	uint32_t d = context.state[3];
+	uint32_t e = context.state[4];
+
+	SHA1Rounds<0, Choose, 0x5A827999>(w, a, b, c, d, e);
+	SHA1Rounds<20, Parity, 0x6ED9EBA1>(w, a, b, c, d, e);
+	SHA1Rounds<40, Majority, 0x8F1BBCDC>(w, a, b, c, d, e);
+	SHA1Rounds<60, Parity, 0xCA62C1D6>(w, a, b, c, d, e);
+
+	context.state[0] += a;
+	context.state[1] += b;
+	context.state[2] += c;
+	context.state[3] += d;
+	context.state[4] += e;
 }
 
-void SHA1Reset(int n)
+void SHA1Result(const SHA1Context &context, byte messageDigest[SHA1HashSize])
 {
-	SHA1Init(&sgSHA1[n]);
+	for (uint32_t word : context.state) {
+		messageDigest[0] = static_cast<byte>(word);
+		messageDigest[1] = static_cast<byte>(word >> 8);
+		messageDigest[2] = static_cast<byte>(word >> 16);
+		messageDigest[3] = static_cast<byte>(word >> 24);
+		messageDigest += 4;
+	}
 }
 
 } // namespace devilution
@@ -14,9 +14,13 @@ namespace devilution {
 constexpr size_t BlockSize = 64;
 constexpr size_t SHA1HashSize = 20;
 
-void SHA1Clear();
-void SHA1Result(int n, byte messageDigest[SHA1HashSize]);
-void SHA1Calculate(int n, const byte data[BlockSize], byte messageDigest[SHA1HashSize]);
-void SHA1Reset(int n);
+struct SHA1Context {
+	uint32_t state[SHA1HashSize / sizeof(uint32_t)];
+};
+
+void SHA1Reset(SHA1Context &context);
+/** @brief Feeds one block of data into the hash. */
+void SHA1Calculate(SHA1Context &context, const byte data[BlockSize]);
+void SHA1Result(const SHA1Context &context, byte messageDigest[SHA1HashSize]);
 
 } // namespace devilution
@@ -5,10 +5,13 @@
  */
 #include "sound.h"
 
+#include <array>
 #include <cstdint>
-#include <list>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 #include <Aulib/DecoderDrwav.h>
 #include <Aulib/ResamplerSpeex.h>
@@ -21,7 +24,9 @@
 #include "options.h"
 #include "utils/log.hpp"
 #include "utils/math.h"
+#include "utils/sdl_cond.h"
 #include "utils/sdl_mutex.h"
+#include "utils/sdl_thread.h"
 #include "utils/stdcompat/algorithm.hpp"
 #include "utils/stdcompat/optional.hpp"
 #include "utils/stdcompat/shared_ptr_array.hpp"
@@ -68,27 +73,35 @@ void CleanupMusic()
 #endif
 }
 
-std::list<std::unique_ptr<SoundSample>> duplicateSounds;
-std::optional<SdlMutex> duplicateSoundsMutex;
-
-SoundSample *DuplicateSound(const SoundSample &sound)
+/**
+ * @brief Returns a voice of the sound that is free to play it again.
+ *
+ * Voices share the sound's data and are recycled as soon as they finish. When all of them
+ * are busy, the quietest (i.e. furthest away) one is stolen, unless the new playback is quieter still.
+ */
+SoundSample *AcquireVoice(TSnd &snd, int lVolume)
 {
-	auto duplicate = std::make_unique<SoundSample>();
-	if (duplicate->DuplicateFrom(sound) != 0)
-		return nullptr;
-	auto *result = duplicate.get();
-	decltype(duplicateSounds.begin()) it;
-	{
-		const std::lock_guard<SdlMutex> lock(*duplicateSoundsMutex);
-		duplicateSounds.push_back(std::move(duplicate));
-		it = duplicateSounds.end();
-		--it;
+	TSnd::Voice *quietest = nullptr;
+	for (TSnd::Voice &voice : snd.voices) {
+		if (voice.sample == nullptr) {
+			auto sample = std::make_unique<SoundSample>();
+			if (sample->DuplicateFrom(snd.DSB) != 0)
+				return nullptr;
+			voice.sample = std::move(sample);
+		}
+		if (!voice.sample->IsPlaying()) {
+			voice.volume = lVolume;
+			return voice.sample.get();
+		}
+		if (quietest == nullptr || voice.volume < quietest->volume)
+			quietest = &voice;
 	}
-	result->SetFinishCallback([it]([[maybe_unused]] Aulib::Stream &stream) {
-		const std::lock_guard<SdlMutex> lock(*duplicateSoundsMutex);
-		duplicateSounds.erase(it);
-	});
-	return result;
+
+	if (quietest == nullptr || quietest->volume > lVolume)
+		return nullptr;
+	quietest->sample->Stop();
+	quietest->volume = lVolume;
+	return quietest->sample.get();
 }
 
 /** Maps from track ID to track name in spawn. */
@@ -119,14 +132,107 @@ int CapVolume(int volume)
 	return clamp(volume, VOLUME_MIN, VOLUME_MAX);
 }
 
-} // namespace
+struct SoundLoadRequest {
+	std::unique_ptr<TSnd> *dest;
+	std::string path;
+	SDL_RWops *handle;
+	bool stream;
+	SoundLoadGroup group;
+	uint32_t generation;
+	std::unique_ptr<TSnd> snd;
+};
 
-void ClearDuplicateSounds()
+std::optional<SdlMutex> SoundLoadMutex;
+std::optional<SdlCond> SoundLoadWorkToDo;
+std::deque<SoundLoadRequest> SoundLoadQueue;
+std::vector<SoundLoadRequest> SoundLoadDone;
+/** The request the thread is working on. */
+const SoundLoadRequest *SoundLoadCurrent;
+/** Bumped to invalidate the requests of a group that are being or have been loaded. Main thread only. */
+std::array<uint32_t, 2> SoundLoadGeneration;
+bool SoundLoadRunning;
+SdlThread SoundLoadThread;
+
+/**
+ * @brief Reads and decodes a sound from a handle opened with OpenAsset(path, threadsafe=true).
+ * @return nullptr on error
+ */
+std::unique_ptr<TSnd> LoadSoundFromHandle(SoundLoadRequest &request)
 {
-	const std::lock_guard<SdlMutex> lock(*duplicateSoundsMutex);
-	duplicateSounds.clear();
+	auto snd = std::make_unique<TSnd>();
+	snd->start_tc = SDL_GetTicks() - 80 - 1;
+
+#ifndef STREAM_ALL_AUDIO
+	if (!request.stream) {
+		size_t dwBytes = SDL_RWsize(request.handle);
+		auto waveFile = MakeArraySharedPtr<std::uint8_t>(dwBytes);
+		const bool read = SDL_RWread(request.handle, waveFile.get(), dwBytes, 1) != 0;
+		SDL_RWclose(request.handle);
+		if (!read || snd->DSB.SetChunk(waveFile, dwBytes) != 0)
+			return nullptr;
+		return snd;
+	}
+#endif
+
+	if (snd->DSB.SetChunkStream(request.path, request.handle) != 0)
+		return nullptr;
+	return snd;
+}
+
+void SoundLoadHandler()
+{
+	std::lock_guard<SdlMutex> lock(*SoundLoadMutex);
+	while (true) {
+		while (!SoundLoadQueue.empty()) {
+			SoundLoadRequest request = std::move(SoundLoadQueue.front());
+			SoundLoadQueue.pop_front();
+			SoundLoadCurrent = &request;
+
+			SoundLoadMutex->unlock();
+			request.snd = LoadSoundFromHandle(request);
+			if (request.snd == nullptr)
+				LogError(LogCategory::Audio, "Failed to load {} in the background: {}", request.path, SDL_GetError());
+			SoundLoadMutex->lock();
+
+			SoundLoadCurrent = nullptr;
+			SoundLoadDone.push_back(std::move(request));
+		}
+		if (!SoundLoadRunning)
+			return;
+		SoundLoadWorkToDo->wait(*SoundLoadMutex);
+	}
+}
+
+void StartSoundLoader()
+{
+	SoundLoadRunning = true;
+	SoundLoadMutex.emplace();
+	SoundLoadWorkToDo.emplace();
+	SoundLoadThread = SdlThread { SoundLoadHandler };
+}
+
+void StopSoundLoader()
+{
+	if (!SoundLoadRunning)
+		return;
+
+	{
+		std::lock_guard<SdlMutex> lock(*SoundLoadMutex);
+		SoundLoadRunning = false;
+		for (SoundLoadRequest &request : SoundLoadQueue)
+			SDL_RWclose(request.handle);
+		SoundLoadQueue.clear();
+		SoundLoadWorkToDo->signal();
+	}
+
+	SoundLoadThread.join();
+	SoundLoadDone.clear();
+	SoundLoadMutex = std::nullopt;
+	SoundLoadWorkToDo = std::nullopt;
 }
 
+} // namespace
+
 void snd_play_snd(TSnd *pSnd, int lVolume, int lPan)
 {
 	if (pSnd == nullptr || !gbSoundOn) {
@@ -140,7 +246,7 @@ void snd_play_snd(TSnd *pSnd, int lVolume, int lPan)
 
 	SoundSample *sound = &pSnd->DSB;
 	if (sound->IsPlaying()) {
-		sound = DuplicateSound(*sound);
+		sound = AcquireVoice(*pSnd, lVolume);
 		if (sound == nullptr)
 			return;
 	}
@@ -183,9 +289,88 @@ std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream)
 	return snd;
 }
 
-TSnd::~TSnd()
+void TSnd::Stop()
 {
 	DSB.Stop();
+	for (Voice &voice : voices) {
+		if (voice.sample != nullptr)
+			voice.sample->Stop();
+	}
+}
+
+void LoadSoundAsync(std::unique_ptr<TSnd> &dest, const char *path, SoundLoadGroup group, bool stream)
+{
+	if (!SoundLoadRunning)
+		return;
+
+	{
+		std::lock_guard<SdlMutex> lock(*SoundLoadMutex);
+		// Requests from before a CancelSoundLoads are thrown away once done, so they do not count
+		const auto isPending = [&](const SoundLoadRequest &request) {
+			return request.dest == &dest && request.generation == SoundLoadGeneration[static_cast<size_t>(request.group)];
+		};
+		if ((SoundLoadCurrent != nullptr && isPending(*SoundLoadCurrent))
+		    || std::any_of(SoundLoadQueue.begin(), SoundLoadQueue.end(), isPending)
+		    || std::any_of(SoundLoadDone.begin(), SoundLoadDone.end(), isPending))
+			return;
+	}
+
+	// Archives may only be cloned on the main thread, so open the file here.
+	SDL_RWops *handle = OpenAsset(path, /*threadsafe=*/true);
+	if (handle == nullptr) {
+		LogError(LogCategory::Audio, "OpenAsset failed (from LoadSoundAsync): {}", SDL_GetError());
+		return;
+	}
+
+	SoundLoadRequest request { &dest, path, handle, stream, group, SoundLoadGeneration[static_cast<size_t>(group)], nullptr };
+	std::lock_guard<SdlMutex> lock(*SoundLoadMutex);
+	SoundLoadQueue.push_back(std::move(request));
+	SoundLoadWorkToDo->signal();
+}
+
+bool ProcessLoadedSounds()
+{
+	if (!SoundLoadRunning)
+		return false;
+
+	std::vector<SoundLoadRequest> done;
+	{
+		std::lock_guard<SdlMutex> lock(*SoundLoadMutex);
+		done.swap(SoundLoadDone);
+	}
+
+	bool loaded = false;
+	for (SoundLoadRequest &request : done) {
+		if (request.snd == nullptr || request.generation != SoundLoadGeneration[static_cast<size_t>(request.group)])
+			continue;
+		if (*request.dest != nullptr)
+			continue;
+		*request.dest = std::move(request.snd);
+		loaded = true;
+	}
+	return loaded;
+}
+
+void CancelSoundLoads(SoundLoadGroup group)
+{
+	if (!SoundLoadRunning)
+		return;
+
+	SoundLoadGeneration[static_cast<size_t>(group)]++;
+
+	std::lock_guard<SdlMutex> lock(*SoundLoadMutex);
+	const auto end = std::remove_if(SoundLoadQueue.begin(), SoundLoadQueue.end(), [&](SoundLoadRequest &request) {
+		if (request.group != group)
+			return false;
+		SDL_RWclose(request.handle);
+		return true;
+	});
+	SoundLoadQueue.erase(end, SoundLoadQueue.end());
+}
+
+TSnd::~TSnd()
+{
+	Stop();
 	DSB.Release();
 }
 
@@ -208,15 +393,15 @@ void snd_init()
 	LogVerbose(LogCategory::Audio, "Aulib sampleRate={} channels={} frameSize={} format={:#x}",
 	    Aulib::sampleRate(), Aulib::channelCount(), Aulib::frameSize(), Aulib::sampleFormat());
 
-	duplicateSoundsMutex.emplace();
+	StartSoundLoader();
 	gbSndInited = true;
 }
 
 void snd_deinit()
 {
 	if (gbSndInited) {
+		StopSoundLoader();
 		Aulib::quit();
-		duplicateSoundsMutex = std::nullopt;
 	}
 
 	gbSndInited = false;
@@ -5,6 +5,7 @@
  */
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -27,6 +28,9 @@ namespace devilution {
 #define PAN_MIN -6400
 #define PAN_MAX 6400
 
+/** Maximum number of extra voices a sound effect can use to overlap with itself. */
+constexpr int MaxSoundVoices = 4;
+
 enum _music_id : uint8_t {
 	TMUSIC_TOWN,
 	TMUSIC_L1,
@@ -45,10 +49,23 @@ struct TSnd {
 #ifndef NOSOUND
 	SoundSample DSB;
 
+	/** An extra playback of the sound, used while DSB is already playing. */
+	struct Voice {
+		std::unique_ptr<SoundSample> sample;
+		/** Attenuation of the latest playback, the quietest voice is the first to be stolen. */
+		int volume = ATTENUATION_MIN;
+	};
+
+	/** Created on first use and reused for the lifetime of the sound. */
+	std::array<Voice, MaxSoundVoices> voices;
+
 	bool isPlaying()
 	{
 		return DSB.IsPlaying();
 	}
+
+	/** @brief Stops the sound and all of its voices. */
+	void Stop();
 #else
 	bool isPlaying()
 	{
@@ -59,11 +76,35 @@ struct TSnd {
 	~TSnd();
 };
 
+/** Sounds loaded in the background are cancelled per group, e.g. when a level's monsters are freed. */
+enum class SoundLoadGroup : uint8_t {
+	Effects,
+	Monsters,
+};
+
 extern bool gbSndInited;
-void ClearDuplicateSounds();
 void snd_stop_snd(TSnd *pSnd);
 void snd_play_snd(TSnd *pSnd, int lVolume, int lPan);
 std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream = false);
+
+/**
+ * @brief Loads a sound on the sound loading thread.
+ *
+ * The file is opened immediately, reading and decoding happen in the background.
+ * Once done, ProcessLoadedSounds stores the sound in `dest` unless it has been set in the meantime.
+ */
+void LoadSoundAsync(std::unique_ptr<TSnd> &dest, const char *path, SoundLoadGroup group, bool stream = false);
+
+/**
+ * @brief Stores the sounds loaded in the background in their destinations.
+ * @return Whether any sound was stored
+ */
+bool ProcessLoadedSounds();
+
+/**
+ * @brief Drops the pending background loads of a group, so their destinations can be freed.
+ */
+void CancelSoundLoads(SoundLoadGroup group);
 void snd_init();
 void snd_deinit();
 void music_stop();
@@ -10,9 +10,11 @@ bool gbSoundOn;
 // Disable clang-format here because our config says:
 // AllowShortFunctionsOnASingleLine: None
 // clang-format off
-void ClearDuplicateSounds() { }
 void snd_play_snd(TSnd *pSnd, int lVolume, int lPan) { }
 std::unique_ptr<TSnd> sound_file_load(const char *path, bool stream) { return nullptr; }
+void LoadSoundAsync(std::unique_ptr<TSnd> &dest, const char *path, SoundLoadGroup group, bool stream) { }
+bool ProcessLoadedSounds() { return false; }
+void CancelSoundLoads(SoundLoadGroup group) { }
 TSnd::~TSnd()
 {
 }
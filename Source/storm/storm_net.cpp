@@ -10,6 +10,7 @@
 
 #include "dvlnet/abstract_net.h"
 #include "menu.h"
+#include "netstats.h"
 #include "options.h"
 #include "utils/stubs.h"
 #include "utils/utf8.hpp"
@@ -47,6 +48,7 @@ bool SNetReceiveMessage(int *senderplayerid, void **data, uint32_t *databytes)
 		SErrSetLastError(STORM_ERROR_NO_MESSAGES_WAITING);
 		return false;
 	}
+	netstats::Capture(netstats::CaptureRecordType::MessageReceived, *senderplayerid, *data, *databytes);
 	return true;
 }
 
@@ -55,6 +57,7 @@ bool SNetSendMessage(int playerID, void *data, unsigned int databytes)
 #ifndef NONET
 	std::lock_guard<SdlMutex> lg(storm_net_mutex);
 #endif
+	netstats::Capture(netstats::CaptureRecordType::MessageSent, playerID, data, databytes);
 	return dvlnet_inst->SNetSendMessage(playerID, data, databytes);
 }
 
@@ -69,6 +72,11 @@ bool SNetReceiveTurns(int arraysize, char **arraydata, size_t *arraydatabytes, u
 		SErrSetLastError(STORM_ERROR_NO_MESSAGES_WAITING);
 		return false;
 	}
+	netstats::TurnsReceived();
+	for (int i = 0; i < arraysize; i++) {
+		if ((arrayplayerstatus[i] & PS_TURN_ARRIVED) != 0)
+			netstats::Capture(netstats::CaptureRecordType::TurnReceived, i, arraydata[i], arraydatabytes[i]);
+	}
 	return true;
 }
 
@@ -77,6 +85,8 @@ bool SNetSendTurn(char *data, unsigned int databytes)
 #ifndef NONET
 	std::lock_guard<SdlMutex> lg(storm_net_mutex);
 #endif
+	netstats::TurnSent();
+	netstats::Capture(netstats::CaptureRecordType::TurnSent, -1, data, databytes);
 	return dvlnet_inst->SNetSendTurn(data, databytes);
 }
 
@@ -268,4 +278,12 @@ bool DvlNet_IsPublicGame()
 	return GameIsPublic;
 }
 
+void DvlNet_Flush()
+{
+#ifndef NONET
+	std::lock_guard<SdlMutex> lg(storm_net_mutex);
+#endif
+	dvlnet_inst->flush();
+}
+
 } // namespace devilution
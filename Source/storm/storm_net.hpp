@@ -171,5 +171,7 @@ std::vector<std::string> DvlNet_GetGamelist();
 void DvlNet_SetPassword(std::string pw);
 void DvlNet_ClearPassword();
 bool DvlNet_IsPublicGame();
+/** @brief Sends the packets queued by the network backend, called once per game tick. */
+void DvlNet_Flush();
 
 } // namespace devilution
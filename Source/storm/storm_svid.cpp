@@ -153,7 +153,8 @@ bool SVidPlayBegin(const char *filename, int flags)
 	// 0x800000 // Edge detection
 	// 0x200800 // Clear FB
 
-	SDL_RWops *videoStream = OpenAsset(filename);
+	// Thread-safe so that upcoming blocks are decompressed in the background.
+	SDL_RWops *videoStream = OpenAsset(filename, /*threadsafe=*/true);
 	SVidHandle = Smacker_Open(videoStream);
 	if (!SVidHandle.isValid) {
 		return false;
@@ -3,7 +3,9 @@
  *
  * Implementation of functionality for syncing game state with other players.
  */
+#include <algorithm>
 #include <climits>
+#include <cstdint>
 
 #include "gendung.h"
 #include "monster.h"
@@ -13,24 +15,66 @@ namespace devilution {
 
 namespace {
 
-uint16_t sgnMonsterPriority[MAXMONSTERS];
-int sgnMonsters;
-uint16_t sgwLRU[MAXMONSTERS];
+/** Tiles from the local player within which a monster's relevance grows with proximity, about a screen */
+constexpr int RelevanceRange = 24;
+/** Relevance of a monster that is not hunting anyone, so its state rarely changes */
+constexpr uint32_t IdleRelevance = 1;
+/** Relevance of a hunting monster that is out of range or closer to another player */
+constexpr uint32_t FarRelevance = 2;
+constexpr uint32_t HitPointsRelevance = 64;
+constexpr uint32_t ActionRelevance = 32;
+constexpr int32_t HitPointsUnknown = INT32_MIN;
+
+/** Relevance accumulated since the monster was last synced, the highest are sent first */
+uint32_t sgnMonsterPriority[MAXMONSTERS];
+int32_t sgnSyncedHitPoints[MAXMONSTERS];
+/** Tile distance from the local player, sent as _mdelta */
+uint8_t sgnMonsterDistance[MAXMONSTERS];
+int sgnSyncLevel;
 int sgnSyncItem;
 int sgnSyncPInv;
 
-void SyncOneMonster()
+void ResetMonsterPriorities()
 {
-	for (int i = 0; i < ActiveMonsterCount; i++) {
-		int m = ActiveMonsters[i];
-		auto &monster = Monsters[m];
-		sgnMonsterPriority[m] = Players[MyPlayerId].position.tile.ManhattanDistance(monster.position.tile);
-		if (monster._msquelch == 0) {
-			sgnMonsterPriority[m] += 0x1000;
-		} else if (sgwLRU[m] != 0) {
-			sgwLRU[m]--;
+	for (int i = 0; i < MAXMONSTERS; i++) {
+		sgnMonsterPriority[i] = 0;
+		sgnSyncedHitPoints[i] = HitPointsUnknown;
+	}
+	sgnSyncLevel = currlevel;
+}
+
+/**
+ * @brief Scores how much other players gain from an update of the monster this tick.
+ *
+ * Players apply an update only if the sender is at least as close to the monster as they are,
+ * so a monster that another player on this level is closer to is worth little: that player
+ * syncs it and we only keep the level delta fresh.
+ */
+uint32_t MonsterRelevance(int monsterId)
+{
+	const Monster &monster = Monsters[monsterId];
+	const int distance = Players[MyPlayerId].position.tile.ManhattanDistance(monster.position.tile);
+	sgnMonsterDistance[monsterId] = monster._msquelch == 0 ? UINT8_MAX : std::min(distance, UINT8_MAX);
+	if (monster._msquelch == 0)
+		return IdleRelevance;
+
+	uint32_t relevance = distance < RelevanceRange ? 4 * (RelevanceRange - distance) : FarRelevance;
+	for (int i = 0; i < MAX_PLRS; i++) {
+		const Player &player = Players[i];
+		if (i == MyPlayerId || !player.plractive || player.plrlevel != currlevel)
+			continue;
+		if (player.position.tile.ManhattanDistance(monster.position.tile) < distance) {
+			relevance = FarRelevance;
+			break;
 		}
 	}
+
+	const int32_t syncedHitPoints = sgnSyncedHitPoints[monsterId];
+	if (syncedHitPoints != HitPointsUnknown && syncedHitPoints != monster._mhitpoints)
+		relevance += HitPointsRelevance;
+	if (IsAnyOf(monster._mmode, MonsterMode::MeleeAttack, MonsterMode::SpecialMeleeAttack, MonsterMode::RangedAttack, MonsterMode::SpecialRangedAttack, MonsterMode::HitRecovery, MonsterMode::Death))
+		relevance += ActionRelevance;
+	return relevance;
 }
 
 void SyncMonsterPos(TSyncMonster &monsterSync, int ndx)
@@ -40,58 +84,12 @@ void SyncMonsterPos(TSyncMonster &monsterSync, int ndx)
 	monsterSync._mx = monster.position.tile.x;
 	monsterSync._my = monster.position.tile.y;
 	monsterSync._menemy = encode_enemy(monster);
-	monsterSync._mdelta = sgnMonsterPriority[ndx] > 255 ? 255 : sgnMonsterPriority[ndx];
+	monsterSync._mdelta = sgnMonsterDistance[ndx];
 	monsterSync.mWhoHit = monster.mWhoHit;
 	monsterSync._mhitpoints = monster._mhitpoints;
 
-	sgnMonsterPriority[ndx] = 0xFFFF;
-	sgwLRU[ndx] = monster._msquelch == 0 ? 0xFFFF : 0xFFFE;
-}
-
-bool SyncMonsterActive(TSyncMonster &monsterSync)
-{
-	int ndx = -1;
-	uint32_t lru = 0xFFFFFFFF;
-
-	for (int i = 0; i < ActiveMonsterCount; i++) {
-		int m = ActiveMonsters[i];
-		if (sgnMonsterPriority[m] < lru && sgwLRU[m] < 0xFFFE) {
-			lru = sgnMonsterPriority[m];
-			ndx = ActiveMonsters[i];
-		}
-	}
-
-	if (ndx == -1) {
-		return false;
-	}
-
-	SyncMonsterPos(monsterSync, ndx);
-	return true;
-}
-
-bool SyncMonsterActive2(TSyncMonster &monsterSync)
-{
-	int ndx = -1;
-	uint32_t lru = 0xFFFE;
-
-	for (int i = 0; i < ActiveMonsterCount; i++) {
-		if (sgnMonsters >= ActiveMonsterCount) {
-			sgnMonsters = 0;
-		}
-		int m = ActiveMonsters[sgnMonsters];
-		if (sgwLRU[m] < lru) {
-			lru = sgwLRU[m];
-			ndx = ActiveMonsters[sgnMonsters];
-		}
-		sgnMonsters++;
-	}
-
-	if (ndx == -1) {
-		return false;
-	}
-
-	SyncMonsterPos(monsterSync, ndx);
-	return true;
+	sgnMonsterPriority[ndx] = 0;
+	sgnSyncedHitPoints[ndx] = monster._mhitpoints;
 }
 
 void SyncPlrInv(TSyncHeader *pHdr)
@@ -265,20 +263,24 @@ uint32_t sync_all_monsters(byte *pbBuf, uint32_t dwMaxLen)
 	pHdr->wLen = 0;
 	SyncPlrInv(pHdr);
 	assert(dwMaxLen <= 0xffff);
-	SyncOneMonster();
 
-	for (int i = 0; i < ActiveMonsterCount && dwMaxLen >= sizeof(TSyncMonster); i++) {
-		auto &monsterSync = *reinterpret_cast<TSyncMonster *>(pbBuf);
-		bool sync = false;
-		if (i < 2) {
-			sync = SyncMonsterActive2(monsterSync);
-		}
-		if (!sync) {
-			sync = SyncMonsterActive(monsterSync);
-		}
-		if (!sync) {
-			break;
-		}
+	if (sgnSyncLevel != currlevel)
+		ResetMonsterPriorities();
+
+	int candidates[MAXMONSTERS];
+	for (int i = 0; i < ActiveMonsterCount; i++) {
+		int m = ActiveMonsters[i];
+		sgnMonsterPriority[m] = std::min<uint64_t>(static_cast<uint64_t>(sgnMonsterPriority[m]) + MonsterRelevance(m), UINT32_MAX);
+		candidates[i] = m;
+	}
+
+	// Fill the space left in the packet with the monsters that have gathered the most relevance
+	const int count = std::min<int>(ActiveMonsterCount, dwMaxLen / sizeof(TSyncMonster));
+	std::partial_sort(candidates, candidates + count, candidates + ActiveMonsterCount, [](int a, int b) {
+		return sgnMonsterPriority[a] > sgnMonsterPriority[b];
+	});
+	for (int i = 0; i < count; i++) {
+		SyncMonsterPos(*reinterpret_cast<TSyncMonster *>(pbBuf), candidates[i]);
 		pbBuf += sizeof(TSyncMonster);
 		pHdr->wLen += sizeof(TSyncMonster);
 		dwMaxLen -= sizeof(TSyncMonster);
@@ -325,8 +327,7 @@ uint32_t OnSyncData(const TCmd *pCmd, int pnum)
 
 void sync_init()
 {
-	sgnMonsters = 16 * MyPlayerId;
-	memset(sgwLRU, 255, sizeof(sgwLRU));
+	ResetMonsterPriorities();
 }
 
 } // namespace devilution
@@ -0,0 +1,319 @@
+/**
+ * @file utils/compression.cpp
+ *
+ * Implementation of the compression codecs used for network deltas and save archives.
+ *
+ * CompressionCodec::Lz data is a series of sequences:
+ *
+ *     token          literal length in the high nibble, match length - MinMatch in the low nibble
+ *     [length]       if the literal length nibble is 15: bytes added to it until one is below 255
+ *     literals
+ *     offset         uint16_t little-endian distance back to the match, absent in the last sequence
+ *     [length]       if the match length nibble is 15: bytes added to it until one is below 255
+ *
+ * Zero-run data is a series of runs:
+ *
+ *     token          zero count in the high nibble, literal count in the low nibble
+ *     [length]       if the zero count nibble is 15: bytes added to it until one is below 255
+ *     [length]       if the literal count nibble is 15: bytes added to it until one is below 255
+ *     literals
+ */
+#include "utils/compression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+
+#include "encrypt.h"
+
+namespace devilution {
+
+namespace {
+
+constexpr uint32_t MinMatch = 4;
+constexpr uint32_t MaxOffset = 65535;
+constexpr unsigned HashBits = 12;
+constexpr uint32_t NoPosition = UINT32_MAX;
+
+uint32_t Load32(const uint8_t *p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+uint32_t HashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761U) >> (32 - HashBits);
+}
+
+/** @brief Writes the extra bytes of a length whose nibble is saturated. */
+bool WriteLength(uint8_t *dst, uint32_t &out, uint32_t capacity, uint32_t length)
+{
+	for (; length >= 255; length -= 255) {
+		if (out == capacity)
+			return false;
+		dst[out++] = 255;
+	}
+	if (out == capacity)
+		return false;
+	dst[out++] = static_cast<uint8_t>(length);
+	return true;
+}
+
+bool ReadLength(const uint8_t *src, uint32_t &in, uint32_t size, uint32_t &length)
+{
+	uint8_t next;
+	do {
+		if (in == size)
+			return false;
+		next = src[in++];
+		length += next;
+	} while (next == 255);
+	return true;
+}
+
+constexpr uint64_t LowBits = 0x0101010101010101ULL;
+constexpr uint64_t HighBits = 0x8080808080808080ULL;
+
+/** @brief Returns the index of the first non-zero byte from start on, or size if there is none. */
+uint32_t SkipZeros(const uint8_t *data, uint32_t start, uint32_t size)
+{
+	uint32_t i = start;
+	for (; size - i >= sizeof(uint64_t); i += sizeof(uint64_t)) {
+		uint64_t word;
+		memcpy(&word, &data[i], sizeof(word));
+		if (word != 0)
+			break;
+	}
+	while (i < size && data[i] == 0)
+		i++;
+	return i;
+}
+
+/** @brief Returns the index of the first pair of zero bytes from start on, or size if there is none. */
+uint32_t FindZeroPair(const uint8_t *data, uint32_t start, uint32_t size)
+{
+	uint32_t i = start;
+	while (i < size) {
+		if (size - i >= sizeof(uint64_t)) {
+			uint64_t word;
+			memcpy(&word, &data[i], sizeof(word));
+			// Skips words without a zero byte, a pair may still start at their last byte
+			if (((word - LowBits) & ~word & HighBits) == 0) {
+				i += sizeof(uint64_t) - 1;
+				continue;
+			}
+		}
+		if (data[i] == 0 && (i + 1 == size || data[i + 1] == 0))
+			return i;
+		i++;
+	}
+	return size;
+}
+
+/** @brief Writes one sequence, pass matchLength 0 for the final literals-only sequence. */
+bool WriteSequence(uint8_t *dst, uint32_t &out, uint32_t capacity, const uint8_t *literals, uint32_t literalLength, uint32_t offset, uint32_t matchLength)
+{
+	if (out == capacity)
+		return false;
+	const uint32_t matchCode = matchLength != 0 ? matchLength - MinMatch : 0;
+	dst[out++] = static_cast<uint8_t>((std::min<uint32_t>(literalLength, 15) << 4) | std::min<uint32_t>(matchCode, 15));
+	if (literalLength >= 15 && !WriteLength(dst, out, capacity, literalLength - 15))
+		return false;
+	if (capacity - out < literalLength)
+		return false;
+	memcpy(&dst[out], literals, literalLength);
+	out += literalLength;
+	if (matchLength == 0)
+		return true;
+
+	if (capacity - out < 2)
+		return false;
+	dst[out++] = static_cast<uint8_t>(offset);
+	dst[out++] = static_cast<uint8_t>(offset >> 8);
+	return matchCode < 15 || WriteLength(dst, out, capacity, matchCode - 15);
+}
+
+} // namespace
+
+uint32_t LzCompress(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstCapacity)
+{
+	const auto *in = reinterpret_cast<const uint8_t *>(src);
+	auto *out = reinterpret_cast<uint8_t *>(dst);
+
+	std::array<uint32_t, 1U << HashBits> table;
+	table.fill(NoPosition);
+
+	uint32_t written = 0;
+	uint32_t anchor = 0;
+	uint32_t pos = 0;
+	while (pos + MinMatch <= srcSize) {
+		const uint32_t sequence = Load32(&in[pos]);
+		uint32_t &entry = table[HashSequence(sequence)];
+		const uint32_t candidate = entry;
+		entry = pos;
+		if (candidate == NoPosition || pos - candidate > MaxOffset || Load32(&in[candidate]) != sequence) {
+			pos++;
+			continue;
+		}
+
+		uint32_t matchLength = MinMatch;
+		while (pos + matchLength < srcSize && in[candidate + matchLength] == in[pos + matchLength])
+			matchLength++;
+		if (!WriteSequence(out, written, dstCapacity, &in[anchor], pos - anchor, pos - candidate, matchLength))
+			return 0;
+		pos += matchLength;
+		anchor = pos;
+	}
+
+	if (!WriteSequence(out, written, dstCapacity, &in[anchor], srcSize - anchor, 0, 0))
+		return 0;
+	return written;
+}
+
+bool LzDecompress(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstCapacity, uint32_t &dstSize)
+{
+	const auto *in = reinterpret_cast<const uint8_t *>(src);
+	auto *out = reinterpret_cast<uint8_t *>(dst);
+
+	uint32_t read = 0;
+	uint32_t written = 0;
+	while (true) {
+		if (read == srcSize)
+			return false;
+		const uint8_t token = in[read++];
+
+		uint32_t literalLength = token >> 4;
+		if (literalLength == 15 && !ReadLength(in, read, srcSize, literalLength))
+			return false;
+		if (srcSize - read < literalLength || dstCapacity - written < literalLength)
+			return false;
+		memcpy(&out[written], &in[read], literalLength);
+		read += literalLength;
+		written += literalLength;
+		if (read == srcSize)
+			break;
+
+		if (srcSize - read < 2)
+			return false;
+		const uint32_t offset = in[read] | (in[read + 1] << 8);
+		read += 2;
+		if (offset == 0 || offset > written)
+			return false;
+
+		uint32_t matchLength = token & 0xF;
+		if (matchLength == 15 && !ReadLength(in, read, srcSize, matchLength))
+			return false;
+		matchLength += MinMatch;
+		if (dstCapacity - written < matchLength)
+			return false;
+		// Byte by byte, as the match may overlap the bytes it produces
+		for (uint32_t i = 0; i < matchLength; i++, written++)
+			out[written] = out[written - offset];
+	}
+
+	dstSize = written;
+	return true;
+}
+
+uint32_t ZeroRunEncode(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstCapacity)
+{
+	const auto *in = reinterpret_cast<const uint8_t *>(src);
+	auto *out = reinterpret_cast<uint8_t *>(dst);
+
+	uint32_t read = 0;
+	uint32_t written = 0;
+	while (read < srcSize) {
+		const uint32_t literalsBegin = SkipZeros(in, read, srcSize);
+		const uint32_t literalsEnd = FindZeroPair(in, literalsBegin, srcSize);
+		const uint32_t zeroCount = literalsBegin - read;
+		const uint32_t literalCount = literalsEnd - literalsBegin;
+
+		if (written == dstCapacity)
+			return 0;
+		out[written++] = static_cast<uint8_t>((std::min<uint32_t>(zeroCount, 15) << 4) | std::min<uint32_t>(literalCount, 15));
+		if (zeroCount >= 15 && !WriteLength(out, written, dstCapacity, zeroCount - 15))
+			return 0;
+		if (literalCount >= 15 && !WriteLength(out, written, dstCapacity, literalCount - 15))
+			return 0;
+		if (dstCapacity - written < literalCount)
+			return 0;
+		memcpy(&out[written], &in[literalsBegin], literalCount);
+		written += literalCount;
+		read = literalsEnd;
+	}
+	return written;
+}
+
+bool ZeroRunDecode(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstSize)
+{
+	const auto *in = reinterpret_cast<const uint8_t *>(src);
+	auto *out = reinterpret_cast<uint8_t *>(dst);
+
+	uint32_t read = 0;
+	uint32_t written = 0;
+	while (read < srcSize) {
+		const uint8_t token = in[read++];
+		uint32_t zeroCount = token >> 4;
+		if (zeroCount == 15 && !ReadLength(in, read, srcSize, zeroCount))
+			return false;
+		uint32_t literalCount = token & 0xF;
+		if (literalCount == 15 && !ReadLength(in, read, srcSize, literalCount))
+			return false;
+		if (dstSize - written < zeroCount)
+			return false;
+		memset(&out[written], 0, zeroCount);
+		written += zeroCount;
+		if (srcSize - read < literalCount || dstSize - written < literalCount)
+			return false;
+		memcpy(&out[written], &in[read], literalCount);
+		read += literalCount;
+		written += literalCount;
+	}
+	return written == dstSize;
+}
+
+uint32_t CompressInPlace(CompressionCodec codec, byte *data, uint32_t size)
+{
+	switch (codec) {
+	case CompressionCodec::Pkware:
+		return PkwareCompress(data, size);
+	case CompressionCodec::Lz: {
+		if (size <= 1)
+			return size;
+		std::unique_ptr<byte[]> compressed { new byte[size] };
+		const uint32_t compressedSize = LzCompress(data, size, compressed.get(), size - 1);
+		if (compressedSize == 0)
+			return size;
+		memcpy(data, compressed.get(), compressedSize);
+		return compressedSize;
+	}
+	default:
+		return size;
+	}
+}
+
+bool DecompressInPlace(CompressionCodec codec, byte *data, uint32_t size, uint32_t maxBytes)
+{
+	switch (codec) {
+	case CompressionCodec::None:
+		return size <= maxBytes;
+	case CompressionCodec::Pkware:
+		PkwareDecompress(data, size, maxBytes);
+		return true;
+	case CompressionCodec::Lz: {
+		std::unique_ptr<byte[]> decompressed { new byte[maxBytes] };
+		uint32_t decompressedSize;
+		if (!LzDecompress(data, size, decompressed.get(), maxBytes, decompressedSize))
+			return false;
+		memcpy(data, decompressed.get(), decompressedSize);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+} // namespace devilution
@@ -0,0 +1,65 @@
+/**
+ * @file utils/compression.hpp
+ *
+ * Interface of the compression codecs used for network deltas and save archives.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "utils/stdcompat/cstddef.hpp"
+
+namespace devilution {
+
+/**
+ * @brief Identifies how a buffer is compressed.
+ *
+ * The values are sent over the network as the first byte of level data, where 1 has always meant PKWare.
+ */
+enum class CompressionCodec : uint8_t {
+	None = 0,
+	/** PKWare Data Compression Library implode, understood by every version and by MPQ readers. */
+	Pkware = 1,
+	/** Byte-oriented LZ77, several times faster than PKWare and usually smaller. */
+	Lz = 2,
+};
+
+/**
+ * @brief Compresses data in place.
+ * @return The compressed size, or size if the codec could not make the data smaller, in which case it is left as is.
+ */
+uint32_t CompressInPlace(CompressionCodec codec, byte *data, uint32_t size);
+
+/**
+ * @brief Decompresses data in place.
+ * @param data Compressed data of the given size, in a buffer that can hold maxBytes.
+ * @return false if the data is corrupt or does not fit.
+ */
+bool DecompressInPlace(CompressionCodec codec, byte *data, uint32_t size, uint32_t maxBytes);
+
+/**
+ * @brief Compresses src into dst using CompressionCodec::Lz.
+ * @return The compressed size, or 0 if it would not fit in dstCapacity.
+ */
+uint32_t LzCompress(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstCapacity);
+
+/**
+ * @brief Decompresses CompressionCodec::Lz data.
+ * @param dstSize Set to the decompressed size.
+ * @return false if the data is corrupt or does not fit in dstCapacity.
+ */
+bool LzDecompress(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstCapacity, uint32_t &dstSize);
+
+/**
+ * @brief Encodes src as runs of zero bytes and literal bytes, which suits the mostly empty dungeon grids.
+ * @return The encoded size, or 0 if it would not fit in dstCapacity.
+ */
+uint32_t ZeroRunEncode(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstCapacity);
+
+/**
+ * @brief Decodes data written by ZeroRunEncode.
+ * @return false if the data is corrupt or does not decode to exactly dstSize bytes.
+ */
+bool ZeroRunDecode(const byte *src, uint32_t srcSize, byte *dst, uint32_t dstSize);
+
+} // namespace devilution
@@ -20,6 +20,14 @@ constexpr std::uint32_t LoadLE32(const T *b)
 	return (static_cast<std::uint32_t>(b[3]) << 24) | (static_cast<std::uint32_t>(b[2]) << 16) | (static_cast<std::uint32_t>(b[1]) << 8) | static_cast<std::uint32_t>(b[0]);
 }
 
+template <typename T>
+constexpr std::uint64_t LoadLE64(const T *b)
+{
+	static_assert(sizeof(T) == 1, "invalid argument");
+	// NOLINTNEXTLINE(readability-magic-numbers)
+	return static_cast<std::uint64_t>(LoadLE32(b)) | (static_cast<std::uint64_t>(LoadLE32(b + 4)) << 32);
+}
+
 template <typename T>
 constexpr std::uint32_t LoadBE32(const T *b)
 {
@@ -28,4 +36,23 @@ constexpr std::uint32_t LoadBE32(const T *b)
 	return (static_cast<std::uint32_t>(b[0]) << 24) | (static_cast<std::uint32_t>(b[1]) << 16) | (static_cast<std::uint32_t>(b[2]) << 8) | static_cast<std::uint32_t>(b[3]);
 }
 
+template <typename T>
+constexpr void StoreLE32(T *b, std::uint32_t value)
+{
+	static_assert(sizeof(T) == 1, "invalid argument");
+	b[0] = static_cast<T>(value & 0xFF);
+	b[1] = static_cast<T>((value >> 8) & 0xFF);
+	b[2] = static_cast<T>((value >> 16) & 0xFF);
+	b[3] = static_cast<T>((value >> 24) & 0xFF);
+}
+
+template <typename T>
+constexpr void StoreLE64(T *b, std::uint64_t value)
+{
+	static_assert(sizeof(T) == 1, "invalid argument");
+	StoreLE32(b, static_cast<std::uint32_t>(value));
+	// NOLINTNEXTLINE(readability-magic-numbers)
+	StoreLE32(b + 4, static_cast<std::uint32_t>(value >> 32));
+}
+
 } // namespace devilution
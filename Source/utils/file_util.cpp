@@ -1,6 +1,7 @@
 #include "utils/file_util.h"
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 
 #include <SDL.h>
@@ -24,6 +25,7 @@
 #endif
 
 #if _POSIX_C_SOURCE >= 200112L || defined(_BSD_SOURCE) || defined(__APPLE__)
+#include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #endif
@@ -111,6 +113,38 @@ bool GetFileSize(const char *path, std::uintmax_t *size)
 #endif
 }
 
+bool GetFileStatus(const char *path, std::uintmax_t *size, std::int64_t *modificationTime)
+{
+#if defined(_WIN64) || defined(_WIN32)
+	const auto pathUtf16 = ToWideChar(path);
+	if (pathUtf16 == nullptr) {
+		LogError("UTF-8 -> UTF-16 conversion error code {}", ::GetLastError());
+		return false;
+	}
+	WIN32_FILE_ATTRIBUTE_DATA attr;
+	if (!GetFileAttributesExW(&pathUtf16[0], GetFileExInfoStandard, &attr)) {
+		return false;
+	}
+	*size = static_cast<std::uintmax_t>(attr.nFileSizeHigh) << (sizeof(attr.nFileSizeHigh) * 8) | attr.nFileSizeLow;
+	*modificationTime = static_cast<std::int64_t>(static_cast<std::uint64_t>(attr.ftLastWriteTime.dwHighDateTime) << 32 | attr.ftLastWriteTime.dwLowDateTime);
+	return true;
+#else
+	struct ::stat statResult;
+	if (::stat(path, &statResult) == -1)
+		return false;
+	*size = static_cast<uintmax_t>(statResult.st_size);
+	// Use nanoseconds where available, so a rewrite within the same second is still noticed
+#if defined(__APPLE__)
+	*modificationTime = static_cast<std::int64_t>(statResult.st_mtimespec.tv_sec) * 1000000000 + statResult.st_mtimespec.tv_nsec;
+#elif _POSIX_C_SOURCE >= 200809L
+	*modificationTime = static_cast<std::int64_t>(statResult.st_mtim.tv_sec) * 1000000000 + statResult.st_mtim.tv_nsec;
+#else
+	*modificationTime = static_cast<std::int64_t>(statResult.st_mtime);
+#endif
+	return true;
+#endif
+}
+
 bool ResizeFile(const char *path, std::uintmax_t size)
 {
 #if defined(_WIN64) || defined(_WIN32)
@@ -140,6 +174,51 @@ bool ResizeFile(const char *path, std::uintmax_t size)
 #endif
 }
 
+bool SyncFile(const char *path)
+{
+#if defined(_WIN64) || defined(_WIN32)
+	const auto pathUtf16 = ToWideChar(path);
+	if (pathUtf16 == nullptr) {
+		LogError("UTF-8 -> UTF-16 conversion error code {}", ::GetLastError());
+		return false;
+	}
+	HANDLE file = ::CreateFileW(&pathUtf16[0], GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	const bool result = ::FlushFileBuffers(file) != 0;
+	::CloseHandle(file);
+	return result;
+#elif _POSIX_C_SOURCE >= 200112L || defined(_BSD_SOURCE) || defined(__APPLE__)
+	const int file = ::open(path, O_RDWR);
+	if (file == -1)
+		return false;
+	const bool result = ::fsync(file) == 0;
+	::close(file);
+	return result;
+#else
+	// No way to ask for it here, closing the stream is all that can be done
+	return FileExists(path);
+#endif
+}
+
+bool SyncParentDirectory(const char *path)
+{
+#if !(defined(_WIN64) || defined(_WIN32)) && (_POSIX_C_SOURCE >= 200112L || defined(_BSD_SOURCE) || defined(__APPLE__))
+	const char *separator = strrchr(path, '/');
+	const std::string directory = separator == nullptr ? "." : std::string(path, std::max<size_t>(separator - path, 1));
+	const int file = ::open(directory.c_str(), O_RDONLY);
+	if (file == -1)
+		return false;
+	const bool result = ::fsync(file) == 0;
+	::close(file);
+	return result;
+#else
+	// Windows flushes directory entries along with the file, elsewhere there is no way to ask for it
+	return true;
+#endif
+}
+
 void RemoveFile(const char *lpFileName)
 {
 #if defined(_WIN64) || defined(_WIN32)
@@ -13,7 +13,16 @@ namespace devilution {
 bool FileExists(const char *path);
 bool FileExistsAndIsWriteable(const char *path);
 bool GetFileSize(const char *path, std::uintmax_t *size);
+/**
+ * @brief Gets the size and the last modification time of a file.
+ * @param modificationTime Set to a platform specific timestamp, only meant to be compared for equality
+ */
+bool GetFileStatus(const char *path, std::uintmax_t *size, std::int64_t *modificationTime);
 bool ResizeFile(const char *path, std::uintmax_t size);
+/** @brief Waits until the contents of the file are on the disk, so they survive a crash or power loss. */
+bool SyncFile(const char *path);
+/** @brief Like SyncFile for the directory entry of the file, needed after the file was created. */
+bool SyncParentDirectory(const char *path);
 void RemoveFile(const char *lpFileName);
 std::optional<std::fstream> CreateFileStream(const char *path, std::ios::openmode mode);
 FILE *FOpen(const char *path, const char *mode);
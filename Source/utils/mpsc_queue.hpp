@@ -0,0 +1,91 @@
+/**
+ * @file utils/mpsc_queue.hpp
+ *
+ * A bounded lock-free queue with many producer threads and one consumer thread.
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace devilution {
+
+/**
+ * @brief Bounded queue that several threads can push to while one thread pops, without locks.
+ *
+ * Elements are filled and consumed in their slot and the slots are reused, so buffers held
+ * by T keep their capacity from one use to the next.
+ *
+ * Each slot carries a sequence number that tells whose turn it is (after Dmitry Vyukov's
+ * bounded MPMC queue).
+ */
+template <typename T, size_t Capacity>
+class MpscQueue {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	MpscQueue()
+	{
+		for (size_t i = 0; i < Capacity; i++)
+			slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	MpscQueue(const MpscQueue &) = delete;
+	MpscQueue &operator=(const MpscQueue &) = delete;
+
+	/**
+	 * @brief Claims a free slot and passes its element to fill.
+	 * @return false if the queue is full, in which case fill is not called.
+	 */
+	template <typename F>
+	bool TryPush(F &&fill)
+	{
+		size_t pos = pushPos.load(std::memory_order_relaxed);
+		Slot *slot;
+		while (true) {
+			slot = &slots[pos & (Capacity - 1)];
+			const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+			const auto lag = static_cast<std::ptrdiff_t>(sequence - pos);
+			if (lag == 0) {
+				if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			} else if (lag < 0) {
+				return false;
+			} else {
+				pos = pushPos.load(std::memory_order_relaxed);
+			}
+		}
+		fill(slot->value);
+		slot->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * @brief Passes the oldest element to consume, then frees its slot. Must only be called from one thread.
+	 * @return false if the oldest element is not ready yet or the queue is empty.
+	 */
+	template <typename F>
+	bool TryPop(F &&consume)
+	{
+		Slot &slot = slots[popPos & (Capacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != popPos + 1)
+			return false;
+		consume(slot.value);
+		slot.sequence.store(popPos + Capacity, std::memory_order_release);
+		popPos++;
+		return true;
+	}
+
+private:
+	struct Slot {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::array<Slot, Capacity> slots;
+	std::atomic<size_t> pushPos { 0 };
+	size_t popPos = 0;
+};
+
+} // namespace devilution
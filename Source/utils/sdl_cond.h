@@ -42,6 +42,16 @@ public:
 			ErrSdl();
 	}
 
+	/**
+	 * @brief Waits until signalled or until ms milliseconds have passed.
+	 */
+	void wait(SdlMutex &mutex, uint32_t ms)
+	{
+		int err = SDL_CondWaitTimeout(cond, mutex.get(), ms);
+		if (err < 0)
+			ErrSdl();
+	}
+
 private:
 	SDL_cond *cond;
 };
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SDL.h>
+
+#include "appfat.h"
+
+namespace devilution {
+
+/**
+ * RAII wrapper for SDL_sem.
+ */
+class SdlSem final {
+public:
+	SdlSem()
+	    : sem(SDL_CreateSemaphore(0))
+	{
+		if (sem == nullptr)
+			ErrSdl();
+	}
+
+	~SdlSem()
+	{
+		SDL_DestroySemaphore(sem);
+	}
+
+	SdlSem(const SdlSem &) = delete;
+	SdlSem(SdlSem &&) = delete;
+	SdlSem &operator=(const SdlSem &) = delete;
+	SdlSem &operator=(SdlSem &&) = delete;
+
+	void post()
+	{
+		int err = SDL_SemPost(sem);
+		if (err < 0)
+			ErrSdl();
+	}
+
+	void wait()
+	{
+		int err = SDL_SemWait(sem);
+		if (err < 0)
+			ErrSdl();
+	}
+
+private:
+	SDL_sem *sem;
+};
+
+} // namespace devilution
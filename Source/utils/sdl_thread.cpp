@@ -1,5 +1,8 @@
 #include "utils/sdl_thread.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace devilution {
 
 int SDLCALL SdlThread::ThreadTranslate(void *ptr)
@@ -17,4 +20,16 @@ void SdlThread::ThreadDeleter(SDL_Thread *thread)
 		app_fatal("Joinable thread destroyed");
 }
 
+void RunOnThreads(int(SDLCALL *handler)(void *), void *data, int maxThreads)
+{
+	const int threadCount = std::min(SDL_GetCPUCount(), maxThreads);
+	std::vector<SdlThread> threads;
+	threads.reserve(std::max(threadCount - 1, 0));
+	for (int i = 1; i < threadCount; i++)
+		threads.emplace_back(handler, data);
+	handler(data);
+	for (SdlThread &thread : threads)
+		thread.join();
+}
+
 } // namespace devilution
@@ -63,4 +63,11 @@ public:
 	}
 };
 
+/**
+ * @brief Runs handler(data) on up to maxThreads threads, the calling one included, and waits for all of them.
+ *
+ * The handlers share the work through data, so each one keeps taking items until there are none left.
+ */
+void RunOnThreads(int(SDLCALL *handler)(void *), void *data, int maxThreads);
+
 } // namespace devilution
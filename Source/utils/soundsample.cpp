@@ -113,10 +113,11 @@ void SoundSample::Stop()
 		stream_->stop();
 }
 
-int SoundSample::SetChunkStream(std::string filePath)
+int SoundSample::SetChunkStream(std::string filePath, SDL_RWops *handle)
 {
 	file_path_ = std::move(filePath);
-	SDL_RWops *handle = OpenAsset(file_path_.c_str(), /*threadsafe=*/true);
+	if (handle == nullptr)
+		handle = OpenAsset(file_path_.c_str(), /*threadsafe=*/true);
 	if (handle == nullptr) {
 		LogError(LogCategory::Audio, "OpenAsset failed (from SoundSample::SetChunkStream): {}", SDL_GetError());
 		return -1;
@@ -3,8 +3,10 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 
 #include <Aulib/Stream.h>
+#include <SDL.h>
 
 #include "utils/stdcompat/shared_ptr_array.hpp"
 
@@ -29,7 +31,13 @@ public:
 	bool IsPlaying();
 	void Play(int logSoundVolume, int logUserVolume, int logPan);
 	void Stop();
-	int SetChunkStream(std::string filePath);
+	/**
+	 * @brief Streams the sample from the given asset.
+	 * @param filePath Asset path, also used to open further streams when duplicating
+	 * @param handle Thread-safe handle to the asset if already opened, ownership is taken
+	 * @return 0 on success, -1 otherwise
+	 */
+	int SetChunkStream(std::string filePath, SDL_RWops *handle = nullptr);
 
 	void SetFinishCallback(Aulib::Stream::Callback &&callback)
 	{
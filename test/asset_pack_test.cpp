@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mpq/asset_pack.hpp"
+#include "tmp_path.h"
+
+using namespace devilution;
+
+namespace {
+
+std::vector<byte> MakeContents(std::size_t size, uint8_t seed)
+{
+	std::vector<byte> contents(size);
+	for (std::size_t i = 0; i < size; i++)
+		contents[i] = static_cast<byte>(seed + i * 7);
+	return contents;
+}
+
+TEST(AssetPack, RoundTrip)
+{
+	const std::string path = GetTmpPathName(AssetPackExtension);
+	std::vector<AssetPack::FileHash> hashes;
+	std::vector<std::vector<byte>> files;
+	for (uint32_t i = 0; i < 100; i++) {
+		hashes.push_back({ i * 2654435761U, i * 40503U + 1, i });
+		files.push_back(MakeContents(i * 97, static_cast<uint8_t>(i)));
+	}
+
+	AssetPackWriter writer;
+	ASSERT_TRUE(writer.Open(path.c_str()));
+	for (std::size_t i = 0; i < files.size(); i++)
+		ASSERT_TRUE(writer.AddFile(hashes[i], files[i].data(), files[i].size()));
+	EXPECT_FALSE(writer.AddFile(hashes[0], files[0].data(), files[0].size()));
+	ASSERT_TRUE(writer.Finish({ 0x123456789, -42 }));
+
+	int32_t error;
+	std::optional<AssetPack> pack = AssetPack::Open(path.c_str(), error);
+	ASSERT_TRUE(pack);
+	EXPECT_EQ(error, 0);
+	EXPECT_EQ(pack->GetSource().size, 0x123456789);
+	EXPECT_EQ(pack->GetSource().modified, -42);
+
+	for (std::size_t i = 0; i < files.size(); i++) {
+		uint32_t fileNumber;
+		ASSERT_TRUE(pack->GetFileNumber(hashes[i], fileNumber));
+		std::size_t size = 0;
+		std::unique_ptr<byte[]> contents = pack->ReadFile(fileNumber, size, error);
+		ASSERT_EQ(error, 0);
+		ASSERT_EQ(size, files[i].size());
+		EXPECT_EQ(std::memcmp(contents.get(), files[i].data(), size), 0);
+	}
+
+	uint32_t fileNumber;
+	EXPECT_FALSE(pack->GetFileNumber({ 1, 2, 3 }, fileNumber));
+}
+
+TEST(AssetPack, ReadBlock)
+{
+	const std::string path = GetTmpPathName(AssetPackExtension);
+	const AssetPack::FileHash hash { 1, 2, 3 };
+	const std::vector<byte> file = MakeContents(AssetPackPageSize * 2 + 100, 5);
+
+	AssetPackWriter writer;
+	ASSERT_TRUE(writer.Open(path.c_str()));
+	ASSERT_TRUE(writer.AddFile(hash, file.data(), file.size()));
+	ASSERT_TRUE(writer.Finish({ 0, 0 }));
+
+	int32_t error;
+	std::optional<AssetPack> pack = AssetPack::Open(path.c_str(), error);
+	ASSERT_TRUE(pack);
+	uint32_t fileNumber;
+	ASSERT_TRUE(pack->GetFileNumber(hash, fileNumber));
+	ASSERT_EQ(pack->GetNumBlocks(fileNumber), 3);
+	EXPECT_EQ(pack->GetBlockSize(fileNumber, 0), AssetPackPageSize);
+	EXPECT_EQ(pack->GetBlockSize(fileNumber, 2), 100);
+
+	std::vector<uint8_t> block(AssetPackPageSize);
+	ASSERT_EQ(pack->ReadBlock(fileNumber, 2, block.data(), AssetPackPageSize), 0);
+	EXPECT_EQ(std::memcmp(block.data(), &file[AssetPackPageSize * 2], 100), 0);
+}
+
+TEST(AssetPack, MissingFile)
+{
+	int32_t error;
+	EXPECT_FALSE(AssetPack::Open("this-file-should-not-exist.dvp", error));
+	EXPECT_EQ(error, 0);
+}
+
+} // namespace
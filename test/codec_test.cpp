@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
+#include <vector>
 
 #include "codec.h"
+#include "picosha2.h"
 
 using namespace devilution;
 
@@ -13,3 +15,50 @@ TEST(Codec, codec_get_encoded_len_eq)
 {
 	EXPECT_EQ(codec_get_encoded_len(128), 136);
 }
+
+TEST(Codec, codec_encode_known_answer)
+{
+	constexpr size_t Size = 200;
+	std::vector<byte> data(codec_get_encoded_len(Size));
+	for (size_t i = 0; i < Size; i++)
+		data[i] = static_cast<byte>(i * 7);
+
+	codec_encode(data.data(), Size, data.size(), "xrgyrkj1");
+	std::vector<unsigned char> digest(picosha2::k_digest_size);
+	picosha2::hash256(reinterpret_cast<unsigned char *>(data.data()), reinterpret_cast<unsigned char *>(data.data() + data.size()), digest.begin(), digest.end());
+	EXPECT_EQ(picosha2::bytes_to_hex_string(digest.begin(), digest.end()), "bf8c5836336d426b0df14d87b2ffbe40f3132b9cfedc7f26d872d2fd90c81130");
+
+	ASSERT_EQ(codec_decode(data.data(), data.size(), "xrgyrkj1"), Size);
+	for (size_t i = 0; i < Size; i++)
+		EXPECT_EQ(data[i], static_cast<byte>(i * 7));
+}
+
+TEST(Codec, CodecDecoder_in_pieces)
+{
+	constexpr size_t Size = 300;
+	std::vector<byte> data(codec_get_encoded_len(Size));
+	for (size_t i = 0; i < Size; i++)
+		data[i] = static_cast<byte>(i * 13);
+	codec_encode(data.data(), Size, data.size(), "xrgyrkj1");
+
+	const size_t payload = data.size() - CodecSignatureSize;
+	CodecDecoder decoder("xrgyrkj1");
+	decoder.Decode(data.data(), BlockSize);
+	EXPECT_EQ(data[BlockSize - 1], static_cast<byte>((BlockSize - 1) * 13));
+	decoder.Decode(data.data() + BlockSize, payload - BlockSize);
+	ASSERT_EQ(decoder.Finish(data.data() + payload, payload), Size);
+	for (size_t i = 0; i < Size; i++)
+		EXPECT_EQ(data[i], static_cast<byte>(i * 13));
+}
+
+TEST(Codec, CodecDecoder_wrong_password)
+{
+	constexpr size_t Size = 100;
+	std::vector<byte> data(codec_get_encoded_len(Size));
+	codec_encode(data.data(), Size, data.size(), "xrgyrkj1");
+
+	const size_t payload = data.size() - CodecSignatureSize;
+	CodecDecoder decoder("szqnlsk1");
+	decoder.Decode(data.data(), payload);
+	EXPECT_EQ(decoder.Finish(data.data() + payload, payload), 0);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "utils/compression.hpp"
+
+namespace devilution {
+namespace {
+
+std::vector<byte> RoundTrip(const std::vector<byte> &data)
+{
+	std::vector<byte> compressed(data.size() + data.size() / 255 + 16);
+	const uint32_t compressedSize = LzCompress(data.data(), data.size(), compressed.data(), compressed.size());
+	EXPECT_NE(compressedSize, 0);
+
+	std::vector<byte> decompressed(data.size());
+	uint32_t decompressedSize = 0;
+	EXPECT_TRUE(LzDecompress(compressed.data(), compressedSize, decompressed.data(), decompressed.size(), decompressedSize));
+	decompressed.resize(decompressedSize);
+	return decompressed;
+}
+
+std::vector<byte> ZeroRunRoundTrip(const std::vector<byte> &data)
+{
+	std::vector<byte> encoded(data.size() * 2 + 16);
+	const uint32_t encodedSize = ZeroRunEncode(data.data(), data.size(), encoded.data(), encoded.size());
+	EXPECT_TRUE(data.empty() || encodedSize != 0);
+
+	std::vector<byte> decoded(data.size());
+	EXPECT_TRUE(ZeroRunDecode(encoded.data(), encodedSize, decoded.data(), decoded.size()));
+	return decoded;
+}
+
+} // namespace
+
+TEST(CompressionTest, LzRoundTrip)
+{
+	std::vector<byte> empty;
+	EXPECT_EQ(RoundTrip(empty), empty);
+
+	// Mostly unused slots, like the delta of a level nobody has visited yet
+	std::vector<byte> level(20000, byte { 0xFF });
+	for (size_t i = 0; i < level.size(); i += 97)
+		level[i] = static_cast<byte>(i);
+	EXPECT_EQ(RoundTrip(level), level);
+
+	std::vector<byte> noise(5000);
+	uint32_t seed = 1;
+	for (byte &b : noise) {
+		seed = seed * 22695477 + 1;
+		b = static_cast<byte>(seed >> 16);
+	}
+	EXPECT_EQ(RoundTrip(noise), noise);
+}
+
+TEST(CompressionTest, LzInPlace)
+{
+	std::vector<byte> data(4096, byte { 0xFF });
+	const uint32_t compressedSize = CompressInPlace(CompressionCodec::Lz, data.data(), data.size());
+	EXPECT_LT(compressedSize, 64);
+	EXPECT_TRUE(DecompressInPlace(CompressionCodec::Lz, data.data(), compressedSize, data.size()));
+	EXPECT_EQ(data, std::vector<byte>(4096, byte { 0xFF }));
+}
+
+TEST(CompressionTest, LzRejectsCorruptData)
+{
+	std::vector<byte> data(1000, byte { 0xFF });
+	std::vector<byte> compressed(64);
+	const uint32_t compressedSize = LzCompress(data.data(), data.size(), compressed.data(), compressed.size());
+	ASSERT_NE(compressedSize, 0);
+
+	std::vector<byte> out(data.size());
+	uint32_t outSize;
+	EXPECT_FALSE(LzDecompress(compressed.data(), compressedSize, out.data(), out.size() - 1, outSize));
+	EXPECT_FALSE(LzDecompress(compressed.data(), compressedSize - 1, out.data(), out.size(), outSize));
+	compressed[2] = byte { 0xFF }; // Offset pointing before the start of the output
+	EXPECT_FALSE(LzDecompress(compressed.data(), compressedSize, out.data(), out.size(), outSize));
+}
+
+TEST(CompressionTest, ZeroRunRoundTrip)
+{
+	std::vector<byte> empty;
+	EXPECT_EQ(ZeroRunRoundTrip(empty), empty);
+
+	// A dungeon grid with a few occupied tiles
+	std::vector<byte> grid(112 * 112);
+	for (size_t i = 3; i < grid.size(); i += 301)
+		grid[i] = static_cast<byte>(i);
+	grid[grid.size() - 1] = byte { 7 };
+	EXPECT_EQ(ZeroRunRoundTrip(grid), grid);
+
+	std::vector<byte> encoded(grid.size());
+	EXPECT_LT(ZeroRunEncode(grid.data(), grid.size(), encoded.data(), encoded.size()), 200);
+
+	// Dense data with single zeros in between
+	std::vector<byte> dense(1000);
+	for (size_t i = 0; i < dense.size(); i++)
+		dense[i] = static_cast<byte>(i % 5 == 0 ? 0 : i);
+	EXPECT_EQ(ZeroRunRoundTrip(dense), dense);
+
+	std::vector<byte> zeros(5000);
+	EXPECT_EQ(ZeroRunRoundTrip(zeros), zeros);
+}
+
+TEST(CompressionTest, ZeroRunRejectsCorruptData)
+{
+	std::vector<byte> data(300);
+	data[200] = byte { 1 };
+	std::vector<byte> encoded(64);
+	const uint32_t encodedSize = ZeroRunEncode(data.data(), data.size(), encoded.data(), encoded.size());
+	ASSERT_NE(encodedSize, 0);
+	EXPECT_EQ(ZeroRunEncode(data.data(), data.size(), encoded.data(), 2), 0);
+
+	std::vector<byte> out(data.size());
+	EXPECT_FALSE(ZeroRunDecode(encoded.data(), encodedSize, out.data(), out.size() - 1));
+	EXPECT_FALSE(ZeroRunDecode(encoded.data(), encodedSize, out.data(), out.size() + 1));
+	EXPECT_FALSE(ZeroRunDecode(encoded.data(), encodedSize - 1, out.data(), out.size()));
+}
+
+} // namespace devilution
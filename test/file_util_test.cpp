@@ -3,6 +3,7 @@
 #include <iostream>
 #include <fstream>
 
+#include "tmp_path.h"
 #include "utils/file_util.h"
 
 using namespace devilution;
@@ -20,17 +21,6 @@ void WriteDummyFile(const char *name, std::uintmax_t size)
 	}
 }
 
-std::string GetTmpPathName(const char *suffix = ".tmp")
-{
-	const auto *current_test = ::testing::UnitTest::GetInstance()->current_test_info();
-	std::string result = "Test_";
-	result.append(current_test->test_case_name());
-	result += '_';
-	result.append(current_test->name());
-	result.append(suffix);
-	return result;
-}
-
 TEST(FileUtil, GetFileSize)
 {
 	const std::string path = GetTmpPathName();
@@ -41,6 +31,21 @@ TEST(FileUtil, GetFileSize)
 	EXPECT_EQ(result, 42);
 }
 
+TEST(FileUtil, GetFileStatus)
+{
+	const std::string path = GetTmpPathName();
+	std::cout << path << std::endl;
+	WriteDummyFile(path.c_str(), 42);
+	std::uintmax_t size;
+	std::int64_t modificationTime;
+	ASSERT_TRUE(GetFileStatus(path.c_str(), &size, &modificationTime));
+	EXPECT_EQ(size, 42);
+	std::int64_t sameModificationTime;
+	ASSERT_TRUE(GetFileStatus(path.c_str(), &size, &sameModificationTime));
+	EXPECT_EQ(sameModificationTime, modificationTime);
+	EXPECT_FALSE(GetFileStatus("this-file-should-not-exist", &size, &modificationTime));
+}
+
 TEST(FileUtil, FileExists)
 {
 	EXPECT_FALSE(FileExists("this-file-should-not-exist"));
@@ -63,4 +68,22 @@ TEST(FileUtil, ResizeFile)
 	EXPECT_EQ(size, 30);
 }
 
+TEST(FileUtil, SyncFile)
+{
+	const std::string path = GetTmpPathName();
+	std::cout << path << std::endl;
+	WriteDummyFile(path.c_str(), 42);
+	EXPECT_TRUE(SyncFile(path.c_str()));
+	EXPECT_FALSE(SyncFile("this-file-should-not-exist"));
+}
+
+TEST(FileUtil, SyncParentDirectory)
+{
+	const std::string path = GetTmpPathName();
+	std::cout << path << std::endl;
+	WriteDummyFile(path.c_str(), 42);
+	EXPECT_TRUE(SyncParentDirectory(path.c_str()));
+	EXPECT_TRUE(SyncParentDirectory(("./" + path).c_str()));
+}
+
 } // namespace
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "herocache.h"
+#include "tmp_path.h"
+#include "utils/file_util.h"
+
+using namespace devilution;
+
+namespace {
+
+HeroCacheEntry MakeEntry(uint32_t saveNumber, const char *name)
+{
+	HeroCacheEntry entry {};
+	entry.saveNumber = saveNumber;
+	entry.archiveSize = 0x100000000 + saveNumber;
+	entry.archiveModified = -1234567890123;
+	strcpy(entry.heroName, name);
+	entry.listed = true;
+	entry.heroInfo.saveNumber = saveNumber;
+	strcpy(entry.heroInfo.name, name);
+	entry.heroInfo.level = 30;
+	entry.heroInfo.heroclass = HeroClass::Sorcerer;
+	entry.heroInfo.herorank = 2;
+	entry.heroInfo.strength = 45;
+	entry.heroInfo.magic = 250;
+	entry.heroInfo.dexterity = 85;
+	entry.heroInfo.vitality = 80;
+	entry.heroInfo.hassaved = true;
+	return entry;
+}
+
+} // namespace
+
+TEST(HeroCache, RoundTrip)
+{
+	const std::string path = GetTmpPathName(".cache");
+	std::vector<HeroCacheEntry> entries { MakeEntry(0, "Cain"), MakeEntry(7, "Gillian") };
+	entries[1].listed = false;
+	entries[1].heroInfo.spawned = true;
+	WriteHeroCache(path.c_str(), entries);
+
+	const std::vector<HeroCacheEntry> read = ReadHeroCache(path.c_str());
+	ASSERT_EQ(read.size(), entries.size());
+	for (size_t i = 0; i < read.size(); i++) {
+		EXPECT_EQ(read[i].saveNumber, entries[i].saveNumber);
+		EXPECT_EQ(read[i].archiveSize, entries[i].archiveSize);
+		EXPECT_EQ(read[i].archiveModified, entries[i].archiveModified);
+		EXPECT_STREQ(read[i].heroName, entries[i].heroName);
+		EXPECT_EQ(read[i].listed, entries[i].listed);
+		const _uiheroinfo &heroInfo = read[i].heroInfo;
+		EXPECT_EQ(heroInfo.saveNumber, entries[i].saveNumber);
+		EXPECT_STREQ(heroInfo.name, entries[i].heroInfo.name);
+		EXPECT_EQ(heroInfo.level, 30);
+		EXPECT_EQ(heroInfo.heroclass, HeroClass::Sorcerer);
+		EXPECT_EQ(heroInfo.herorank, 2);
+		EXPECT_EQ(heroInfo.strength, 45);
+		EXPECT_EQ(heroInfo.magic, 250);
+		EXPECT_EQ(heroInfo.dexterity, 85);
+		EXPECT_EQ(heroInfo.vitality, 80);
+		EXPECT_TRUE(heroInfo.hassaved);
+		EXPECT_EQ(heroInfo.spawned, entries[i].heroInfo.spawned);
+	}
+}
+
+TEST(HeroCache, DamagedCacheIsIgnored)
+{
+	const std::string path = GetTmpPathName(".cache");
+	EXPECT_TRUE(ReadHeroCache(path.c_str()).empty());
+
+	WriteHeroCache(path.c_str(), { MakeEntry(0, "Cain") });
+	std::uintmax_t size;
+	ASSERT_TRUE(GetFileSize(path.c_str(), &size));
+	ASSERT_TRUE(ResizeFile(path.c_str(), size - 1));
+	EXPECT_TRUE(ReadHeroCache(path.c_str()).empty());
+}
+
+TEST(HeroCache, ChangedArchiveIsNotFound)
+{
+	const std::vector<HeroCacheEntry> entries { MakeEntry(0, "Cain"), MakeEntry(7, "Gillian") };
+	const HeroCacheEntry &entry = entries[1];
+
+	EXPECT_EQ(FindHeroCacheEntry(entries, 7, entry.archiveSize, entry.archiveModified), &entries[1]);
+	EXPECT_EQ(FindHeroCacheEntry(entries, 7, entry.archiveSize + 1, entry.archiveModified), nullptr);
+	EXPECT_EQ(FindHeroCacheEntry(entries, 7, entry.archiveSize, entry.archiveModified + 1), nullptr);
+	EXPECT_EQ(FindHeroCacheEntry(entries, 3, entry.archiveSize, entry.archiveModified), nullptr);
+}
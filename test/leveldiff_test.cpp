@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "leveldiff.h"
+
+namespace devilution {
+namespace {
+
+std::vector<byte> Pattern(size_t size)
+{
+	std::vector<byte> data(size);
+	for (size_t i = 0; i < size; i++)
+		data[i] = static_cast<byte>(i * 13);
+	return data;
+}
+
+std::vector<LevelPatch> Diff(const std::vector<byte> &keyframe, const std::vector<byte> &image)
+{
+	return DiffLevelImage(keyframe.data(), keyframe.size(), image.data(), image.size());
+}
+
+/** @brief Rebuilds image from keyframe and the patches the way LoadLevel does. */
+std::vector<byte> Apply(const std::vector<byte> &keyframe, const std::vector<byte> &image, const std::vector<LevelPatch> &patches)
+{
+	std::vector<byte> result(keyframe.begin(), keyframe.begin() + std::min(keyframe.size(), image.size()));
+	result.resize(image.size());
+	for (const LevelPatch &patch : patches) {
+		EXPECT_LE(patch.offset + patch.length, image.size());
+		std::copy(image.begin() + patch.offset, image.begin() + patch.offset + patch.length, result.begin() + patch.offset);
+	}
+	return result;
+}
+
+} // namespace
+
+TEST(LevelDiffTest, Identical)
+{
+	std::vector<byte> data = Pattern(1000);
+	EXPECT_TRUE(Diff(data, data).empty());
+	EXPECT_TRUE(Diff({}, {}).empty());
+}
+
+TEST(LevelDiffTest, SeparateChanges)
+{
+	std::vector<byte> keyframe = Pattern(1000);
+	std::vector<byte> image = keyframe;
+	image[10] = byte { 0xFF };
+	image[11] = byte { 0xFF };
+	image[500] = byte { 0xFF };
+	image[999] = byte { 0xFF };
+
+	std::vector<LevelPatch> patches = Diff(keyframe, image);
+	ASSERT_EQ(patches.size(), 3);
+	EXPECT_EQ(patches[0].offset, 10);
+	EXPECT_EQ(patches[0].length, 2);
+	EXPECT_EQ(patches[1].offset, 500);
+	EXPECT_EQ(patches[1].length, 1);
+	EXPECT_EQ(patches[2].offset, 999);
+	EXPECT_EQ(patches[2].length, 1);
+	EXPECT_EQ(Apply(keyframe, image, patches), image);
+}
+
+TEST(LevelDiffTest, NearbyChangesAreMerged)
+{
+	std::vector<byte> keyframe = Pattern(100);
+	std::vector<byte> image = keyframe;
+	image[20] = byte { 0xFF };
+	image[24] = byte { 0xFF };
+
+	std::vector<LevelPatch> patches = Diff(keyframe, image);
+	ASSERT_EQ(patches.size(), 1);
+	EXPECT_EQ(patches[0].offset, 20);
+	EXPECT_EQ(patches[0].length, 5);
+	EXPECT_EQ(Apply(keyframe, image, patches), image);
+}
+
+TEST(LevelDiffTest, SizeChanges)
+{
+	std::vector<byte> keyframe = Pattern(100);
+
+	std::vector<byte> longer = Pattern(150);
+	std::vector<LevelPatch> patches = Diff(keyframe, longer);
+	ASSERT_EQ(patches.size(), 1);
+	EXPECT_EQ(patches[0].offset, 100);
+	EXPECT_EQ(patches[0].length, 50);
+	EXPECT_EQ(Apply(keyframe, longer, patches), longer);
+
+	std::vector<byte> shorter = Pattern(60);
+	EXPECT_TRUE(Diff(keyframe, shorter).empty());
+	EXPECT_EQ(Apply(keyframe, shorter, {}), shorter);
+}
+
+TEST(LevelDiffTest, HashDependsOnContent)
+{
+	std::vector<byte> data = Pattern(100);
+	const uint32_t hash = HashLevelImage(data.data(), data.size());
+	EXPECT_EQ(hash, HashLevelImage(data.data(), data.size()));
+	data[50] = byte { 0xFF };
+	EXPECT_NE(hash, HashLevelImage(data.data(), data.size()));
+}
+
+} // namespace devilution
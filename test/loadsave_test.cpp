@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "lighting.h"
+#include "loadsave.h"
+#include "missiles.h"
+#include "monster.h"
+#include "objects.h"
+#include "pack.h"
+#include "player.h"
+
+#include "picosha2.h"
+
+using namespace devilution;
+
+namespace {
+
+/*
+ * The digests below were taken from the save code as it was before the records were described by layouts, so
+ * they pin the format that existing save games use. A change to them breaks loading those games.
+ */
+
+std::string Digest(const std::vector<byte> &record)
+{
+	const auto *data = reinterpret_cast<const unsigned char *>(record.data());
+	std::vector<unsigned char> digest(picosha2::k_digest_size);
+	picosha2::hash256(data, data + record.size(), digest.begin(), digest.end());
+	return picosha2::bytes_to_hex_string(digest.begin(), digest.end());
+}
+
+/** @brief Bytes that differ from their neighbours, so a field that is read from the wrong offset shows up. */
+std::vector<byte> PatternRecord(size_t size)
+{
+	std::vector<byte> record(size);
+	for (size_t i = 0; i < size; i++) {
+		// Keeps MFLAG_BERSERK clear, loading a berserk monster adds a light to the level
+		record[i] = static_cast<byte>(((i * 37) + 11) & ~0x08);
+	}
+	return record;
+}
+
+void SetGame(bool hellfire)
+{
+	gbIsHellfire = hellfire;
+	gbIsHellfireSaveGame = hellfire;
+	gbIsSpawn = false;
+	gbIsMultiplayer = false;
+	giNumberOfLevels = hellfire ? 25 : 17;
+}
+
+void PackTestItem(ItemPack &item, uint16_t idx, uint16_t createInfo, uint32_t seed, uint8_t durability)
+{
+	item.idx = idx;
+	item.iCreateInfo = createInfo;
+	item.bId = 1 + 2 * ITEM_QUALITY_MAGIC;
+	item.bDur = durability;
+	item.bMDur = durability;
+	item.iSeed = seed;
+}
+
+Player &CreateTestPlayer(bool hellfire)
+{
+	PlayerPack pack;
+	memset(&pack, 0, sizeof(pack));
+	pack.destAction = -1;
+	pack.px = 75;
+	pack.py = 68;
+	pack.targx = 75;
+	pack.targy = 68;
+	strcpy(pack.pName, "TestPlayer");
+	pack.pClass = static_cast<uint8_t>(HeroClass::Rogue);
+	pack.pBaseStr = 55;
+	pack.pBaseMag = 70;
+	pack.pBaseDex = 250;
+	pack.pBaseVit = 80;
+	pack.pLevel = 50;
+	pack.pExperience = 1583495809;
+	pack.pGold = 1234;
+	pack.pHPBase = 12864;
+	pack.pMaxHPBase = 12864;
+	pack.pManaBase = 11104;
+	pack.pMaxManaBase = 11104;
+	pack.pMemSpells = 0x1F000F0F;
+	pack.pDiabloKillLevel = 3;
+	pack.bIsHellfire = hellfire ? 1 : 0;
+	for (ItemPack &item : pack.InvBody)
+		item.idx = -1;
+	for (ItemPack &item : pack.InvList)
+		item.idx = -1;
+	for (ItemPack &item : pack.SpdList)
+		item.idx = -1;
+	PackTestItem(pack.InvBody[INVLOC_HAND_LEFT], 145, 0x0814, 0x449D8992, 60);
+	PackTestItem(pack.InvBody[INVLOC_CHEST], 70, 0xDE, 0x63AAC49B, 90);
+	PackTestItem(pack.InvBody[INVLOC_RING_LEFT], 153, 0xDE, 0x5B41AFA8, 0);
+	PackTestItem(pack.InvList[0], 122, 0x081E, 0x680FAC02, 60);
+	pack.InvGrid[20] = 1;
+	pack.InvGrid[10] = -1;
+	pack.InvGrid[0] = -1;
+	pack._pNumInv = 1;
+
+	// The player's vision id is part of the record
+	InitVision();
+	MyPlayerId = 0;
+	MyPlayer = &Players[MyPlayerId];
+	*MyPlayer = {};
+	UnPackPlayer(&pack, *MyPlayer, false);
+	return *MyPlayer;
+}
+
+TEST(LoadSave, ItemRecord)
+{
+	SetGame(false);
+	const Item &bow = CreateTestPlayer(false).InvBody[INVLOC_HAND_LEFT];
+
+	const std::vector<byte> record = SaveItemRecord(bow);
+	EXPECT_EQ(record.size(), 368);
+	EXPECT_EQ(Digest(record), "5428008482319e468ae6b4e99634cc9f77dcdcd461f674bebe6986bd1bfd51a6");
+
+	Item item {};
+	LoadItemRecord(record, item);
+	EXPECT_EQ(item._iSeed, bow._iSeed);
+	EXPECT_EQ(SaveItemRecord(item), record);
+}
+
+TEST(LoadSave, HellfireItemRecord)
+{
+	SetGame(true);
+	const Item &bow = CreateTestPlayer(true).InvBody[INVLOC_HAND_LEFT];
+
+	const std::vector<byte> record = SaveItemRecord(bow);
+	EXPECT_EQ(record.size(), 372);
+	EXPECT_EQ(Digest(record), "6d1dcbfc1433aaba6c3d7a2393e8352768ca0b3b57b32b235658308179dafc26");
+
+	Item item {};
+	LoadItemRecord(record, item);
+	EXPECT_EQ(SaveItemRecord(item), record);
+}
+
+TEST(LoadSave, PlayerRecord)
+{
+	SetGame(false);
+	const std::vector<byte> record = SavePlayerRecord(CreateTestPlayer(false));
+	EXPECT_EQ(record.size(), 21680);
+	EXPECT_EQ(Digest(record), "f6824f5ef221daf13697bb470c0ab043692c6d5d41238b7418928b4eca5762d7");
+
+	// Loading recalculates the item bonuses and fills in what the game did not store, after that the record is stable
+	Player &player = Players[1];
+	player = {};
+	LoadPlayerRecord(record, player);
+	EXPECT_STREQ(player._pName, "TestPlayer");
+	const std::vector<byte> loaded = SavePlayerRecord(player);
+	EXPECT_EQ(Digest(loaded), "e92bc1610a481514a76aa039c6171200cd6924e0ed9bf108456d7f061ec9ec28");
+
+	player = {};
+	LoadPlayerRecord(loaded, player);
+	EXPECT_EQ(SavePlayerRecord(player), loaded);
+}
+
+TEST(LoadSave, HellfirePlayerRecord)
+{
+	SetGame(true);
+	const std::vector<byte> record = SavePlayerRecord(CreateTestPlayer(true));
+	EXPECT_EQ(record.size(), 21920);
+	EXPECT_EQ(Digest(record), "e94cbc8468012a7c7f4499bc96b6a3b6b47c75ed90c30fe53854f6ed82f1b6c9");
+
+	// Loading recalculates the item bonuses and fills in what the game did not store, after that the record is stable
+	Player &player = Players[1];
+	player = {};
+	LoadPlayerRecord(record, player);
+	const std::vector<byte> loaded = SavePlayerRecord(player);
+	EXPECT_EQ(Digest(loaded), "7b144081ea6794fe1a4174c1edc6a735a7ca503439294812a3c09245da12c568");
+
+	player = {};
+	LoadPlayerRecord(loaded, player);
+	EXPECT_EQ(SavePlayerRecord(player), loaded);
+}
+
+TEST(LoadSave, MonsterRecord)
+{
+	Monster empty {};
+	const size_t size = SaveMonsterRecord(empty).size();
+	EXPECT_EQ(size, 216);
+
+	Monster monster {};
+	LoadMonsterRecord(PatternRecord(size), monster);
+	const std::vector<byte> record = SaveMonsterRecord(monster);
+	EXPECT_EQ(Digest(record), "d30a7426adb19d22c172c451c683170abd1d6f188594318ebf7a729ac38249c9");
+
+	Monster reloaded {};
+	LoadMonsterRecord(record, reloaded);
+	EXPECT_EQ(SaveMonsterRecord(reloaded), record);
+}
+
+TEST(LoadSave, MissileRecord)
+{
+	Missile empty {};
+	const size_t size = SaveMissileRecord(empty).size();
+	EXPECT_EQ(size, 176);
+
+	Missile missile {};
+	LoadMissileRecord(PatternRecord(size), missile);
+	const std::vector<byte> record = SaveMissileRecord(missile);
+	EXPECT_EQ(Digest(record), "f8f3c9e6ad16f31b66232c51cdc9b163323cb1027b9e2f078400eb0f2a71e583");
+
+	Missile reloaded {};
+	LoadMissileRecord(record, reloaded);
+	EXPECT_EQ(SaveMissileRecord(reloaded), record);
+}
+
+TEST(LoadSave, ObjectRecord)
+{
+	Object empty {};
+	const size_t size = SaveObjectRecord(empty).size();
+	EXPECT_EQ(size, 120);
+
+	Object object {};
+	LoadObjectRecord(PatternRecord(size), object);
+	const std::vector<byte> record = SaveObjectRecord(object);
+	EXPECT_EQ(Digest(record), "1e218ef0fbb6ca3b430246dc2f751c1330b8e86d91ce33af308c70923770a3ce");
+
+	Object reloaded {};
+	LoadObjectRecord(record, reloaded);
+	EXPECT_EQ(SaveObjectRecord(reloaded), record);
+}
+
+} // namespace
@@ -0,0 +1,310 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "encrypt.h"
+#include "mpq/mpq_reader.hpp"
+#include "mpq/mpq_writer.hpp"
+#include "tmp_path.h"
+#include "utils/endian.hpp"
+#include "utils/file_util.h"
+
+using namespace devilution;
+
+namespace {
+
+/** Entries in the hash table, and in the block table */
+constexpr size_t IndexEntries = 2048;
+
+/** Header, block table and hash table at the start of every save archive */
+constexpr size_t TablesSize = 104 + 2 * IndexEntries * 16;
+
+std::string GetTmpArchivePath()
+{
+	std::string path = GetTmpPathName(".mpq");
+	RemoveMpqSidecarFiles(path.c_str());
+	return path;
+}
+
+const byte *AsBytes(const char *text)
+{
+	return reinterpret_cast<const byte *>(text);
+}
+
+std::string ReadWholeFile(const std::string &path)
+{
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+void WriteWholeFile(const std::string &path, const std::string &contents)
+{
+	std::ofstream stream(path, std::ios::out | std::ios::trunc | std::ios::binary);
+	stream.write(contents.data(), contents.size());
+}
+
+void AppendLE32(std::string &out, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		out += static_cast<char>(value >> (i * 8));
+}
+
+/**
+ * @brief Commits "hero", then "game", and leaves the archive as if the game crashed halfway through
+ * writing the tables of the second commit.
+ * @param after The archive as the second commit left it
+ * @param journal The journal of the second commit
+ */
+void WriteTornCommit(const std::string &path, std::string &after, std::string &journal)
+{
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		ASSERT_TRUE(writer.WriteFile("hero", AsBytes("hero data"), 9));
+	}
+	const std::string before = ReadWholeFile(path);
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		ASSERT_TRUE(writer.WriteFile("game", AsBytes("game data"), 9));
+	}
+	after = ReadWholeFile(path);
+	ASSERT_GE(after.size(), TablesSize);
+
+	journal.clear();
+	AppendLE32(journal, LoadLE32("MPQJ"));
+	AppendLE32(journal, static_cast<uint32_t>(after.size()));
+	journal.append(after, 0, TablesSize);
+	AppendLE32(journal, MpqFileChecksum(AsBytes(journal.data()), journal.size()));
+	WriteWholeFile(path + ".journal", journal);
+	WriteWholeFile(path, after.substr(0, TablesSize / 2) + before.substr(TablesSize / 2, TablesSize - TablesSize / 2) + after.substr(TablesSize));
+}
+
+/** @brief The space of an archive as its committed block table describes it, by offset. */
+struct ArchiveSpace {
+	uint32_t fileSize = 0;
+	std::map<uint32_t, uint32_t> files;
+	std::map<uint32_t, uint32_t> free;
+};
+
+ArchiveSpace ReadArchiveSpace(const std::string &path)
+{
+	ArchiveSpace space;
+	_FILEHEADER header;
+	std::vector<_BLOCKENTRY> blocks(IndexEntries);
+	const uint32_t tableSize = IndexEntries * sizeof(_BLOCKENTRY);
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)) || !stream.read(reinterpret_cast<char *>(blocks.data()), tableSize))
+		return space;
+	space.fileSize = LoadLE32(reinterpret_cast<const uint8_t *>(&header.filesize));
+
+	Decrypt(reinterpret_cast<uint32_t *>(blocks.data()), tableSize, Hash("(block table)", 3));
+	for (const _BLOCKENTRY &block : blocks) {
+		if (block.flags != 0)
+			space.files.emplace(block.offset, block.sizealloc);
+		else if (block.offset != 0)
+			space.free.emplace(block.offset, block.sizealloc);
+	}
+	return space;
+}
+
+/** @brief Files and free space cover the archive without gaps, and free space is merged and never at the end. */
+void CheckArchiveSpace(const ArchiveSpace &space)
+{
+	std::map<uint32_t, std::pair<uint32_t, bool>> regions;
+	for (const auto &file : space.files)
+		regions.emplace(file.first, std::make_pair(file.second, false));
+	for (const auto &block : space.free)
+		ASSERT_TRUE(regions.emplace(block.first, std::make_pair(block.second, true)).second) << block.first;
+
+	uint32_t end = TablesSize;
+	bool previousFree = false;
+	for (const auto &region : regions) {
+		ASSERT_EQ(region.first, end);
+		const bool isFree = region.second.second;
+		ASSERT_FALSE(previousFree && isFree) << "unmerged free space at " << region.first;
+		end += region.second.first;
+		previousFree = isFree;
+	}
+	EXPECT_FALSE(previousFree) << "free space at the end of the file";
+	EXPECT_EQ(end, space.fileSize);
+}
+
+} // namespace
+
+TEST(MpqWriter, MpqFileChecksum)
+{
+	EXPECT_EQ(MpqFileChecksum(AsBytes(""), 0), 0x02CC5D05U);
+	EXPECT_EQ(MpqFileChecksum(AsBytes("abc"), 3), 0x32D153FFU);
+	const char *text = "Nobody can see the Black Road and nobody walks it";
+	EXPECT_NE(MpqFileChecksum(AsBytes(text), strlen(text)), MpqFileChecksum(AsBytes(text), strlen(text) - 1));
+}
+
+TEST(MpqWriter, ChecksumsSurviveClose)
+{
+	const std::string path = GetTmpArchivePath();
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		ASSERT_TRUE(writer.WriteFile("hero", AsBytes("hero data"), 9));
+		ASSERT_TRUE(writer.WriteFile("temp", AsBytes("level data"), 10));
+		writer.RenameFile("temp", "perm");
+	}
+	EXPECT_EQ(ReadMpqFileChecksum(path.c_str(), "hero"), MpqFileChecksum(AsBytes("hero data"), 9));
+	EXPECT_EQ(ReadMpqFileChecksum(path.c_str(), "perm"), MpqFileChecksum(AsBytes("level data"), 10));
+	EXPECT_EQ(ReadMpqFileChecksum(path.c_str(), "temp"), std::nullopt);
+	EXPECT_EQ(ReadWholeFile(path + ".journal"), "");
+}
+
+TEST(MpqWriter, UncommittedDataIsDropped)
+{
+	const std::string path = GetTmpArchivePath();
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		ASSERT_TRUE(writer.WriteFile("hero", AsBytes("hero data"), 9));
+	}
+	const std::string committed = ReadWholeFile(path);
+
+	// Data of a session that never got to write its tables
+	WriteWholeFile(path, committed + "interrupted");
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		EXPECT_TRUE(writer.HasFile("hero"));
+	}
+	EXPECT_EQ(ReadWholeFile(path), committed);
+}
+
+TEST(MpqWriter, InterruptedCommitIsReplayed)
+{
+	const std::string path = GetTmpArchivePath();
+	std::string after;
+	std::string journal;
+	ASSERT_NO_FATAL_FAILURE(WriteTornCommit(path, after, journal));
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		EXPECT_TRUE(writer.HasFile("hero"));
+		EXPECT_TRUE(writer.HasFile("game"));
+	}
+	EXPECT_EQ(ReadWholeFile(path), after);
+	EXPECT_EQ(ReadWholeFile(path + ".journal"), "");
+
+	// A journal that was itself cut short is dropped, the archive was not touched yet
+	WriteWholeFile(path + ".journal", journal.substr(0, journal.size() / 2));
+	{
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		EXPECT_TRUE(writer.HasFile("game"));
+	}
+	EXPECT_EQ(ReadWholeFile(path + ".journal"), "");
+}
+
+TEST(MpqWriter, InterruptedCommitIsReplayedForReaders)
+{
+	const std::string path = GetTmpArchivePath();
+	std::string after;
+	std::string journal;
+	ASSERT_NO_FATAL_FAILURE(WriteTornCommit(path, after, journal));
+
+	ReplayMpqJournal(path.c_str());
+	EXPECT_EQ(ReadWholeFile(path), after);
+	EXPECT_EQ(ReadWholeFile(path + ".journal"), "");
+
+	int32_t error;
+	std::optional<MpqArchive> archive = MpqArchive::Open(path.c_str(), error);
+	ASSERT_TRUE(archive);
+	for (const char *name : { "hero", "game" }) {
+		size_t size;
+		std::unique_ptr<byte[]> data = archive->ReadFile(name, size, error);
+		ASSERT_EQ(error, 0) << name;
+		EXPECT_EQ(std::string(reinterpret_cast<const char *>(data.get()), size), std::string(name) + " data");
+	}
+}
+
+TEST(MpqWriter, FreeSpaceIsReused)
+{
+	const std::string path = GetTmpArchivePath();
+	std::mt19937 random(1234);
+	const std::vector<byte> contents(4096);
+	std::vector<std::string> files;
+	int nextFile = 0;
+	int bestFits = 0;
+	int mergedWithBoth = 0;
+	int shrinks = 0;
+
+	// Every change is its own session, so the writer always starts from the free space in the block table
+	for (int i = 0; i < 1500; i++) {
+		const ArchiveSpace before = ReadArchiveSpace(path);
+		const bool write = files.size() < 20 || (files.size() < 200 && random() % 2 == 0);
+		MpqWriter writer;
+		ASSERT_TRUE(writer.Open(path.c_str()));
+		if (write) {
+			const uint32_t size = 1 + random() % contents.size();
+			files.push_back("file" + std::to_string(nextFile++));
+			ASSERT_TRUE(writer.WriteFile(files.back().c_str(), contents.data(), size, CompressionCodec::None));
+			ASSERT_TRUE(writer.Close());
+
+			// The smallest free block that fits, the lowest one of those, or else the end of the file
+			uint32_t expected = before.fileSize != 0 ? before.fileSize : TablesSize;
+			uint32_t expectedFit = std::numeric_limits<uint32_t>::max();
+			for (const auto &block : before.free) {
+				if (block.second >= size && block.second < expectedFit) {
+					expected = block.first;
+					expectedFit = block.second;
+				}
+			}
+			if (expectedFit != std::numeric_limits<uint32_t>::max())
+				bestFits++;
+			const ArchiveSpace after = ReadArchiveSpace(path);
+			const auto file = after.files.find(expected);
+			ASSERT_NE(file, after.files.end()) << i;
+			EXPECT_EQ(file->second, size);
+			ASSERT_NO_FATAL_FAILURE(CheckArchiveSpace(after));
+		} else {
+			const size_t index = random() % files.size();
+			ASSERT_TRUE(writer.HasFile(files[index].c_str()));
+			writer.RemoveHashEntry(files[index].c_str());
+			files.erase(files.begin() + index);
+			ASSERT_TRUE(writer.Close());
+
+			const ArchiveSpace after = ReadArchiveSpace(path);
+			ASSERT_NO_FATAL_FAILURE(CheckArchiveSpace(after));
+			ASSERT_EQ(after.files.size() + 1, before.files.size());
+			auto removed = before.files.begin();
+			while (after.files.count(removed->first) != 0)
+				++removed;
+			uint32_t offset = removed->first;
+			uint32_t end = offset + removed->second;
+			const auto next = before.free.find(end);
+			if (next != before.free.end())
+				end += next->second;
+			const auto prev = before.free.lower_bound(offset);
+			const bool prevFree = prev != before.free.begin() && std::prev(prev)->first + std::prev(prev)->second == offset;
+			if (prevFree)
+				offset = std::prev(prev)->first;
+
+			if (end == before.fileSize) {
+				EXPECT_EQ(after.fileSize, offset) << i;
+				shrinks++;
+			} else {
+				const auto merged = after.free.find(offset);
+				ASSERT_NE(merged, after.free.end()) << i;
+				EXPECT_EQ(merged->second, end - offset) << i;
+				if (prevFree && next != before.free.end())
+					mergedWithBoth++;
+			}
+		}
+	}
+
+	EXPECT_GT(bestFits, 0);
+	EXPECT_GT(mergedWithBoth, 0);
+	EXPECT_GT(shrinks, 0);
+}
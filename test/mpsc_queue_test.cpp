@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "utils/mpsc_queue.hpp"
+
+namespace devilution {
+
+TEST(MpscQueueTest, FirstInFirstOut)
+{
+	MpscQueue<int, 4> queue;
+	int value = 0;
+	EXPECT_FALSE(queue.TryPop([&](int &v) { value = v; }));
+
+	for (int i = 1; i <= 4; i++)
+		EXPECT_TRUE(queue.TryPush([&](int &v) { v = i; }));
+	EXPECT_FALSE(queue.TryPush([](int &v) { v = 5; }));
+
+	for (int i = 1; i <= 4; i++) {
+		EXPECT_TRUE(queue.TryPop([&](int &v) { value = v; }));
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_FALSE(queue.TryPop([&](int &v) { value = v; }));
+}
+
+TEST(MpscQueueTest, ReusesSlots)
+{
+	MpscQueue<std::vector<int>, 2> queue;
+	const int *first = nullptr;
+	queue.TryPush([](std::vector<int> &v) { v.assign(100, 1); });
+	queue.TryPop([&](std::vector<int> &v) { first = v.data(); });
+	queue.TryPush([](std::vector<int> &v) { v.assign(100, 2); });
+	queue.TryPop([](std::vector<int> &) {});
+
+	// Back in the first slot, whose buffer is big enough already
+	const int *third = nullptr;
+	queue.TryPush([](std::vector<int> &v) { v.assign(50, 3); });
+	queue.TryPop([&](std::vector<int> &v) {
+		EXPECT_EQ(v.size(), 50);
+		third = v.data();
+	});
+	EXPECT_EQ(third, first);
+}
+
+TEST(MpscQueueTest, ManyProducers)
+{
+	constexpr int Producers = 4;
+	constexpr int PerProducer = 2000;
+	MpscQueue<int, 64> queue;
+
+	std::vector<std::thread> threads;
+	for (int p = 0; p < Producers; p++) {
+		threads.emplace_back([&queue, p]() {
+			for (int i = 0; i < PerProducer; i++) {
+				while (!queue.TryPush([&](int &v) { v = p * PerProducer + i; }))
+					std::this_thread::yield();
+			}
+		});
+	}
+
+	std::vector<int> last(Producers, -1);
+	int received = 0;
+	while (received < Producers * PerProducer) {
+		const bool popped = queue.TryPop([&](int &v) {
+			const int producer = v / PerProducer;
+			// Each producer's values arrive in the order it pushed them
+			EXPECT_GT(v % PerProducer, last[producer]);
+			last[producer] = v % PerProducer;
+			received++;
+		});
+		if (!popped)
+			std::this_thread::yield();
+	}
+	for (std::thread &thread : threads)
+		thread.join();
+	EXPECT_FALSE(queue.TryPop([](int &) {}));
+}
+
+} // namespace devilution
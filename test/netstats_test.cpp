@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "netstats.h"
+
+using namespace devilution;
+
+namespace {
+
+constexpr const char *CaptureName = "Test_NetStats.dnc";
+
+TEST(NetStats, CaptureRoundTrip)
+{
+	const unsigned char message[] = { 0x01, 0x02, 0x03, 0xFF };
+	const unsigned char turn[] = { 0x10, 0x20, 0x30, 0x40 };
+
+	ASSERT_TRUE(netstats::StartCapture(CaptureName));
+	EXPECT_TRUE(netstats::IsCapturing());
+	netstats::Capture(netstats::CaptureRecordType::MessageReceived, 2, message, sizeof(message));
+	netstats::Capture(netstats::CaptureRecordType::TurnSent, -1, turn, sizeof(turn));
+	netstats::StopCapture();
+	EXPECT_FALSE(netstats::IsCapturing());
+
+	std::deque<netstats::CaptureRecord> records;
+	ASSERT_TRUE(netstats::LoadCapture(CaptureName, records));
+	ASSERT_EQ(records.size(), 2);
+
+	EXPECT_EQ(records[0].type, netstats::CaptureRecordType::MessageReceived);
+	EXPECT_EQ(records[0].player, 2);
+	ASSERT_EQ(records[0].data.size(), sizeof(message));
+	EXPECT_EQ(static_cast<unsigned char>(records[0].data[3]), 0xFF);
+
+	EXPECT_EQ(records[1].type, netstats::CaptureRecordType::TurnSent);
+	EXPECT_EQ(records[1].player, -1);
+	EXPECT_GE(records[1].time, records[0].time);
+
+	std::remove(CaptureName);
+}
+
+TEST(NetStats, RejectsTruncatedCapture)
+{
+	const unsigned char message[] = { 0x01, 0x02, 0x03, 0x04 };
+
+	ASSERT_TRUE(netstats::StartCapture(CaptureName));
+	netstats::Capture(netstats::CaptureRecordType::MessageSent, 1, message, sizeof(message));
+	netstats::StopCapture();
+
+	std::ifstream in(CaptureName, std::ios::binary);
+	std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	in.close();
+	std::ofstream out(CaptureName, std::ios::binary | std::ios::trunc);
+	out.write(contents.data(), contents.size() - 1);
+	out.close();
+
+	std::deque<netstats::CaptureRecord> records;
+	EXPECT_FALSE(netstats::LoadCapture(CaptureName, records));
+
+	std::remove(CaptureName);
+}
+
+TEST(NetStats, ReportListsCommands)
+{
+	netstats::Report();
+	netstats::CountCommand(netstats::Direction::Sent, 42, 100);
+	netstats::CountCommand(netstats::Direction::Received, 42, 50);
+	const std::string report = netstats::Report();
+	EXPECT_NE(report.find("CMD 42:"), std::string::npos);
+	EXPECT_EQ(netstats::Report().find("CMD 42:"), std::string::npos);
+}
+
+} // namespace
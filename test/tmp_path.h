@@ -0,0 +1,29 @@
+/**
+ * @file tmp_path.h
+ *
+ * Helpers for tests that write files.
+ */
+#pragma once
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "utils/file_util.h"
+
+/**
+ * @brief A file name unique to the running test, in the working directory.
+ *
+ * A file of that name left behind by an earlier run is removed.
+ */
+inline std::string GetTmpPathName(const char *suffix = ".tmp")
+{
+	const auto *current_test = ::testing::UnitTest::GetInstance()->current_test_info();
+	std::string result = "Test_";
+	result.append(current_test->test_case_name());
+	result += '_';
+	result.append(current_test->name());
+	result.append(suffix);
+	devilution::RemoveFile(result.c_str());
+	return result;
+}
@@ -346,10 +346,11 @@ TEST(Writehero, pfile_write_hero)
 	UnPackPlayer(&pks, Players[MyPlayerId], true);
 	AssertPlayer(Players[0]);
 	pfile_write_hero();
+	pfile_flush_writes();
 
 	std::ifstream f("multi_0.sv", std::ios::binary);
 	std::vector<unsigned char> s(picosha2::k_digest_size);
 	picosha2::hash256(f, s.begin(), s.end());
 	EXPECT_EQ(picosha2::bytes_to_hex_string(s.begin(), s.end()),
-	    "a79367caae6192d54703168d82e0316aa289b2a33251255fad8abe34889c1d3a");
+	    "d4f4c49f0cabbdd32f7621a1e97bfcf515481198f35298c9b562545010a8c3d4");
 }
@@ -0,0 +1,158 @@
+/**
+ * @file tools/asset_pack/main.cpp
+ *
+ * devilutionx-pack: converts an MPQ archive into a fast-loading asset pack.
+ *
+ * MPQ archives do not store file names and most entries are encrypted with a key
+ * derived from their name, so the files to convert are taken from a list file
+ * (one name per line, as used by other MPQ tools) and the archive's own `(listfile)`.
+ * If they do not name every file of the archive, no pack is written.
+ *
+ * Place the resulting pack next to the MPQ; the game prefers it over the MPQ for as long as
+ * the MPQ keeps the size and modification time it had when the pack was made.
+ */
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mpq/asset_pack.hpp"
+#include "mpq/mpq_reader.hpp"
+#include "utils/file_util.h"
+
+using namespace devilution;
+
+namespace {
+
+/** Archive metadata, which the game never reads */
+constexpr const char *InternalFiles[] = { "(listfile)", "(attributes)", "(signature)" };
+
+void AppendNames(std::istream &in, std::vector<std::string> &names)
+{
+	std::string line;
+	while (std::getline(in, line)) {
+		while (!line.empty() && (line.back() == '\r' || line.back() == '\n' || line.back() == ';'))
+			line.pop_back();
+		if (!line.empty())
+			names.push_back(line);
+	}
+}
+
+std::string DefaultOutputPath(const std::string &mpqPath)
+{
+	const std::size_t dot = mpqPath.find_last_of('.');
+	const std::size_t slash = mpqPath.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return mpqPath + AssetPackExtension;
+	return mpqPath.substr(0, dot) + AssetPackExtension;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	if (argc != 3 && argc != 4) {
+		std::fprintf(stderr, "Usage: %s <listfile> <input.mpq> [output%s]\n", argv[0], AssetPackExtension);
+		return 2;
+	}
+	const char *listPath = argv[1];
+	const char *mpqPath = argv[2];
+	const std::string packPath = argc == 4 ? argv[3] : DefaultOutputPath(mpqPath);
+
+	std::vector<std::string> names;
+	std::ifstream list(listPath);
+	if (!list) {
+		std::fprintf(stderr, "Cannot open %s\n", listPath);
+		return 1;
+	}
+	AppendNames(list, names);
+
+	int32_t error = 0;
+	std::optional<MpqArchive> archive = MpqArchive::Open(mpqPath, error);
+	if (!archive) {
+		std::fprintf(stderr, "Cannot open %s: %s\n", mpqPath, error != 0 ? MpqArchive::ErrorMessage(error) : "not found");
+		return 1;
+	}
+
+	std::size_t internalListSize;
+	std::unique_ptr<byte[]> internalList = archive->ReadFile("(listfile)", internalListSize, error);
+	if (internalList != nullptr) {
+		std::string contents(reinterpret_cast<const char *>(internalList.get()), internalListSize);
+		std::istringstream in(contents);
+		AppendNames(in, names);
+	}
+
+	// The game does not fall back to the MPQ for files missing from the pack, so every file must be named
+	std::set<uint32_t> found;
+	std::vector<std::string> toPack;
+	for (const std::string &name : names) {
+		uint32_t fileNumber;
+		if (archive->GetFileNumber(MpqArchive::CalculateFileHash(name.c_str()), fileNumber) && found.insert(fileNumber).second)
+			toPack.push_back(name);
+	}
+	for (const char *name : InternalFiles) {
+		uint32_t fileNumber;
+		if (archive->GetFileNumber(MpqArchive::CalculateFileHash(name), fileNumber))
+			found.insert(fileNumber);
+	}
+	const uint32_t numFiles = archive->GetNumFiles(error);
+	if (error != 0) {
+		std::fprintf(stderr, "Cannot read %s: %s\n", mpqPath, MpqArchive::ErrorMessage(error));
+		return 1;
+	}
+	std::vector<uint32_t> unnamed;
+	for (uint32_t fileNumber = 0; fileNumber < numFiles; fileNumber++) {
+		if (found.count(fileNumber) == 0)
+			unnamed.push_back(fileNumber);
+	}
+	if (!unnamed.empty()) {
+		std::fprintf(stderr, "%s does not name %u of the %u files in %s, no pack written. Unnamed file numbers:",
+		    listPath, static_cast<unsigned>(unnamed.size()), static_cast<unsigned>(numFiles), mpqPath);
+		for (uint32_t fileNumber : unnamed)
+			std::fprintf(stderr, " %u", static_cast<unsigned>(fileNumber));
+		std::fprintf(stderr, "\n");
+		return 1;
+	}
+
+	// Taken before the files are read, so a pack made while the MPQ changes is stale
+	std::uintmax_t mpqSize;
+	std::int64_t mpqModified;
+	if (!GetFileStatus(mpqPath, &mpqSize, &mpqModified)) {
+		std::fprintf(stderr, "Cannot read the status of %s\n", mpqPath);
+		return 1;
+	}
+
+	AssetPackWriter writer;
+	if (!writer.Open(packPath.c_str())) {
+		std::fprintf(stderr, "Cannot create %s\n", packPath.c_str());
+		return 1;
+	}
+
+	std::size_t totalSize = 0;
+	for (const std::string &name : toPack) {
+		std::size_t size = 0;
+		std::unique_ptr<byte[]> data = archive->ReadFile(name.c_str(), size, error);
+		if (data == nullptr) {
+			std::fprintf(stderr, "Cannot read %s: %s\n", name.c_str(), MpqArchive::ErrorMessage(error));
+			return 1;
+		}
+		if (!writer.AddFile(MpqArchive::CalculateFileHash(name.c_str()), data.get(), size)) {
+			std::fprintf(stderr, "Cannot write %s to %s\n", name.c_str(), packPath.c_str());
+			return 1;
+		}
+		totalSize += size;
+	}
+
+	if (!writer.Finish({ mpqSize, mpqModified })) {
+		std::fprintf(stderr, "Cannot finish %s\n", packPath.c_str());
+		return 1;
+	}
+
+	std::printf("Packed %u files (%llu bytes) from %s into %s\n",
+	    static_cast<unsigned>(toPack.size()), static_cast<unsigned long long>(totalSize), mpqPath, packPath.c_str());
+	return 0;
+}
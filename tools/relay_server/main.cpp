@@ -0,0 +1,196 @@
+/**
+ * @file tools/relay_server/main.cpp
+ *
+ * devilutionx-relay: hosts TCP multiplayer games without running the game itself.
+ *
+ * Every game listens on its own port, counting up from --port. Players join it like
+ * any TCP game, with the port set under [Network] in their diablo.ini. A game starts
+ * over once its last player has left.
+ *
+ * All games share one io_context, run by a pool of threads.
+ */
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <asio/signal_set.hpp>
+#include <asio/steady_timer.hpp>
+#include <asio/ts/io_context.hpp>
+
+#include "dvlnet/packet.h"
+#include "dvlnet/tcp_server.h"
+#include "utils/log.hpp"
+
+namespace devilution {
+
+void app_fatal(const char *pszFmt, ...)
+{
+	va_list va;
+	va_start(va, pszFmt);
+	std::vfprintf(stderr, pszFmt, va);
+	va_end(va);
+	std::fputc('\n', stderr);
+	std::exit(1);
+}
+
+} // namespace devilution
+
+using namespace devilution;
+
+namespace {
+
+struct RelayOptions {
+	std::string bindAddress = "0.0.0.0";
+	unsigned short port = 6112;
+	int games = 1;
+	int threads = static_cast<int>(std::max(1U, std::thread::hardware_concurrency()));
+	std::string password;
+	int statsInterval = 60;
+};
+
+struct HostedGame {
+	unsigned short port;
+	std::unique_ptr<net::packet_factory> pktfty;
+	std::unique_ptr<net::tcp_server> server;
+};
+
+void PrintUsage(const char *program)
+{
+	std::fprintf(stderr,
+	    "Usage: %s [options]\n"
+	    "  --bind <address>     Address to listen on (default 0.0.0.0)\n"
+	    "  --port <port>        Port of the first game (default 6112)\n"
+	    "  --games <count>      Number of games to host, one port each (default 1)\n"
+	    "  --threads <count>    Network threads (default: one per CPU)\n"
+	    "  --password <text>    Password of the hosted games (default: public games)\n"
+	    "  --stats <seconds>    Interval between traffic reports, 0 to disable (default 60)\n",
+	    program);
+}
+
+bool ParseArguments(int argc, char **argv, RelayOptions &options)
+{
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		if (i + 1 == argc)
+			return false;
+		const char *value = argv[++i];
+		if (std::strcmp(arg, "--bind") == 0) {
+			options.bindAddress = value;
+		} else if (std::strcmp(arg, "--port") == 0) {
+			const int port = std::atoi(value);
+			if (port <= 0 || port > 65535)
+				return false;
+			options.port = static_cast<unsigned short>(port);
+		} else if (std::strcmp(arg, "--games") == 0) {
+			options.games = std::atoi(value);
+		} else if (std::strcmp(arg, "--threads") == 0) {
+			options.threads = std::atoi(value);
+		} else if (std::strcmp(arg, "--password") == 0) {
+			options.password = value;
+		} else if (std::strcmp(arg, "--stats") == 0) {
+			options.statsInterval = std::atoi(value);
+		} else {
+			return false;
+		}
+	}
+	return options.games > 0 && options.port + options.games - 1 <= 65535 && options.threads > 0 && options.statsInterval >= 0;
+}
+
+void LogStats(const std::vector<HostedGame> &games)
+{
+	for (const HostedGame &game : games) {
+		const net::tcp_server_stats stats = game.server->Stats();
+		if (stats.players == 0 && stats.packets_received == 0)
+			continue;
+		Log("Port {}: {} players, received {} packets ({} bytes), sent {} packets ({} bytes)",
+		    game.port, stats.players, stats.packets_received, stats.bytes_received, stats.packets_sent, stats.bytes_sent);
+	}
+}
+
+void StartStatsTimer(asio::steady_timer &timer, std::chrono::seconds interval, const std::vector<HostedGame> &games)
+{
+	timer.expires_after(interval);
+	timer.async_wait([&timer, interval, &games](const asio::error_code &ec) {
+		if (ec)
+			return;
+		LogStats(games);
+		StartStatsTimer(timer, interval, games);
+	});
+}
+
+void RunNetwork(asio::io_context &ioc)
+{
+	// A handler that throws only takes down the connection it was serving; its timeout drops it later
+	while (true) {
+		try {
+			ioc.run();
+			return;
+		} catch (const std::exception &e) {
+			Log("Network error: {}", e.what());
+		}
+	}
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	RelayOptions options;
+	if (!ParseArguments(argc, argv, options)) {
+		PrintUsage(argv[0]);
+		return 2;
+	}
+
+	asio::io_context ioc(options.threads);
+
+	std::vector<HostedGame> games;
+	games.reserve(options.games);
+	for (int i = 0; i < options.games; i++) {
+		HostedGame game;
+		game.port = static_cast<unsigned short>(options.port + i);
+		if (options.password.empty())
+			game.pktfty = std::make_unique<net::packet_factory>();
+		else
+			game.pktfty = std::make_unique<net::packet_factory>(options.password);
+		try {
+			game.server = std::make_unique<net::tcp_server>(ioc, options.bindAddress, game.port, *game.pktfty);
+		} catch (const std::system_error &e) {
+			std::fprintf(stderr, "Cannot listen on %s port %d: %s\n", options.bindAddress.c_str(), game.port, e.what());
+			return 1;
+		}
+		games.push_back(std::move(game));
+	}
+
+	asio::signal_set signals(ioc, SIGINT, SIGTERM);
+	signals.async_wait([&ioc](const asio::error_code &, int) {
+		ioc.stop();
+	});
+
+	asio::steady_timer statsTimer(ioc);
+	if (options.statsInterval > 0)
+		StartStatsTimer(statsTimer, std::chrono::seconds(options.statsInterval), games);
+
+	Log("Hosting {} games on ports {}-{} with {} threads", options.games, options.port, options.port + options.games - 1, options.threads);
+
+	std::vector<std::thread> pool;
+	for (int i = 1; i < options.threads; i++)
+		pool.emplace_back(RunNetwork, std::ref(ioc));
+	RunNetwork(ioc);
+	for (std::thread &thread : pool)
+		thread.join();
+
+	LogStats(games);
+	return 0;
+}